@@ -0,0 +1,170 @@
+#include "exprclient.h"
+
+#include <errno.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// helper static functions
+
+static int sendAll(int fd, struct iovec* parts, int partCount){
+	while(partCount > 0){
+		struct msghdr message = {.msg_iov = parts, .msg_iovlen = (size_t)partCount};
+		ssize_t sent = sendmsg(fd, &message, MSG_NOSIGNAL);
+		if(sent < 0){
+			if(errno == EINTR){
+				continue;
+			}
+			return -1;
+		}
+		while(partCount > 0 && (size_t)sent >= parts->iov_len){
+			sent -= (ssize_t)parts->iov_len;
+			parts++;
+			partCount--;
+		}
+		if(partCount > 0){
+			parts->iov_base = (uint8_t*)parts->iov_base + sent;
+			parts->iov_len -= (size_t)sent;
+		}
+	}
+	return 0;
+}
+
+static int receiveAll(int fd, void* buffer, size_t length){
+	uint8_t* at = buffer;
+	while(length > 0){
+		ssize_t received = recv(fd, at, length, 0);
+		if(received < 0 && errno == EINTR){
+			continue;
+		}
+		if(received <= 0){
+			return -1;
+		}
+		at += received;
+		length -= (size_t)received;
+	}
+	return 0;
+}
+
+static int sendRequest(ExprClient* client, uint16_t type, struct iovec* parts, int partCount, ExprMessageHeader* header){
+	uint32_t length = 0;
+	for(int part = 1; part < partCount; part++){
+		length += (uint32_t)parts[part].iov_len;
+	}
+	*header = (ExprMessageHeader){.length = length, .type = type, .reserved = 0, .requestId = client->nextRequestId++};
+	parts[0] = (struct iovec){.iov_base = header, .iov_len = sizeof(*header)};
+	return sendAll(client->fd, parts, partCount);
+}
+
+// reads the response header, a STATUS payload is stored into status right away
+static int receiveResponse(ExprClient* client, uint32_t requestId, ExprMessageHeader* header, ExprStatusResponse* status){
+	if(receiveAll(client->fd, header, sizeof(*header)) < 0 || header->requestId != requestId){
+		return -1;
+	}
+	if(header->type == EXPR_MESSAGE_STATUS){
+		if(header->length != sizeof(*status)){
+			return -1;
+		}
+		return receiveAll(client->fd, status, sizeof(*status));
+	}
+	return 0;
+}
+
+// extern functions
+
+int exprClientConnect(ExprClient* client, const char* socketPath){
+	client->nextRequestId = 1;
+	struct sockaddr_un address = {.sun_family = AF_UNIX};
+	if(strlen(socketPath) >= sizeof(address.sun_path)){
+		return -1;
+	}
+	strcpy(address.sun_path, socketPath);
+	client->fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if(client->fd < 0){
+		return -1;
+	}
+	if(connect(client->fd, (struct sockaddr*)&address, sizeof(address)) < 0){
+		close(client->fd);
+		client->fd = -1;
+		return -1;
+	}
+	return 0;
+}
+
+void exprClientClose(ExprClient* client){
+	if(client->fd >= 0){
+		close(client->fd);
+		client->fd = -1;
+	}
+}
+
+int exprClientCompile(ExprClient* client, uint32_t formulaId, const char* variableNames, const char* expression, ExprStatusResponse* status){
+	size_t variableCount = strlen(variableNames);
+	size_t expressionLength = strlen(expression);
+	if(variableCount > EXPR_DAEMON_MAX_VARIABLES || expressionLength > EXPR_DAEMON_MAX_EXPRESSION){
+		return -1;
+	}
+	ExprCompileRequest request = {.formulaId = formulaId, .variableCount = (uint8_t)variableCount, .reserved = 0, .expressionLength = (uint16_t)expressionLength};
+	struct iovec parts[4] = {
+		[1] = {.iov_base = &request, .iov_len = sizeof(request)},
+		[2] = {.iov_base = (void*)variableNames, .iov_len = variableCount},
+		[3] = {.iov_base = (void*)expression, .iov_len = expressionLength}
+	};
+	ExprMessageHeader header;
+	if(sendRequest(client, EXPR_MESSAGE_COMPILE, parts, 4, &header) < 0){
+		return -1;
+	}
+	uint32_t requestId = header.requestId;
+	if(receiveResponse(client, requestId, &header, status) < 0 || header.type != EXPR_MESSAGE_STATUS){
+		return -1;
+	}
+	return 0;
+}
+
+int exprClientEvaluate(ExprClient* client, uint32_t formulaId, uint8_t variableCount, const ValueType values[], uint32_t rowCount, ValueType results[], uint8_t faults[], ExprStatusResponse* status){
+	ExprEvaluateRequest request = {.formulaId = formulaId, .rowCount = rowCount, .variableCount = variableCount};
+	struct iovec parts[3] = {
+		[1] = {.iov_base = &request, .iov_len = sizeof(request)},
+		[2] = {.iov_base = (void*)values, .iov_len = (size_t)rowCount * variableCount * sizeof(ValueType)}
+	};
+	ExprMessageHeader header;
+	if(sendRequest(client, EXPR_MESSAGE_EVALUATE, parts, 3, &header) < 0){
+		return -1;
+	}
+	uint32_t requestId = header.requestId;
+	if(receiveResponse(client, requestId, &header, status) < 0){
+		return -1;
+	}
+	if(header.type == EXPR_MESSAGE_STATUS){
+		return 0;
+	}
+
+	ExprResultsResponse response;
+	if(header.type != EXPR_MESSAGE_RESULTS || receiveAll(client->fd, &response, sizeof(response)) < 0
+		|| response.rowCount != rowCount || header.length != sizeof(response) + rowCount * (sizeof(ValueType) + 1)){
+		return -1;
+	}
+	if(receiveAll(client->fd, results, (size_t)rowCount * sizeof(ValueType)) < 0 || receiveAll(client->fd, faults, rowCount) < 0){
+		return -1;
+	}
+	*status = (ExprStatusResponse){.status = EXPR_STATUS_OK, .detail = 0, .at = 0, .reserved = 0};
+	return 0;
+}
+
+int exprClientRemove(ExprClient* client, uint32_t formulaId, ExprStatusResponse* status){
+	ExprRemoveRequest request = {.formulaId = formulaId};
+	struct iovec parts[2] = {
+		[1] = {.iov_base = &request, .iov_len = sizeof(request)}
+	};
+	ExprMessageHeader header;
+	if(sendRequest(client, EXPR_MESSAGE_REMOVE, parts, 2, &header) < 0){
+		return -1;
+	}
+	uint32_t requestId = header.requestId;
+	if(receiveResponse(client, requestId, &header, status) < 0 || header.type != EXPR_MESSAGE_STATUS){
+		return -1;
+	}
+	return 0;
+}
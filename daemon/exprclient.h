@@ -0,0 +1,27 @@
+#ifndef EXPRCLIENT_H
+#define EXPRCLIENT_H
+
+#include "exprprotocol.h"
+#include <stdbool.h>
+
+// Blocking client of exprdaemon, one request in flight per ExprClient. Every call returns 0 when the
+// daemon answered, with its verdict in status, and -1 when the connection failed.
+
+typedef struct {
+	int fd;
+	uint32_t nextRequestId;
+} ExprClient;
+
+extern int exprClientConnect(ExprClient* client, const char* socketPath);
+extern void exprClientClose(ExprClient* client);
+
+// variableNames holds one character per variable, in the order evaluation rows supply their values
+extern int exprClientCompile(ExprClient* client, uint32_t formulaId, const char* variableNames, const char* expression, ExprStatusResponse* status);
+
+// values holds rowCount rows of variableCount values, results receives rowCount values and faults the
+// ArithmeticErrorMask of each row, 0 for every row that evaluated without fault
+extern int exprClientEvaluate(ExprClient* client, uint32_t formulaId, uint8_t variableCount, const ValueType values[], uint32_t rowCount, ValueType results[], uint8_t faults[], ExprStatusResponse* status);
+
+extern int exprClientRemove(ExprClient* client, uint32_t formulaId, ExprStatusResponse* status);
+
+#endif
@@ -0,0 +1,542 @@
+#define _GNU_SOURCE
+#include "exprprotocol.h"
+#include "../include/expressionparser.h"
+#include "../include/pipelineoptimizer.h"
+#include "../include/pipelinecost.h"
+#include "../include/pipelinechecked.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// Shares compiled pipelines between the processes of a host. The main thread runs the epoll loop,
+// accepts connections and reads requests, complete requests are handed to worker threads which
+// evaluate them and write the responses. Each connection is served by at most one worker at a time,
+// so responses keep the request order.
+//   exprdaemon [socket path] [worker count]
+
+#ifndef EXPR_DAEMON_MAX_FORMULAS
+#define EXPR_DAEMON_MAX_FORMULAS 1024
+#endif
+
+#ifndef EXPR_DAEMON_WORKERS
+#define EXPR_DAEMON_WORKERS 4
+#endif
+
+#define EXPR_DAEMON_MAX_EVENTS 64
+#define EXPR_DAEMON_READ_CHUNK 65536
+#define EXPR_DAEMON_MAX_MESSAGE (sizeof(ExprMessageHeader) + EXPR_DAEMON_MAX_PAYLOAD)
+
+// FORMULAS
+
+typedef enum {
+	FORMULA_EMPTY,
+	FORMULA_USED,
+	FORMULA_REMOVED
+} FormulaState;
+
+typedef struct {
+	FormulaState state;
+	uint32_t formulaId;
+	uint8_t variableCount;
+	char names[EXPR_DAEMON_MAX_VARIABLES];
+	PipelineVariant storage[NONE_INDEX];
+	Pipeline pipeline;
+	// client rows may divide by zero, formulas only run checked
+	CheckedPipeline checked;
+} Formula;
+
+// open addressing on formulaId, readers evaluate under the read lock
+static Formula formulas[EXPR_DAEMON_MAX_FORMULAS];
+static pthread_rwlock_t formulasLock = PTHREAD_RWLOCK_INITIALIZER;
+
+static uint32_t hashFormulaId(uint32_t formulaId){
+	return (formulaId * 0x9E3779B1u) % EXPR_DAEMON_MAX_FORMULAS;
+}
+
+static Formula* findFormula(uint32_t formulaId){
+	uint32_t at = hashFormulaId(formulaId);
+	for(uint32_t probe = 0; probe < EXPR_DAEMON_MAX_FORMULAS; probe++){
+		Formula* formula = &formulas[(at + probe) % EXPR_DAEMON_MAX_FORMULAS];
+		if(formula->state == FORMULA_EMPTY){
+			return NULL;
+		}
+		if(formula->state == FORMULA_USED && formula->formulaId == formulaId){
+			return formula;
+		}
+	}
+	return NULL;
+}
+
+static Formula* insertFormula(uint32_t formulaId){
+	Formula* existing = findFormula(formulaId);
+	if(existing != NULL){
+		return existing;
+	}
+	uint32_t at = hashFormulaId(formulaId);
+	for(uint32_t probe = 0; probe < EXPR_DAEMON_MAX_FORMULAS; probe++){
+		Formula* formula = &formulas[(at + probe) % EXPR_DAEMON_MAX_FORMULAS];
+		if(formula->state != FORMULA_USED){
+			formula->state = FORMULA_USED;
+			formula->formulaId = formulaId;
+			return formula;
+		}
+	}
+	return NULL;
+}
+
+// CONNECTIONS
+
+typedef struct Connection {
+	int fd;
+	pthread_mutex_t lock;
+	uint8_t* in;
+	size_t inLength;
+	size_t inCapacity;
+	uint8_t* out;
+	size_t outLength;
+	size_t outSent;
+	size_t outCapacity;
+	// waiting in the work queue or owned by a worker
+	bool queued;
+	bool closed;
+	bool writeWatched;
+	struct Connection* nextQueued;
+} Connection;
+
+static int epollFd;
+static volatile sig_atomic_t running = 1;
+
+static Connection* queueHead;
+static Connection* queueTail;
+static pthread_mutex_t queueLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t queueReady = PTHREAD_COND_INITIALIZER;
+
+static void enqueueConnection(Connection* connection){
+	pthread_mutex_lock(&queueLock);
+	connection->nextQueued = NULL;
+	if(queueTail != NULL){
+		queueTail->nextQueued = connection;
+	}
+	else {
+		queueHead = connection;
+	}
+	queueTail = connection;
+	pthread_cond_signal(&queueReady);
+	pthread_mutex_unlock(&queueLock);
+}
+
+static Connection* dequeueConnection(void){
+	pthread_mutex_lock(&queueLock);
+	while(queueHead == NULL){
+		pthread_cond_wait(&queueReady, &queueLock);
+	}
+	Connection* connection = queueHead;
+	queueHead = connection->nextQueued;
+	if(queueHead == NULL){
+		queueTail = NULL;
+	}
+	pthread_mutex_unlock(&queueLock);
+	return connection;
+}
+
+static void freeConnection(Connection* connection){
+	close(connection->fd);
+	pthread_mutex_destroy(&connection->lock);
+	free(connection->in);
+	free(connection->out);
+	free(connection);
+}
+
+// a complete message is buffered, malformed ones close the connection instead
+static bool hasMessage(const Connection* connection){
+	if(connection->inLength < sizeof(ExprMessageHeader)){
+		return false;
+	}
+	const ExprMessageHeader* header = (const ExprMessageHeader*)connection->in;
+	return connection->inLength >= sizeof(ExprMessageHeader) + header->length;
+}
+
+static bool reserveBuffer(uint8_t** buffer, size_t* capacity, size_t needed){
+	if(needed <= *capacity){
+		return true;
+	}
+	size_t grown = *capacity != 0 ? *capacity : 4096;
+	while(grown < needed){
+		grown *= 2;
+	}
+	uint8_t* resized = realloc(*buffer, grown);
+	if(resized == NULL){
+		return false;
+	}
+	*buffer = resized;
+	*capacity = grown;
+	return true;
+}
+
+static void watchWrites(Connection* connection, bool watch){
+	if(connection->writeWatched == watch){
+		return;
+	}
+	struct epoll_event event = {.events = EPOLLIN | EPOLLRDHUP | (watch ? EPOLLOUT : 0), .data.ptr = connection};
+	epoll_ctl(epollFd, EPOLL_CTL_MOD, connection->fd, &event);
+	connection->writeWatched = watch;
+}
+
+// called with the connection locked
+static void flushConnection(Connection* connection){
+	while(connection->outSent < connection->outLength){
+		ssize_t sent = send(connection->fd, connection->out + connection->outSent, connection->outLength - connection->outSent, MSG_NOSIGNAL);
+		if(sent < 0){
+			if(errno == EINTR){
+				continue;
+			}
+			if(errno != EAGAIN && errno != EWOULDBLOCK){
+				// the reader side notices the hang up and closes
+				connection->outSent = connection->outLength;
+			}
+			break;
+		}
+		connection->outSent += (size_t)sent;
+	}
+	if(connection->outSent == connection->outLength){
+		connection->outSent = 0;
+		connection->outLength = 0;
+	}
+	watchWrites(connection, connection->outLength != 0);
+}
+
+// called by the epoll thread with the connection locked
+static void closeConnection(Connection* connection){
+	epoll_ctl(epollFd, EPOLL_CTL_DEL, connection->fd, NULL);
+	connection->closed = true;
+	bool owned = connection->queued;
+	pthread_mutex_unlock(&connection->lock);
+	if(!owned){
+		freeConnection(connection);
+	}
+}
+
+// REQUESTS
+
+typedef struct {
+	uint8_t* response;
+	PipelineVariable variables[EXPR_DAEMON_MAX_VARIABLES];
+	PipelineStack stack;
+} Worker;
+
+static uint32_t writeStatus(uint8_t* payload, ExprStatus status, uint16_t detail, uint16_t at){
+	ExprStatusResponse response = {.status = status, .detail = detail, .at = at, .reserved = 0};
+	memcpy(payload, &response, sizeof(response));
+	return sizeof(response);
+}
+
+static uint32_t handleCompile(const uint8_t* payload, uint32_t length, uint8_t* response){
+	ExprCompileRequest request;
+	if(length < sizeof(request)){
+		return writeStatus(response, EXPR_STATUS_MALFORMED, 0, 0);
+	}
+	memcpy(&request, payload, sizeof(request));
+	if(request.variableCount > EXPR_DAEMON_MAX_VARIABLES || request.expressionLength > EXPR_DAEMON_MAX_EXPRESSION
+		|| length != sizeof(request) + request.variableCount + request.expressionLength){
+		return writeStatus(response, EXPR_STATUS_MALFORMED, 0, 0);
+	}
+	const char* names = (const char*)payload + sizeof(request);
+	char expression[EXPR_DAEMON_MAX_EXPRESSION + 1];
+	memcpy(expression, names + request.variableCount, request.expressionLength);
+	expression[request.expressionLength] = '\0';
+
+	// compiled outside the lock, published by copying into the formula slot
+	PipelineVariable variables[EXPR_DAEMON_MAX_VARIABLES];
+	for(uint8_t varIdx = 0; varIdx < request.variableCount; varIdx++){
+		variables[varIdx] = (PipelineVariable){.name = names[varIdx], .value = 0};
+	}
+	PipelineVariant storage[NONE_INDEX];
+	Pipeline pipeline = CREATE_PIPELINE_FROM_CONST_STORAGE(storage);
+	PeekableStringSlice input = {.slice = makeSliceFromString(expression), .cursor = 0, .context = NULL};
+	PipelineVariablesSlice slice = {variables, (int8_t)request.variableCount};
+	PipelineCost budget = {.cycles = 0, .stackBytes = 0, .maxStackDepth = PIPELINE_STACK_SIZE};
+	ParsingError err = compileExpressionWithBudget(&pipeline, &input, slice, &pipelineCostX86, budget);
+	if(err.type != NOERROR){
+		return writeStatus(response, EXPR_STATUS_PARSING_ERROR, (uint16_t)err.type, err.at);
+	}
+	foldConstantsPipeline(&pipeline);
+	strengthReducePipeline(&pipeline);
+
+	pthread_rwlock_wrlock(&formulasLock);
+	Formula* formula = insertFormula(request.formulaId);
+	if(formula != NULL){
+		formula->variableCount = request.variableCount;
+		memcpy(formula->names, names, request.variableCount);
+		memcpy(formula->storage, storage, sizeof(PipelineVariant) * lengthOfPipeline(&pipeline));
+		formula->pipeline = pipeline;
+		formula->pipeline.entries = formula->storage;
+		prepareCheckedPipeline(&formula->checked, &formula->pipeline, ARITHMETIC_WRAPPING, NULL);
+	}
+	pthread_rwlock_unlock(&formulasLock);
+	return writeStatus(response, formula != NULL ? EXPR_STATUS_OK : EXPR_STATUS_FORMULAS_FULL, 0, 0);
+}
+
+static uint32_t handleEvaluate(Worker* worker, const uint8_t* payload, uint32_t length, uint8_t* response, uint16_t* responseType){
+	*responseType = EXPR_MESSAGE_STATUS;
+	ExprEvaluateRequest request;
+	if(length < sizeof(request)){
+		return writeStatus(response, EXPR_STATUS_MALFORMED, 0, 0);
+	}
+	memcpy(&request, payload, sizeof(request));
+	uint64_t valueCount = (uint64_t)request.rowCount * request.variableCount;
+	if(length != sizeof(request) + valueCount * sizeof(ValueType)
+		|| sizeof(ExprResultsResponse) + (uint64_t)request.rowCount * (sizeof(ValueType) + 1) > EXPR_DAEMON_MAX_PAYLOAD){
+		return writeStatus(response, EXPR_STATUS_MALFORMED, 0, 0);
+	}
+
+	pthread_rwlock_rdlock(&formulasLock);
+	const Formula* formula = findFormula(request.formulaId);
+	if(formula == NULL || formula->variableCount != request.variableCount){
+		pthread_rwlock_unlock(&formulasLock);
+		return writeStatus(response, formula == NULL ? EXPR_STATUS_UNKNOWN_FORMULA : EXPR_STATUS_VARIABLE_MISMATCH, 0, 0);
+	}
+
+	uint8_t variableCount = request.variableCount;
+	for(uint8_t varIdx = 0; varIdx < variableCount; varIdx++){
+		worker->variables[varIdx].name = formula->names[varIdx];
+	}
+	PipelineVariablesSlice slice = {worker->variables, (int8_t)variableCount};
+	const uint8_t* values = payload + sizeof(request);
+	uint8_t* results = response + sizeof(ExprResultsResponse);
+	uint8_t* faults = results + (size_t)request.rowCount * sizeof(ValueType);
+	uint32_t faultedRows = 0;
+	for(uint32_t row = 0; row < request.rowCount; row++){
+		for(uint8_t varIdx = 0; varIdx < variableCount; varIdx++){
+			memcpy(&worker->variables[varIdx].value, values + ((size_t)row * variableCount + varIdx) * sizeof(ValueType), sizeof(ValueType));
+		}
+		uint8_t rowFaults = ARITHMETIC_NO_ERROR;
+		ValueType result = executeCheckedPipeline(&formula->checked, &worker->stack, slice, &rowFaults);
+		memcpy(results + (size_t)row * sizeof(ValueType), &result, sizeof(ValueType));
+		faults[row] = rowFaults;
+		faultedRows += rowFaults != ARITHMETIC_NO_ERROR;
+	}
+	pthread_rwlock_unlock(&formulasLock);
+
+	ExprResultsResponse header = {.rowCount = request.rowCount, .faultedRows = faultedRows};
+	memcpy(response, &header, sizeof(header));
+	*responseType = EXPR_MESSAGE_RESULTS;
+	return sizeof(header) + request.rowCount * (sizeof(ValueType) + 1);
+}
+
+static uint32_t handleRemove(const uint8_t* payload, uint32_t length, uint8_t* response){
+	ExprRemoveRequest request;
+	if(length != sizeof(request)){
+		return writeStatus(response, EXPR_STATUS_MALFORMED, 0, 0);
+	}
+	memcpy(&request, payload, sizeof(request));
+	pthread_rwlock_wrlock(&formulasLock);
+	Formula* formula = findFormula(request.formulaId);
+	if(formula != NULL){
+		formula->state = FORMULA_REMOVED;
+	}
+	pthread_rwlock_unlock(&formulasLock);
+	return writeStatus(response, formula != NULL ? EXPR_STATUS_OK : EXPR_STATUS_UNKNOWN_FORMULA, 0, 0);
+}
+
+// returns the response type, the payload is written after the response header
+static uint16_t handleMessage(Worker* worker, const ExprMessageHeader* header, const uint8_t* payload, uint32_t* responseLength){
+	uint8_t* response = worker->response + sizeof(ExprMessageHeader);
+	switch (header->type)
+	{
+		case EXPR_MESSAGE_COMPILE:
+			*responseLength = handleCompile(payload, header->length, response);
+			return EXPR_MESSAGE_STATUS;
+		case EXPR_MESSAGE_EVALUATE:
+			{
+				uint16_t responseType;
+				*responseLength = handleEvaluate(worker, payload, header->length, response, &responseType);
+				return responseType;
+			}
+		case EXPR_MESSAGE_REMOVE:
+			*responseLength = handleRemove(payload, header->length, response);
+			return EXPR_MESSAGE_STATUS;
+		default:
+			*responseLength = writeStatus(response, EXPR_STATUS_MALFORMED, 0, 0);
+			return EXPR_MESSAGE_STATUS;
+	}
+}
+
+static void* runWorker(void* arg){
+	Worker* worker = arg;
+	uint8_t* request = malloc(EXPR_DAEMON_MAX_MESSAGE);
+	worker->response = malloc(EXPR_DAEMON_MAX_MESSAGE);
+	if(request == NULL || worker->response == NULL){
+		fprintf(stderr, "exprdaemon: out of memory\n");
+		exit(1);
+	}
+	for(;;){
+		Connection* connection = dequeueConnection();
+		pthread_mutex_lock(&connection->lock);
+		while(!connection->closed && hasMessage(connection)){
+			ExprMessageHeader header;
+			memcpy(&header, connection->in, sizeof(header));
+			size_t messageLength = sizeof(header) + header.length;
+			memcpy(request, connection->in, messageLength);
+			connection->inLength -= messageLength;
+			memmove(connection->in, connection->in + messageLength, connection->inLength);
+			pthread_mutex_unlock(&connection->lock);
+
+			uint32_t responseLength;
+			uint16_t responseType = handleMessage(worker, &header, request + sizeof(header), &responseLength);
+			ExprMessageHeader responseHeader = {.length = responseLength, .type = responseType, .reserved = 0, .requestId = header.requestId};
+			memcpy(worker->response, &responseHeader, sizeof(responseHeader));
+
+			pthread_mutex_lock(&connection->lock);
+			size_t total = sizeof(responseHeader) + responseLength;
+			if(!connection->closed && reserveBuffer(&connection->out, &connection->outCapacity, connection->outLength + total)){
+				memcpy(connection->out + connection->outLength, worker->response, total);
+				connection->outLength += total;
+				flushConnection(connection);
+			}
+		}
+		connection->queued = false;
+		bool closed = connection->closed;
+		pthread_mutex_unlock(&connection->lock);
+		if(closed){
+			freeConnection(connection);
+		}
+	}
+	return NULL;
+}
+
+// EVENT LOOP
+
+static void acceptConnections(int listenFd){
+	for(;;){
+		int fd = accept4(listenFd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+		if(fd < 0){
+			return;
+		}
+		Connection* connection = calloc(1, sizeof(Connection));
+		if(connection == NULL){
+			close(fd);
+			continue;
+		}
+		connection->fd = fd;
+		pthread_mutex_init(&connection->lock, NULL);
+		struct epoll_event event = {.events = EPOLLIN | EPOLLRDHUP, .data.ptr = connection};
+		if(epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event) < 0){
+			freeConnection(connection);
+		}
+	}
+}
+
+static void readConnection(Connection* connection){
+	pthread_mutex_lock(&connection->lock);
+	for(;;){
+		// clients wait for their responses, this much unanswered input is abuse
+		if(connection->inLength > 2 * EXPR_DAEMON_MAX_MESSAGE){
+			closeConnection(connection);
+			return;
+		}
+		if(!reserveBuffer(&connection->in, &connection->inCapacity, connection->inLength + EXPR_DAEMON_READ_CHUNK)){
+			closeConnection(connection);
+			return;
+		}
+		ssize_t received = recv(connection->fd, connection->in + connection->inLength, EXPR_DAEMON_READ_CHUNK, 0);
+		if(received > 0){
+			connection->inLength += (size_t)received;
+			continue;
+		}
+		if(received < 0 && errno == EINTR){
+			continue;
+		}
+		if(received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)){
+			break;
+		}
+		closeConnection(connection);
+		return;
+	}
+
+	if(connection->inLength >= sizeof(ExprMessageHeader)){
+		const ExprMessageHeader* header = (const ExprMessageHeader*)connection->in;
+		if(header->length > EXPR_DAEMON_MAX_PAYLOAD){
+			closeConnection(connection);
+			return;
+		}
+	}
+	if(!connection->queued && hasMessage(connection)){
+		connection->queued = true;
+		enqueueConnection(connection);
+	}
+	pthread_mutex_unlock(&connection->lock);
+}
+
+static void stopRunning(int signal){
+	(void)signal;
+	running = 0;
+}
+
+int main(int argc, char** argv){
+	const char* socketPath = argc > 1 ? argv[1] : EXPR_DAEMON_SOCKET_PATH;
+	int workerCount = argc > 2 ? atoi(argv[2]) : EXPR_DAEMON_WORKERS;
+	if(workerCount <= 0){
+		workerCount = EXPR_DAEMON_WORKERS;
+	}
+
+	int listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	struct sockaddr_un address = {.sun_family = AF_UNIX};
+	if(listenFd < 0 || strlen(socketPath) >= sizeof(address.sun_path)){
+		fprintf(stderr, "exprdaemon: cannot create socket %s\n", socketPath);
+		return 1;
+	}
+	strcpy(address.sun_path, socketPath);
+	unlink(socketPath);
+	if(bind(listenFd, (struct sockaddr*)&address, sizeof(address)) < 0 || listen(listenFd, SOMAXCONN) < 0){
+		perror("exprdaemon: bind");
+		return 1;
+	}
+
+	epollFd = epoll_create1(EPOLL_CLOEXEC);
+	struct epoll_event listenEvent = {.events = EPOLLIN, .data.ptr = NULL};
+	epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &listenEvent);
+
+	struct sigaction action = {.sa_handler = stopRunning};
+	sigaction(SIGINT, &action, NULL);
+	sigaction(SIGTERM, &action, NULL);
+	signal(SIGPIPE, SIG_IGN);
+
+	Worker* workers = calloc((size_t)workerCount, sizeof(Worker));
+	for(int workerIdx = 0; workerIdx < workerCount; workerIdx++){
+		pthread_t thread;
+		pthread_create(&thread, NULL, runWorker, &workers[workerIdx]);
+		pthread_detach(thread);
+	}
+	fprintf(stderr, "exprdaemon: listening on %s with %d workers\n", socketPath, workerCount);
+
+	struct epoll_event events[EXPR_DAEMON_MAX_EVENTS];
+	while(running){
+		int eventCount = epoll_wait(epollFd, events, EXPR_DAEMON_MAX_EVENTS, -1);
+		for(int eventIdx = 0; eventIdx < eventCount; eventIdx++){
+			Connection* connection = events[eventIdx].data.ptr;
+			if(connection == NULL){
+				acceptConnections(listenFd);
+				continue;
+			}
+			if(events[eventIdx].events & EPOLLOUT){
+				pthread_mutex_lock(&connection->lock);
+				flushConnection(connection);
+				pthread_mutex_unlock(&connection->lock);
+			}
+			if(events[eventIdx].events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)){
+				readConnection(connection);
+			}
+		}
+	}
+
+	unlink(socketPath);
+	return 0;
+}
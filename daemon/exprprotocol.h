@@ -0,0 +1,82 @@
+#ifndef EXPRPROTOCOL_H
+#define EXPRPROTOCOL_H
+
+#include "../include/execpipeline.h"
+#include <inttypes.h>
+
+// Wire format of exprdaemon. Every message is an ExprMessageHeader followed by length payload bytes,
+// all fields in host byte order since both ends run on the same host. Requests on one connection are
+// answered in order, the response carries the requestId of its request.
+
+#ifndef EXPR_DAEMON_SOCKET_PATH
+#define EXPR_DAEMON_SOCKET_PATH "/tmp/exprdaemon.sock"
+#endif
+
+#define EXPR_DAEMON_MAX_PAYLOAD (1u << 20)
+#define EXPR_DAEMON_MAX_VARIABLES 32
+#define EXPR_DAEMON_MAX_EXPRESSION 1024
+
+typedef enum {
+	EXPR_MESSAGE_COMPILE = 1,
+	EXPR_MESSAGE_EVALUATE = 2,
+	EXPR_MESSAGE_REMOVE = 3,
+	EXPR_MESSAGE_STATUS = 0x81,
+	EXPR_MESSAGE_RESULTS = 0x82
+} ExprMessageType;
+
+typedef enum {
+	EXPR_STATUS_OK = 0,
+	// detail holds the ParsingErrorType and at its position in the expression
+	EXPR_STATUS_PARSING_ERROR,
+	EXPR_STATUS_UNKNOWN_FORMULA,
+	EXPR_STATUS_FORMULAS_FULL,
+	EXPR_STATUS_VARIABLE_MISMATCH,
+	EXPR_STATUS_MALFORMED
+} ExprStatus;
+
+typedef struct {
+	uint32_t length;
+	uint16_t type;
+	uint16_t reserved;
+	uint32_t requestId;
+} ExprMessageHeader;
+
+// COMPILE, followed by variableCount single character variable names and the expression text,
+// replaces a formula already registered under formulaId. Answered with STATUS.
+typedef struct {
+	uint32_t formulaId;
+	uint8_t variableCount;
+	uint8_t reserved;
+	uint16_t expressionLength;
+} ExprCompileRequest;
+
+// EVALUATE, followed by rowCount * variableCount values, row major in the order of the compiled
+// variable names. Answered with RESULTS, or STATUS when the request cannot be evaluated.
+typedef struct {
+	uint32_t formulaId;
+	uint32_t rowCount;
+	uint8_t variableCount;
+	uint8_t reserved[3];
+} ExprEvaluateRequest;
+
+// REMOVE, answered with STATUS.
+typedef struct {
+	uint32_t formulaId;
+} ExprRemoveRequest;
+
+typedef struct {
+	uint16_t status;
+	uint16_t detail;
+	uint16_t at;
+	uint16_t reserved;
+} ExprStatusResponse;
+
+// RESULTS, followed by rowCount values and rowCount fault bytes. Rows run checked, a fault byte holds
+// the ArithmeticErrorMask (pipelinechecked.h) of its row, a row dividing by zero gives 0 and reports
+// ARITHMETIC_DIVISION_BY_ZERO instead of taking the daemon down. faultedRows counts the rows with faults.
+typedef struct {
+	uint32_t rowCount;
+	uint32_t faultedRows;
+} ExprResultsResponse;
+
+#endif
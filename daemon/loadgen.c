@@ -0,0 +1,178 @@
+#include "exprclient.h"
+#include "../include/pipelinechecked.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// Load generator of exprdaemon, every thread holds one connection and sends batched evaluation
+// requests back to back for the given duration. Reports request and row throughput and latency percentiles.
+// Before the load, rows dividing by zero and INT32_MIN by -1 must come back as faults of their row.
+//   loadgen [socket path] [threads] [seconds] [rows per request]
+
+#define LOADGEN_FORMULA_ID 1
+#define LOADGEN_FAULT_FORMULA_ID 2
+#define LOADGEN_VARIABLES "xyz"
+#define LOADGEN_VARIABLE_COUNT 3
+#define LOADGEN_MAX_SAMPLES (1u << 22)
+
+typedef struct {
+	const char* socketPath;
+	uint32_t rowCount;
+	double seconds;
+	uint64_t* latencies;
+	size_t latencyCount;
+	uint64_t requests;
+	uint64_t mismatches;
+	bool failed;
+} LoadThread;
+
+static uint64_t nowNanoseconds(void){
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+}
+
+static ValueType expectedResult(const ValueType row[]){
+	return row[0] * row[1] + row[2] / 3 - (row[0] > row[2] ? row[0] : row[2]);
+}
+
+static void* runLoadThread(void* arg){
+	LoadThread* thread = arg;
+	ExprClient client;
+	if(exprClientConnect(&client, thread->socketPath) < 0){
+		thread->failed = true;
+		return NULL;
+	}
+	ValueType* values = malloc(sizeof(ValueType) * thread->rowCount * LOADGEN_VARIABLE_COUNT);
+	ValueType* results = malloc(sizeof(ValueType) * thread->rowCount);
+	uint8_t* faults = malloc(thread->rowCount);
+	for(uint32_t valueIdx = 0; valueIdx < thread->rowCount * LOADGEN_VARIABLE_COUNT; valueIdx++){
+		values[valueIdx] = rand() % 2000 - 1000;
+	}
+
+	uint64_t end = nowNanoseconds() + (uint64_t)(thread->seconds * 1e9);
+	for(uint64_t begin = nowNanoseconds(); begin < end; begin = nowNanoseconds()){
+		ExprStatusResponse status;
+		if(exprClientEvaluate(&client, LOADGEN_FORMULA_ID, LOADGEN_VARIABLE_COUNT, values, thread->rowCount, results, faults, &status) < 0 || status.status != EXPR_STATUS_OK){
+			thread->failed = true;
+			break;
+		}
+		uint64_t latency = nowNanoseconds() - begin;
+		if(thread->latencyCount < LOADGEN_MAX_SAMPLES){
+			thread->latencies[thread->latencyCount++] = latency;
+		}
+		if(thread->requests++ == 0){
+			for(uint32_t row = 0; row < thread->rowCount; row++){
+				thread->mismatches += results[row] != expectedResult(&values[row * LOADGEN_VARIABLE_COUNT]) || faults[row] != ARITHMETIC_NO_ERROR;
+			}
+		}
+	}
+	free(values);
+	free(results);
+	free(faults);
+	exprClientClose(&client);
+	return NULL;
+}
+
+// one client must not be able to take the daemon down for all others, faulting rows are reported
+// per row and the rows around them still evaluate
+static bool checkFaultingRows(ExprClient* client){
+	static const ValueType values[] = {7, 0, INT32_MIN, -1, 7, 2};
+	static const ValueType expected[] = {0, INT32_MIN, 3};
+	static const uint8_t expectedFaults[] = {ARITHMETIC_DIVISION_BY_ZERO, ARITHMETIC_OVERFLOW, ARITHMETIC_NO_ERROR};
+	ValueType results[ARRAY_CONST_SIZE(expected)];
+	uint8_t faults[ARRAY_CONST_SIZE(expected)];
+	ExprStatusResponse status;
+	if(exprClientCompile(client, LOADGEN_FAULT_FORMULA_ID, "xy", "x/y", &status) < 0 || status.status != EXPR_STATUS_OK
+		|| exprClientEvaluate(client, LOADGEN_FAULT_FORMULA_ID, 2, values, ARRAY_CONST_SIZE(expected), results, faults, &status) < 0 || status.status != EXPR_STATUS_OK){
+		return false;
+	}
+	for(uint8_t row = 0; row < ARRAY_CONST_SIZE(expected); row++){
+		if(results[row] != expected[row] || faults[row] != expectedFaults[row]){
+			return false;
+		}
+	}
+	return exprClientRemove(client, LOADGEN_FAULT_FORMULA_ID, &status) == 0 && status.status == EXPR_STATUS_OK;
+}
+
+static int compareLatencies(const void* left, const void* right){
+	uint64_t leftLatency = *(const uint64_t*)left;
+	uint64_t rightLatency = *(const uint64_t*)right;
+	return (leftLatency > rightLatency) - (leftLatency < rightLatency);
+}
+
+int main(int argc, char** argv){
+	const char* socketPath = argc > 1 ? argv[1] : EXPR_DAEMON_SOCKET_PATH;
+	int threadCount = argc > 2 ? atoi(argv[2]) : 4;
+	double seconds = argc > 3 ? atof(argv[3]) : 2.0;
+	uint32_t rowCount = argc > 4 ? (uint32_t)atoi(argv[4]) : 64;
+	if(threadCount <= 0 || rowCount == 0 || rowCount * LOADGEN_VARIABLE_COUNT * sizeof(ValueType) > EXPR_DAEMON_MAX_PAYLOAD / 2){
+		fprintf(stderr, "loadgen: bad arguments\n");
+		return 1;
+	}
+
+	ExprClient client;
+	ExprStatusResponse status;
+	if(exprClientConnect(&client, socketPath) < 0
+		|| exprClientCompile(&client, LOADGEN_FORMULA_ID, LOADGEN_VARIABLES, "x*y + z/3 - (x > z ? x : z)", &status) < 0){
+		fprintf(stderr, "loadgen: cannot reach exprdaemon on %s\n", socketPath);
+		return 1;
+	}
+	if(status.status != EXPR_STATUS_OK){
+		fprintf(stderr, "loadgen: compile failed, status %u detail %u at %u\n", status.status, status.detail, status.at);
+		return 1;
+	}
+	if(!checkFaultingRows(&client)){
+		fprintf(stderr, "loadgen: FAILED: rows dividing by zero did not come back as faults\n");
+		return 1;
+	}
+	exprClientClose(&client);
+
+	LoadThread* threads = calloc((size_t)threadCount, sizeof(LoadThread));
+	pthread_t* handles = calloc((size_t)threadCount, sizeof(pthread_t));
+	uint64_t begin = nowNanoseconds();
+	for(int threadIdx = 0; threadIdx < threadCount; threadIdx++){
+		threads[threadIdx] = (LoadThread){.socketPath = socketPath, .rowCount = rowCount, .seconds = seconds};
+		threads[threadIdx].latencies = malloc(sizeof(uint64_t) * LOADGEN_MAX_SAMPLES);
+		pthread_create(&handles[threadIdx], NULL, runLoadThread, &threads[threadIdx]);
+	}
+
+	size_t sampleCount = 0;
+	uint64_t requests = 0;
+	uint64_t mismatches = 0;
+	bool failed = false;
+	for(int threadIdx = 0; threadIdx < threadCount; threadIdx++){
+		pthread_join(handles[threadIdx], NULL);
+		sampleCount += threads[threadIdx].latencyCount;
+		requests += threads[threadIdx].requests;
+		mismatches += threads[threadIdx].mismatches;
+		failed = failed || threads[threadIdx].failed;
+	}
+	double elapsed = (double)(nowNanoseconds() - begin) / 1e9;
+
+	uint64_t* latencies = malloc(sizeof(uint64_t) * (sampleCount + 1));
+	size_t merged = 0;
+	for(int threadIdx = 0; threadIdx < threadCount; threadIdx++){
+		for(size_t sample = 0; sample < threads[threadIdx].latencyCount; sample++){
+			latencies[merged++] = threads[threadIdx].latencies[sample];
+		}
+	}
+	qsort(latencies, sampleCount, sizeof(uint64_t), compareLatencies);
+	if(sampleCount == 0){
+		fprintf(stderr, "loadgen: no request completed\n");
+		return 1;
+	}
+
+	printf("threads %d rows/request %u duration %.2f s\n", threadCount, rowCount, elapsed);
+	printf("requests %" PRIu64 " (%.0f/s) rows %.0f/s\n", requests, (double)requests / elapsed, (double)requests * rowCount / elapsed);
+	printf("latency us p50 %.1f p99 %.1f p99.9 %.1f max %.1f\n",
+		latencies[sampleCount / 2] / 1e3, latencies[sampleCount * 99 / 100] / 1e3,
+		latencies[sampleCount * 999 / 1000] / 1e3, latencies[sampleCount - 1] / 1e3);
+	if(failed || mismatches != 0){
+		printf("FAILED: %" PRIu64 " mismatching rows%s\n", mismatches, failed ? ", transport or status errors" : "");
+		return 1;
+	}
+	return 0;
+}
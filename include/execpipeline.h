@@ -25,7 +25,8 @@ typedef int32_t ValueType;
 typedef enum StackErrorMask {
 	NO_ERROR = 0x00,
 	OVERFLOW = 0x01,
-	POP_ON_EMPTY = 0x02
+	POP_ON_EMPTY = 0x02,
+	NO_DERIVATIVE = 0x04
 	
 } StackErrorMask;
 
@@ -53,39 +54,146 @@ typedef enum {
 	OPERATION_NATIVE_MUL,
 	OPERATION_NATIVE_DIV,
 	OPERATION_NATIVE_MOD,
+	// SUB/DIV/MOD with swapped operands, the left operand is the top of the stack
+	OPERATION_NATIVE_RSUB,
+	OPERATION_NATIVE_RDIV,
+	OPERATION_NATIVE_RMOD,
+	// ADD..MOD in int16_t arithmetic, only emitted where narrowPipeline proved operands and result fit
+	OPERATION_NATIVE_ADD16,
+	OPERATION_NATIVE_SUB16,
+	OPERATION_NATIVE_MUL16,
+	OPERATION_NATIVE_DIV16,
+	OPERATION_NATIVE_MOD16,
 //	OPERATION_NATIVE_ABS,
+	// strength reduced forms of MUL/DIV/MOD by a constant, operand is the top of the stack, the magic
+	// forms take their magic number as a second operand pushed by a CONSTANT step
+	OPERATION_NATIVE_SHL,
+	OPERATION_NATIVE_DIV_POW2,
+	OPERATION_NATIVE_MOD_POW2,
+	OPERATION_NATIVE_DIV_MAGIC,
+	OPERATION_NATIVE_MOD_MAGIC,
+	// comparisons produce 0 or 1, BOOL normalizes the top of the stack to 0 or 1
+	OPERATION_NATIVE_LT,
+	OPERATION_NATIVE_LE,
+	OPERATION_NATIVE_GT,
+	OPERATION_NATIVE_GE,
+	OPERATION_NATIVE_EQ,
+	OPERATION_NATIVE_NE,
+	OPERATION_NATIVE_BOOL,
+	// forward jumps to asJumpTarget, used by ?: (JUMP_IF_ZERO, JUMP) and short circuit && and ||,
+	// the *_OR_POP forms keep the tested value on the stack when jumping and pop it otherwise
+	JUMP,
+	JUMP_IF_ZERO,
+	JUMP_IF_ZERO_OR_POP,
+	JUMP_IF_NONZERO_OR_POP,
     CONSTANT,
     VARIABLE_INDEX,
     OPERATION,
 	NONE
 } PipelineVariantType;
 
+#define PIPELINE_VARIANT_TYPE_COUNT (NONE + 1)
+
 #define OPERATION_NATIVE_ADD_ARGCOUNT (2)
 #define OPERATION_NATIVE_SUB_ARGCOUNT (2)
 #define OPERATION_NATIVE_MUL_ARGCOUNT (2)
 #define OPERATION_NATIVE_DIV_ARGCOUNT (2)
 #define OPERATION_NATIVE_MOD_ARGCOUNT (2)
+#define OPERATION_NATIVE_RSUB_ARGCOUNT (2)
+#define OPERATION_NATIVE_RDIV_ARGCOUNT (2)
+#define OPERATION_NATIVE_RMOD_ARGCOUNT (2)
+#define OPERATION_NATIVE_ADD16_ARGCOUNT (2)
+#define OPERATION_NATIVE_SUB16_ARGCOUNT (2)
+#define OPERATION_NATIVE_MUL16_ARGCOUNT (2)
+#define OPERATION_NATIVE_DIV16_ARGCOUNT (2)
+#define OPERATION_NATIVE_MOD16_ARGCOUNT (2)
 //#define OPERATION_NATIVE_ABS_ARGCOUNT (1)
-
-
-typedef ValueType (*PipelineOperation)(PipelineStack* stack);
+#define OPERATION_NATIVE_SHL_ARGCOUNT (1)
+#define OPERATION_NATIVE_DIV_POW2_ARGCOUNT (1)
+#define OPERATION_NATIVE_MOD_POW2_ARGCOUNT (1)
+#define OPERATION_NATIVE_DIV_MAGIC_ARGCOUNT (2)
+#define OPERATION_NATIVE_MOD_MAGIC_ARGCOUNT (2)
+#define OPERATION_NATIVE_LT_ARGCOUNT (2)
+#define OPERATION_NATIVE_LE_ARGCOUNT (2)
+#define OPERATION_NATIVE_GT_ARGCOUNT (2)
+#define OPERATION_NATIVE_GE_ARGCOUNT (2)
+#define OPERATION_NATIVE_EQ_ARGCOUNT (2)
+#define OPERATION_NATIVE_NE_ARGCOUNT (2)
+#define OPERATION_NATIVE_BOOL_ARGCOUNT (1)
+
+
+// Registered operation, the last argument arrives by value in `last` (the cached top of the stack),
+// the argCount - 1 arguments before it in args[]. Operations without arguments get last = 0.
+typedef ValueType (*PipelineOperation)(const ValueType args[], ValueType last);
 typedef ValueType Constant;
 typedef Index VariableIndex;
 
+// Precomputed constant divisor of the strength reduced opcodes (Hacker's Delight, signed magic numbers).
+// SHL, DIV_POW2 and MOD_POW2 only use shift, DIV_POW2 negates the quotient when sign is negative.
+// DIV_MAGIC and MOD_MAGIC add (sign > 0) or subtract (sign < 0) the dividend from the high product,
+// MOD_MAGIC additionally needs the original divisor to compute the remainder. The 32 bit magic number
+// itself lives in the CONSTANT step before them so a step stays no larger than a constant.
+typedef struct {
+	int16_t divisor;
+	uint8_t shift;
+	int8_t sign;
+} ConstantDivisor;
+
 typedef struct {
     PipelineVariantType type;
     union{
         Constant asConstant;
         VariableIndex asVariableIndex;
-        PipelineOperation asOperation;
+        struct {
+            PipelineOperation asOperation;
+            uint8_t asOperationArgCount;
+        };
+        ConstantDivisor asDivisor;
+        Index asJumpTarget;
     };
 } PipelineVariant;
 
 extern PipelineVariant makeStepAsConstant(ValueType value);
 extern PipelineVariant makeStepAsVariableIndex(Index value);
-extern PipelineVariant makeStepAsOperation(PipelineOperation value);
+extern PipelineVariant makeStepAsOperation(PipelineOperation value, uint8_t argCount);
+extern PipelineVariant makeStepAsDivisor(PipelineVariantType type, ConstantDivisor divisor);
+extern PipelineVariant makeStepAsJump(PipelineVariantType type, Index target);
 extern PipelineVariant makeNone();
 
+// Reduced forms match C's truncating signed division and remainder exactly.
+static inline ValueType shiftLeftByConstant(ValueType left, const ConstantDivisor* divisor){
+	return (ValueType)((uint32_t)left << divisor->shift);
+}
+
+static inline ValueType divideByPow2Constant(ValueType left, const ConstantDivisor* divisor){
+	// bias negative dividends by 2^shift - 1 so the arithmetic shift truncates toward zero
+	uint32_t bias = (uint32_t)(left >> 31) >> (32 - divisor->shift);
+	ValueType quotient = (ValueType)((uint32_t)left + bias) >> divisor->shift;
+	return divisor->sign < 0 ? -quotient : quotient;
+}
+
+static inline ValueType moduloByPow2Constant(ValueType left, const ConstantDivisor* divisor){
+	uint32_t bias = (uint32_t)(left >> 31) >> (32 - divisor->shift);
+	uint32_t mask = ((uint32_t)1 << divisor->shift) - 1;
+	return (ValueType)((((uint32_t)left + bias) & mask) - bias);
+}
+
+static inline ValueType divideByMagicConstant(ValueType left, ValueType magic, const ConstantDivisor* divisor){
+	ValueType quotient = (ValueType)(((int64_t)magic * left) >> 32);
+	if(divisor->sign > 0){
+		quotient += left;
+	}
+	else if(divisor->sign < 0){
+		quotient -= left;
+	}
+	quotient >>= divisor->shift;
+	return quotient + (ValueType)((uint32_t)quotient >> 31);
+}
+
+static inline ValueType moduloByMagicConstant(ValueType left, ValueType magic, const ConstantDivisor* divisor){
+	return left - divideByMagicConstant(left, magic, divisor) * divisor->divisor;
+}
+
 // PIPELINE VARIABLE
 typedef struct{
 	char name;
@@ -18,7 +18,11 @@ typedef enum {
 	TOO_MANY_ARGUMENTS,
 	TOO_LITTLE_ARGUMENTS,
 	UNKNOWN_VARIABLE,
-	PIPELINE_FULL
+	PIPELINE_FULL,
+	HISTORY_FULL,
+	BUDGET_EXCEEDED,
+	DEFINITIONS_FULL,
+	TEXT_FULL
 } ParsingErrorType;
 
 typedef struct {
@@ -31,17 +35,40 @@ typedef struct {
 
 
 
+struct PipelineStream;
+struct PipelineDefinitions;
+struct PipelineSpans;
+
+// Optional parser extensions, attached to the input by the compile functions that need them.
+typedef struct {
+	struct PipelineStream* stream;
+	struct PipelineDefinitions* definitions;
+	// records the span of every parsed subexpression, see pipelineincremental.h
+	struct PipelineSpans* spans;
+} ParsingContext;
+
 typedef struct {
 	StringSlice slice;
 	size_t cursor;
+	ParsingContext* context;
+	// pipeline length the last patched jump of ?:, && or || lands on, 0 for none, kept by the parser
+	Index conditionalEnd;
 } PeekableStringSlice;
 
 
 extern ParsingError parseConstantVariableOperationToken(Pipeline* pipeline, PeekableStringSlice* peekableSlice, PipelineVariablesSlice variables);
 extern ParsingError parseMulDivToken(Pipeline* pipeline, PeekableStringSlice* peekableSlice, PipelineVariablesSlice variables);
 extern ParsingError parseAddSubToken(Pipeline* pipeline, PeekableStringSlice* peekableSlice, PipelineVariablesSlice variables);
+extern ParsingError parseRelationalToken(Pipeline* pipeline, PeekableStringSlice* peekableSlice, PipelineVariablesSlice variables);
+extern ParsingError parseEqualityToken(Pipeline* pipeline, PeekableStringSlice* peekableSlice, PipelineVariablesSlice variables);
+extern ParsingError parseLogicalAndToken(Pipeline* pipeline, PeekableStringSlice* peekableSlice, PipelineVariablesSlice variables);
+extern ParsingError parseLogicalOrToken(Pipeline* pipeline, PeekableStringSlice* peekableSlice, PipelineVariablesSlice variables);
+extern ParsingError parseConditionalToken(Pipeline* pipeline, PeekableStringSlice* peekableSlice, PipelineVariablesSlice variables);
 extern ParsingError compileExpression(Pipeline* pipeline, PeekableStringSlice* peekableSlice, PipelineVariablesSlice variables);
 
+// Comparisons and BOOL leave 0 or 1, && and || skip their BOOL step after one that no jump lands behind.
+extern bool isBooleanStep(const PipelineVariant* variant);
+
 extern void validateStackSizeWithPipeline(PipelineStack* stack, const Pipeline* pipeline);
 
 #endif
\ No newline at end of file
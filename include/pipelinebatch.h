@@ -0,0 +1,75 @@
+#ifndef PIPELINEBATCH_H
+#define PIPELINEBATCH_H
+
+#include "../include/execpipeline.h"
+#include <inttypes.h>
+#include <stdbool.h>
+
+// BATCH
+// Column major batch evaluation, columns[varIdx] holds rowCount values of a varying variable,
+// NULL marks a uniform (broadcast) variable whose value is taken from variables[varIdx] for every row.
+// Rows are evaluated one after the other by executePipeline, the gain over a caller loop is only the
+// shared setup.
+extern void executePipelineBatch(const Pipeline* pipeline, PipelineStack* stack, PipelineVariable variables[], int8_t variablesLen, const ValueType* const columns[], size_t rowCount, ValueType results[]);
+
+// SWEEP
+// Evaluation over an arithmetic progression of one variable, the other variables keep their values.
+// When the pipeline is a polynomial of degree d in the swept variable (only +, -, * and shifts touch it)
+// the first d + 1 points are evaluated and the rest follow by forward differencing with d additions
+// each, exact under the two's complement wraparound of the executor. Anything else, and sweeps of at
+// most d + 1 points, runs executePipeline once per point, no faster than a caller loop.
+#ifndef PIPELINE_SWEEP_MAX_DEGREE
+#define PIPELINE_SWEEP_MAX_DEGREE 8
+#endif
+
+#define PIPELINE_NOT_POLYNOMIAL UINT8_MAX
+
+typedef struct {
+	Index variable;
+	ValueType start;
+	ValueType step;
+	size_t count;
+} PipelineSweep;
+
+// Degree of the pipeline in variable, PIPELINE_NOT_POLYNOMIAL above PIPELINE_SWEEP_MAX_DEGREE, when the
+// variable reaches a division, comparison, jump or registered operation, or for a malformed pipeline.
+extern uint8_t getPipelinePolynomialDegree(const Pipeline* pipeline, Index variable);
+
+extern void executePipelineSweep(const Pipeline* pipeline, PipelineStack* stack, PipelineVariable variables[], int8_t variablesLen, PipelineSweep sweep, ValueType results[]);
+
+// Row major 2-D grid, results[outerIdx * inner.count + innerIdx].
+extern void executePipelineGrid(const Pipeline* pipeline, PipelineStack* stack, PipelineVariable variables[], int8_t variablesLen, PipelineSweep outer, PipelineSweep inner, ValueType results[]);
+
+// UNIFORM HOISTING
+#ifndef PIPELINE_MAX_HOISTED
+#define PIPELINE_MAX_HOISTED 8
+#endif
+
+// Maximal subexpression of the source pipeline depending only on uniform variables and constants.
+// divisionType is DIV/MOD when the hoisted value is directly the divisor of that step, NONE otherwise.
+typedef struct {
+	Index sourceBegin;
+	Index sourceEnd;
+	PipelineVariantType divisionType;
+} HoistedExpression;
+
+typedef struct {
+	const Pipeline* source;
+	Pipeline perRow;
+	HoistedExpression hoisted[PIPELINE_MAX_HOISTED];
+	uint8_t hoistedCount;
+} HoistedPipeline;
+
+// Finds uniform-only subexpressions of source, uniform[varIdx] marks the broadcast variables.
+// Inside a branch of ?:, && or || only subexpressions that cannot trap are hoisted, a division by
+// anything but a constant other than 0 and -1 stays where only the taken branch evaluates it.
+// The per row pipeline is built into perRowStorage, which needs at most the source length.
+extern void hoistUniformPipeline(HoistedPipeline* hoisted, const Pipeline* source, PipelineVariant perRowStorage[], uint8_t perRowCapacity, const bool uniform[]);
+
+// Evaluates the hoisted subexpressions once for the current uniform values and rebuilds the per row
+// pipeline with their results as constants, divisions by hoisted values use precomputed reciprocals.
+extern void prepareHoistedPipeline(HoistedPipeline* hoisted, PipelineStack* stack, PipelineVariablesSlice variables);
+
+extern void executeHoistedPipelineBatch(HoistedPipeline* hoisted, PipelineStack* stack, PipelineVariable variables[], int8_t variablesLen, const ValueType* const columns[], size_t rowCount, ValueType results[]);
+
+#endif
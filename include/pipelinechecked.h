@@ -0,0 +1,49 @@
+#ifndef PIPELINECHECKED_H
+#define PIPELINECHECKED_H
+
+#include "../include/execpipeline.h"
+#include "../include/pipelinerange.h"
+#include <inttypes.h>
+#include <stdbool.h>
+
+// Checked execution. executePipeline computes raw int32_t arithmetic, a zero divisor or INT32_MIN / -1
+// traps and overflow is undefined behaviour. The checked executor never traps, every faulting step
+// produces a defined result and ORs its fault into a sticky error mask without branching, the mask is
+// reported once per evaluation or batch. Registered div and mod are checked like / and %, other
+// registered operations are called as they are.
+
+typedef enum {
+	// overflow wraps around, division by zero gives 0, INT32_MIN / -1 gives INT32_MIN
+	ARITHMETIC_WRAPPING,
+	// overflow and INT32_MIN / -1 clamp to INT32_MIN or INT32_MAX, division by zero clamps by the
+	// sign of the dividend (0 / 0 gives 0), modulo by zero gives 0 in both modes
+	ARITHMETIC_SATURATING
+} ArithmeticMode;
+
+typedef enum {
+	ARITHMETIC_NO_ERROR = 0x00,
+	ARITHMETIC_OVERFLOW = 0x01,
+	ARITHMETIC_DIVISION_BY_ZERO = 0x02
+} ArithmeticErrorMask;
+
+typedef struct {
+	const Pipeline* pipeline;
+	ArithmeticMode mode;
+	// one bit per step proven fault free by range analysis, those steps run without checks
+	uint32_t provenSteps[(NONE_INDEX + 32) / 32];
+} CheckedPipeline;
+
+// Divisions and modulos by a constant other than 0 and -1 always run unchecked. steps is NULL to
+// check every other step, or the analyzePipelineRanges result of pipeline: steps with both
+// RANGE_NO_OVERFLOW and RANGE_NO_DIVISION_FAULT before the first division that may fault skip their
+// checks, which then only hold while the variables stay within the analyzed ranges. The 16 bit
+// opcodes run in 32 bits where they are checked.
+extern void prepareCheckedPipeline(CheckedPipeline* checked, const Pipeline* pipeline, ArithmeticMode mode, const StepRange steps[]);
+
+// errors accumulates ArithmeticErrorMask bits, clear it to start a new report.
+extern ValueType executeCheckedPipeline(const CheckedPipeline* checked, PipelineStack* stack, PipelineVariablesSlice variables, uint8_t* errors);
+
+// Column major batch like executePipelineBatch, errors accumulates the faults of all rows.
+extern void executeCheckedPipelineBatch(const CheckedPipeline* checked, PipelineStack* stack, PipelineVariable variables[], int8_t variablesLen, const ValueType* const columns[], size_t rowCount, ValueType results[], uint8_t* errors);
+
+#endif
@@ -0,0 +1,22 @@
+#ifndef PIPELINECODEGEN_H
+#define PIPELINECODEGEN_H
+
+#include "../include/execpipeline.h"
+#include <inttypes.h>
+#include <stdbool.h>
+
+// Ahead of time translation of a compiled pipeline into C source, for targets that cannot JIT but can
+// build generated code. Stack slots become locals, jumps become gotos and registered operations are
+// called directly through their symbol in the operation map. The generated function returns exactly
+// what executePipeline returns, its translation unit has to include execpipeline.h first and link
+// the operations it calls (pipelinemath.c).
+
+// Receives the generated source line by line, without the trailing newline.
+typedef void (*CodegenWriter)(void* context, const char* line);
+
+// Writes `ValueType <functionName>(const PipelineVariable variables[])` preceded by declarations of
+// the operations it calls. Returns false without writing anything for a malformed pipeline or
+// an operation that is not registered in the operation map.
+extern bool generatePipelineFunction(const Pipeline* pipeline, const char* functionName, CodegenWriter write, void* context);
+
+#endif
@@ -0,0 +1,44 @@
+#ifndef PIPELINECOST_H
+#define PIPELINECOST_H
+
+#include "../include/expressionparser.h"
+#include <inttypes.h>
+#include <stdbool.h>
+
+// Static worst case execution time and stack model of executePipeline.
+// Jumps only go forward so every step runs at most once per evaluation, the bound is the costliest
+// path through the pipeline, taking the more expensive side of every conditional.
+// The shipped tables are estimates for the reference executor built with -O2, calibrate them against
+// the profiler (PIPELINE_PROFILING) on the actual target before relying on them for hard deadlines.
+
+typedef struct {
+	// loop and switch overhead paid by every executed step
+	uint16_t dispatch;
+	// body of each step type, for OPERATION the call overhead without the operation itself
+	uint16_t steps[PIPELINE_VARIANT_TYPE_COUNT];
+	// cost of each registered operation indexed by OperationMapIndex, 0 where there is no estimate
+	const uint16_t* operations;
+	uint8_t operationCount;
+	// charged for operations without an estimate in the table
+	uint16_t unknownOperation;
+} PipelineCostTable;
+
+typedef struct {
+	uint32_t cycles;
+	// bytes of PipelineStack storage in use at the deepest point
+	uint16_t stackBytes;
+	uint8_t maxStackDepth;
+} PipelineCost;
+
+extern const PipelineCostTable pipelineCostCortexM0;
+extern const PipelineCostTable pipelineCostCortexM4;
+extern const PipelineCostTable pipelineCostX86;
+
+extern uint32_t getStepCost(const PipelineVariant* variant, const PipelineCostTable* table);
+extern PipelineCost estimatePipelineCost(const Pipeline* pipeline, const PipelineCostTable* table);
+
+// Compiles like compileExpression and reports BUDGET_EXCEEDED when the worst case exceeds the budget,
+// a zero field in the budget is not checked.
+extern ParsingError compileExpressionWithBudget(Pipeline* pipeline, PeekableStringSlice* peekableSlice, PipelineVariablesSlice variables, const PipelineCostTable* table, PipelineCost budget);
+
+#endif
@@ -0,0 +1,62 @@
+#ifndef PIPELINEDEFINITION_H
+#define PIPELINEDEFINITION_H
+
+#include "../include/expressionparser.h"
+#include <inttypes.h>
+#include <stdbool.h>
+
+// Named expressions with parameters, e.g. scale(a) := a*9/5+32
+// A definition is compiled once into a fragment, expressions compiled with compileExpressionWithDefinitions
+// may call it like an operation and get the fragment spliced in with the parameter references replaced
+// by the argument steps, so nothing remains of the call at run time and the optimizer passes see plain steps.
+// Arguments are substituted as expressions, a parameter used twice evaluates its argument twice.
+// Parameters are single letters like variables, a body may only reference its parameters and
+// earlier definitions. Names need at least two characters and shadow registered operations.
+
+#ifndef PIPELINE_MAX_DEFINITIONS
+#define PIPELINE_MAX_DEFINITIONS 16
+#endif
+
+#ifndef PIPELINE_DEFINITION_MAX_NAME
+#define PIPELINE_DEFINITION_MAX_NAME 16
+#endif
+
+#ifndef PIPELINE_DEFINITION_MAX_PARAMS
+#define PIPELINE_DEFINITION_MAX_PARAMS 8
+#endif
+
+typedef struct {
+	char name[PIPELINE_DEFINITION_MAX_NAME];
+	uint8_t nameLength;
+	uint8_t paramCount;
+	// fragment steps in the shared fragment pipeline, jump targets are absolute within it
+	Index begin;
+	Index length;
+} PipelineDefinition;
+
+typedef struct PipelineDefinitions {
+	PipelineDefinition definitions[PIPELINE_MAX_DEFINITIONS];
+	uint8_t definitionCount;
+	Pipeline fragments;
+} PipelineDefinitions;
+
+extern void initPipelineDefinitions(PipelineDefinitions* definitions, PipelineVariant fragmentStorage[], uint8_t fragmentCapacity);
+
+// Parses and compiles one `name(params) := body` definition, a name defined again refers to the new
+// body from then on. Reports DEFINITIONS_FULL when no definition is left and PIPELINE_FULL when the
+// fragment storage runs out.
+extern ParsingError definePipelineExpression(PipelineDefinitions* definitions, PeekableStringSlice* peekableSlice);
+
+// Reports PIPELINE_FULL also when the expanded expression would fit: a call expands its body behind
+// its compiled arguments before moving the expansion over them, so for a moment the pipeline holds the
+// arguments and the expansion at once. Nested calls need this capacity one call at a time.
+extern ParsingError compileExpressionWithDefinitions(Pipeline* pipeline, PeekableStringSlice* peekableSlice, PipelineVariablesSlice variables, PipelineDefinitions* definitions);
+
+extern const PipelineDefinition* findPipelineDefinition(const PipelineDefinitions* definitions, StringSlice name);
+
+// Replaces the arguments compiled at the end of pipeline by the expanded body of definition,
+// argument k occupies steps argBegins[k] up to the next argument or the end of the pipeline.
+// Returns false when the arguments and the expansion do not fit into the pipeline together.
+extern bool inlinePipelineDefinition(Pipeline* pipeline, const PipelineDefinitions* definitions, const PipelineDefinition* definition, const Index argBegins[]);
+
+#endif
@@ -0,0 +1,39 @@
+#ifndef PIPELINEFIXED_H
+#define PIPELINEFIXED_H
+
+#include "../include/execpipeline.h"
+#include <inttypes.h>
+
+// Integer and fixed point math for targets without an FPU, registered as operations in pipelinemath.c.
+// Fixed point values are Q16.16 (FIXED_ONE = 1.0), constants in expressions are written raw,
+// e.g. sqrt(131072) is sqrt(2.0). Only integer arithmetic is used, 64 bit where a product needs it.
+// Error bounds are against the exact result in Q16.16 units (ulp = 2^-16), measured over the whole
+// input range with `make benchmark` in tests. Derivatives keep tangents scaled like the values, with the
+// unit seed of executePipelineGradient the derivative of a fixed point operation comes out truncated.
+//   isqrt(x)       floor(sqrt(x)) of an integer, bit by bit, exact, 0 for x <= 0
+//   sqrt(x)        bit by bit on x << 16, floor of the exact root, error < 1 ulp, 0 for x <= 0
+//   exp(x)         2^(x log2 e) from a 65 entry 2^f table with linear interpolation, relative error
+//                  < 2.5e-5 above 1.0 and < 1.5 ulp below, 0 below -11.1, INT32_MAX above 10.39
+//   log(x)         exponent plus a 65 entry log2(1 + f) table with linear interpolation,
+//                  error < 2.5 ulp, INT32_MIN for x <= 0
+//   sin(x) cos(x)  24 iteration CORDIC on the angle reduced to [-pi/2, pi/2], error < 0.6 ulp
+//   lerp(a, b, t)  a + (b - a) t with t in Q16.16, the product is truncated towards minus infinity
+//   qmul qdiv      Q16.16 product and quotient, see fixedMul and fixedDiv
+
+#define FIXED_FRACTION_BITS 16
+#define FIXED_ONE ((ValueType)1 << FIXED_FRACTION_BITS)
+
+#define FIXED_CORDIC_ITERATIONS 24
+
+extern ValueType fixedIntegerSqrt(ValueType value);
+extern ValueType fixedSqrt(ValueType value);
+extern ValueType fixedExp(ValueType value);
+extern ValueType fixedLog(ValueType value);
+extern void fixedSinCos(ValueType angle, ValueType* sine, ValueType* cosine);
+extern ValueType fixedLerp(ValueType from, ValueType to, ValueType t);
+
+// Q16.16 product and quotient, the quotient is 0 for a zero divisor
+extern ValueType fixedMul(ValueType left, ValueType right);
+extern ValueType fixedDiv(ValueType left, ValueType right);
+
+#endif
@@ -0,0 +1,27 @@
+#ifndef PIPELINEGRADIENT_H
+#define PIPELINEGRADIENT_H
+
+#include "../include/execpipeline.h"
+#include "../include/pipelinemath.h"
+#include <inttypes.h>
+
+// Forward mode automatic differentiation, every stack value carries its tangent along each
+// requested variable so the value and all partial derivatives come out of a single traversal.
+// Derivatives use the same truncating integer arithmetic as executePipeline.
+
+#ifndef PIPELINE_GRADIENT_SIZE
+#define PIPELINE_GRADIENT_SIZE 4
+#endif
+
+typedef struct {
+	PipelineStack values;
+	ValueType tangents[PIPELINE_STACK_SIZE][PIPELINE_GRADIENT_SIZE];
+} GradientStack;
+
+// Evaluates pipeline and writes d(result)/d(variables[wrt[k]]) into gradient[k].
+// wrt == NULL differentiates with respect to every variable in order, at most PIPELINE_GRADIENT_SIZE.
+// Registered operations without a derivative rule contribute zero and set NO_DERIVATIVE on stack->values.
+// So do divisions whose quotient rule has no int32_t result, the registered div returns 0 there unflagged.
+extern ValueType executePipelineGradient(const Pipeline* pipeline, GradientStack* stack, PipelineVariablesSlice variables, const Index wrt[], uint8_t wrtCount, ValueType gradient[]);
+
+#endif
@@ -0,0 +1,75 @@
+#ifndef PIPELINEHANDLE_H
+#define PIPELINEHANDLE_H
+
+#include "../include/execpipeline.h"
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+// Versioned pipeline shared between threads and replaced while it is being evaluated.
+// Readers pick up the current version with one atomic load and no lock, a writer builds the next
+// version in a free slot of the caller provided version pool and publishes it with an atomic exchange.
+// Replaced versions are reused once every reader that could still see them has left (epoch based
+// reclamation), readers are identified by a small caller assigned id.
+// Writers may run on several threads, acquire, publish and abandon serialize on a spin lock that
+// only writers take, readers never wait on it.
+
+#ifndef PIPELINE_HANDLE_MAX_READERS
+#define PIPELINE_HANDLE_MAX_READERS 16
+#endif
+
+#ifndef PIPELINE_HANDLE_CACHE_LINE
+#define PIPELINE_HANDLE_CACHE_LINE 64
+#endif
+
+typedef enum {
+	PIPELINE_VERSION_FREE,
+	PIPELINE_VERSION_WRITING,
+	PIPELINE_VERSION_CURRENT,
+	PIPELINE_VERSION_RETIRED
+} PipelineVersionState;
+
+typedef struct {
+	Pipeline pipeline;
+	uint32_t version;
+	// global epoch after the version was replaced, readers announced below it may still use it
+	uint32_t retiredEpoch;
+	PipelineVersionState state;
+} PipelineVersion;
+
+typedef struct {
+	// epoch observed on entry, 0 while outside
+	_Alignas(PIPELINE_HANDLE_CACHE_LINE) _Atomic uint32_t epoch;
+} PipelineReaderSlot;
+
+typedef struct {
+	_Alignas(PIPELINE_HANDLE_CACHE_LINE) _Atomic(PipelineVersion*) current;
+	_Atomic uint32_t epoch;
+	PipelineReaderSlot readers[PIPELINE_HANDLE_MAX_READERS];
+	PipelineVersion* versions;
+	uint8_t versionCount;
+	// guards the version states and nextVersion
+	atomic_flag writerLock;
+	uint32_t nextVersion;
+} PipelineHandle;
+
+// every version needs its own step storage, at least two versions are needed to replace a pipeline
+extern void initPipelineVersion(PipelineVersion* version, PipelineVariant storage[], uint8_t storageCapacity);
+extern void initPipelineHandle(PipelineHandle* handle, PipelineVersion versions[], uint8_t versionCount);
+
+// READERS
+// The version returned by enterPipelineHandle stays valid until leavePipelineHandle, NULL before the
+// first publish. A reader id is used by one thread at a time and enters are not nested.
+extern const PipelineVersion* enterPipelineHandle(PipelineHandle* handle, uint8_t readerId);
+extern void leavePipelineHandle(PipelineHandle* handle, uint8_t readerId);
+extern ValueType executePipelineHandle(PipelineHandle* handle, uint8_t readerId, PipelineStack* stack, PipelineVariablesSlice variables);
+
+// WRITERS
+// Returns a cleared version to compile and optimize into, NULL while all versions are in use.
+extern PipelineVersion* acquirePipelineVersion(PipelineHandle* handle);
+// Makes version current, the replaced one is retired and reused once no reader can see it.
+extern void publishPipelineVersion(PipelineHandle* handle, PipelineVersion* version);
+// Gives an acquired version back without publishing it, e.g. after a parsing error.
+extern void abandonPipelineVersion(PipelineHandle* handle, PipelineVersion* version);
+
+#endif
@@ -0,0 +1,78 @@
+#ifndef PIPELINEINCREMENTAL_H
+#define PIPELINEINCREMENTAL_H
+
+#include "../include/expressionparser.h"
+#include <inttypes.h>
+#include <stdbool.h>
+
+// Incremental recompilation for editors that recompile on every keystroke. While compiling, the parser
+// records the source and step span of each subexpression it completes together with the grammar level
+// that parsed it. An edit reparses only the smallest recorded subexpression enclosing it, at that level,
+// into the free tail of the pipeline and splices the new steps over the old ones, relocating the jump
+// targets behind them. When the edited text no longer forms one subexpression of that level, or would
+// change how its parent compiles, the next enclosing subexpression is tried and the whole expression last.
+// Parsing work follows the size of the reparsed subexpression, moving the text, steps and spans behind
+// it is a plain memmove and offset pass. The pipeline ends up as a full compile of the new text leaves it.
+
+typedef enum {
+	SPAN_PRIMARY,
+	SPAN_MUL_DIV,
+	SPAN_ADD_SUB,
+	SPAN_RELATIONAL,
+	SPAN_EQUALITY,
+	SPAN_LOGICAL_AND,
+	SPAN_LOGICAL_OR,
+	SPAN_CONDITIONAL
+} SpanLevel;
+
+typedef struct {
+	// text range without leading whitespace, trailing whitespace the parser looked past is included
+	uint16_t sourceBegin;
+	uint16_t sourceEnd;
+	Index stepBegin;
+	Index stepEnd;
+	// outermost level that parsed exactly this range
+	uint8_t level;
+	// storage a definition call needs behind stepEnd while its body is expanded
+	Index reserve;
+} PipelineSpan;
+
+// Spans in post order, a subexpression follows everything inside it. Attached to the parser through
+// ParsingContext, overflowed is set once a span did not fit.
+typedef struct PipelineSpans {
+	PipelineSpan* entries;
+	uint16_t count;
+	uint16_t capacity;
+	bool overflowed;
+	// reserve of the definition call recorded next
+	Index pendingReserve;
+} PipelineSpans;
+
+typedef struct {
+	char* text;
+	uint16_t length;
+	uint16_t textCapacity;
+	Pipeline* pipeline;
+	PipelineVariablesSlice variables;
+	PipelineSpans spans;
+	// NULL or the definitions the expression may call, recompile fully after changing them
+	struct PipelineDefinitions* definitions;
+	// false until the text compiled, edits of a text that does not compile recompile it fully
+	bool compiled;
+	// length of the text reparsed by the last compile or edit
+	uint16_t reparsedLength;
+} IncrementalExpression;
+
+extern void initIncrementalExpression(IncrementalExpression* expression, char textStorage[], uint16_t textCapacity, Pipeline* pipeline, PipelineVariablesSlice variables, PipelineSpan spanStorage[], uint16_t spanCapacity);
+
+// Replaces the text by source and compiles it from scratch. Reports TEXT_FULL when source does not
+// fit into the text storage.
+extern ParsingError compileIncrementalExpression(IncrementalExpression* expression, StringSlice source);
+
+// Replaces removed characters at offset by inserted and recompiles what the edit touched, errors are
+// those a full compile of the new text reports. Reports UNEXPECTED for an edit outside the text and
+// TEXT_FULL when the new text does not fit, both leave text and pipeline unchanged. The pipeline must
+// not be changed in between, optimize a copy of it.
+extern ParsingError editIncrementalExpression(IncrementalExpression* expression, uint16_t offset, uint16_t removed, StringSlice inserted);
+
+#endif
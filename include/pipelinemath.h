@@ -16,11 +16,39 @@ typedef struct {
 	size_t argCount;
 } PipelineOperationMeta;
 
+// Forward mode derivative rule of an operation, receives the operation arguments and the tangent of
+// each argument along one direction and returns the tangent of the result.
+typedef ValueType (*PipelineOperationDerivative)(const ValueType args[], const ValueType tangents[]);
+
 typedef struct {
 	PipelineOperation op;
 	PipelineOperationMeta meta;
+	PipelineOperationDerivative derivative;
+	// C symbol of op, generated code calls the operation directly through it
+	const char* symbol;
 } OperationMapEntry;
 
+// Position of every registered operation in the operation map, tables kept per operation outside the
+// map (the cost model) use it as designated initializer so they stay aligned when the map changes.
+typedef enum {
+	OPERATION_MAP_ADD,
+	OPERATION_MAP_SUB,
+	OPERATION_MAP_MUL,
+	OPERATION_MAP_DIV,
+	OPERATION_MAP_MOD,
+	OPERATION_MAP_POW2,
+	OPERATION_MAP_ISQRT,
+	OPERATION_MAP_SQRT,
+	OPERATION_MAP_EXP,
+	OPERATION_MAP_LOG,
+	OPERATION_MAP_SIN,
+	OPERATION_MAP_COS,
+	OPERATION_MAP_LERP,
+	OPERATION_MAP_QMUL,
+	OPERATION_MAP_QDIV,
+	OPERATION_MAP_COUNT
+} OperationMapIndex;
+
 
 #define MAKE_SLICE_FROM_CONST_STRING(str) ((StringSlice){str, (sizeof(str)/sizeof(str[0])) - 1})
 #define MAKE_EMPTY_SLICE ((StringSlice){.str = NULL, .len = 0})
@@ -32,8 +60,19 @@ extern bool isSliceEqual(StringSlice left, StringSlice right);
 extern size_t findInSlice(StringSlice input, StringSlice searched);
 
 
+// registered div and mod divide by a runtime operand, a zero divisor or INT32_MIN / -1 traps like / and %
+extern ValueType opDiv(const ValueType args[], ValueType last);
+extern ValueType opMod(const ValueType args[], ValueType last);
+
+// Tangent of dividend / divisor by the quotient rule, the numerator and the squared divisor are formed
+// in 64 bits. False for a zero divisor or a tangent outside int32_t, where there is no derivative.
+extern bool getQuotientTangent(ValueType dividend, ValueType divisor, ValueType dividendTangent, ValueType divisorTangent, ValueType* tangent);
+
 PipelineOperation getOperationByName(StringSlice name);
 PipelineOperationMeta getMetaByOperation(PipelineOperation op);
+const OperationMapEntry* getEntryByOperation(PipelineOperation op);
+// Position of the operation in the operation map, NONE_INDEX when it is not registered.
+Index getOperationMapIndex(PipelineOperation op);
 
 
 #endif
\ No newline at end of file
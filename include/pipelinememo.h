@@ -0,0 +1,47 @@
+#ifndef PIPELINEMEMO_H
+#define PIPELINEMEMO_H
+
+#include "../include/execpipeline.h"
+#include <inttypes.h>
+#include <stdbool.h>
+
+// Result cache of a single pipeline keyed by the values of the variables it references.
+// The cache is set associative with PIPELINE_MEMO_WAYS entries per set and LRU replacement,
+// entries live in caller provided storage.
+
+#ifndef PIPELINE_MEMO_MAX_KEYS
+#define PIPELINE_MEMO_MAX_KEYS 4
+#endif
+
+// pipelines shorter than this without any registered operation are cheaper to run than to look up
+#ifndef PIPELINE_MEMO_MIN_STEPS
+#define PIPELINE_MEMO_MIN_STEPS 8
+#endif
+
+#define PIPELINE_MEMO_WAYS 2
+
+typedef struct {
+	ValueType keys[PIPELINE_MEMO_MAX_KEYS];
+	ValueType result;
+	bool valid;
+} PipelineMemoEntry;
+
+typedef struct {
+	const Pipeline* pipeline;
+	PipelineMemoEntry* entries;
+	uint16_t setMask;
+	Index keyIndexes[PIPELINE_MEMO_MAX_KEYS];
+	uint8_t keyCount;
+	bool bypass;
+	uint32_t hits;
+	uint32_t misses;
+	uint32_t bypassed;
+} PipelineMemo;
+
+// Collects the referenced variables of pipeline and decides whether caching pays off,
+// storage is used up to the largest power of two number of sets that fits.
+extern void initPipelineMemo(PipelineMemo* memo, const Pipeline* pipeline, PipelineMemoEntry storage[], uint16_t storageCapacity);
+extern void clearPipelineMemo(PipelineMemo* memo);
+extern ValueType executePipelineMemo(PipelineMemo* memo, PipelineStack* stack, PipelineVariablesSlice variables);
+
+#endif
@@ -0,0 +1,68 @@
+#ifndef PIPELINEOPTIMIZER_H
+#define PIPELINEOPTIMIZER_H
+
+#include "../include/execpipeline.h"
+#include "../include/pipelinemath.h"
+#include <inttypes.h>
+#include <stdbool.h>
+
+// Optimization passes rewrite a compiled pipeline in place, passes mark dropped steps as NONE
+// and compactPipeline removes them afterwards, retargeting jumps to the next surviving step.
+
+extern void compactPipeline(Pipeline* pipeline);
+
+// Number of stack values consumed by the step, every step except jumps pushes exactly one value.
+extern uint8_t getStepArgCount(const PipelineVariant* variant);
+extern bool isJumpStep(const PipelineVariant* variant);
+
+// Deepest stack reached on any path through the pipeline, 0 for an empty or malformed pipeline.
+extern uint8_t getPipelineMaxStackDepth(const Pipeline* pipeline);
+
+// CONTROL FLOW
+// Passes simulate the stack linearly, conditional regions (?:, && and ||) are collapsed into a single
+// opaque operand: at each jump the pass pops one operand and calls enterControlFlow with its begin,
+// before each step (and once more past the end) mergeControlFlow returns the begin of every region
+// ending there, the pass then replaces the top operand by the region.
+typedef struct {
+	Index begin;
+	Index target;
+} ControlFrame;
+
+typedef struct {
+	ControlFrame frames[PIPELINE_STACK_SIZE];
+	uint8_t count;
+} ControlFlowTracker;
+
+extern void initControlFlow(ControlFlowTracker* tracker);
+extern void enterControlFlow(ControlFlowTracker* tracker, const PipelineVariant* jump, Index operandBegin);
+extern bool mergeControlFlow(ControlFlowTracker* tracker, Index pipelineIdx, Index* regionBegin);
+
+// Rewrites MUL/DIV/MOD step by constant `value` into its shift or magic number form, returns the
+// number of steps written to reduced: 1 for a shift form replacing both the constant and the step,
+// 2 for a magic form whose CONSTANT magic number takes the place of the constant, and 0 when the
+// constant has no cheaper exact form (0, +-1, too large for the encoding).
+extern uint8_t reduceStepByConstant(PipelineVariantType type, ValueType value, PipelineVariant reduced[2]);
+
+// Replaces multiplication by power of two constants with shifts and division/modulo by constants
+// with shift or multiply-high sequences, results are bit exact with C's truncating semantics.
+extern void strengthReducePipeline(Pipeline* pipeline);
+
+// Evaluates every step whose operands are all constants at compile time, registered operations are
+// assumed to be pure. Native division and modulo that would trap are left for runtime. A jump testing
+// a constant is resolved: ?: keeps only the taken branch, && and || keep the constant when it decides
+// the result and their right side otherwise, jumps into the dropped steps are retargeted.
+extern void foldConstantsPipeline(Pipeline* pipeline);
+
+// Sethi-Ullman ordering, the operand of a binary step needing the deeper stack is evaluated first.
+// Commutative steps are swapped as they are, SUB/DIV/MOD become their reversed forms and comparisons
+// are mirrored, results are unchanged. Returns the max stack depth of the reordered pipeline.
+extern uint8_t reorderPipelineOperands(Pipeline* pipeline);
+
+// Copies source into target with the variables marked in known[] substituted by their value from
+// variables and folds everything that became constant. Variables still referenced are renumbered
+// densely in their original order and copied into remaining[] (variables.len entries at most).
+// Returns the number of remaining variables, or -1 when target is too small to hold the copy, which
+// target->errorMask reports as well.
+extern int8_t specializePipeline(const Pipeline* source, Pipeline* target, PipelineVariablesSlice variables, const bool known[], PipelineVariable remaining[]);
+
+#endif
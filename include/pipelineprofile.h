@@ -0,0 +1,97 @@
+#ifndef PIPELINEPROFILE_H
+#define PIPELINEPROFILE_H
+
+#include "../include/execpipeline.h"
+
+// Opt-in instrumentation of executePipeline, enabled by defining PIPELINE_PROFILING for the whole build.
+// Without it every hook below expands to nothing and the executor is compiled exactly as before.
+
+#ifdef PIPELINE_PROFILING
+
+#ifndef PIPELINE_PROFILE_MAX_OPERATIONS
+#define PIPELINE_PROFILE_MAX_OPERATIONS 16
+#endif
+
+#ifndef PIPELINE_PROFILE_MAX_PIPELINES
+#define PIPELINE_PROFILE_MAX_PIPELINES 16
+#endif
+
+// latency histogram bucket N counts evaluations that took [2^N, 2^(N+1)) cycles
+#define PIPELINE_PROFILE_HISTOGRAM_BUCKETS 24
+
+// Cycle counter source, override before including to hook MCU counters, e.g.:
+// #define PIPELINE_PROFILE_CYCLES() (DWT->CYCCNT)
+#ifndef PIPELINE_PROFILE_CYCLES
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define PIPELINE_PROFILE_CYCLES() ((ProfileCycles)__rdtsc())
+#else
+// no known counter, only execution counts are meaningful
+#define PIPELINE_PROFILE_CYCLES() ((ProfileCycles)0)
+#endif
+#endif
+
+typedef uint32_t ProfileCycles;
+
+typedef struct {
+	uint32_t count;
+	uint64_t cycles;
+} StepProfile;
+
+typedef struct {
+	PipelineOperation op;
+	uint32_t calls;
+} OperationProfile;
+
+typedef struct {
+	const Pipeline* pipeline;
+	uint32_t evaluations;
+	uint64_t cycles;
+	uint32_t histogram[PIPELINE_PROFILE_HISTOGRAM_BUCKETS];
+} PipelineEvaluationProfile;
+
+typedef struct {
+	StepProfile steps[PIPELINE_VARIANT_TYPE_COUNT];
+	OperationProfile operations[PIPELINE_PROFILE_MAX_OPERATIONS];
+	uint8_t operationCount;
+	PipelineEvaluationProfile pipelines[PIPELINE_PROFILE_MAX_PIPELINES];
+	uint8_t pipelineCount;
+	uint8_t maxStackDepth;
+	// events that did not fit into the fixed tables above
+	uint32_t droppedEvents;
+} PipelineProfile;
+
+typedef void (*ProfileWriter)(const char* line);
+
+extern PipelineProfile pipelineProfile;
+
+extern void resetPipelineProfile(void);
+extern void profileOperation(PipelineOperation op);
+extern void profilePipeline(const Pipeline* pipeline, ProfileCycles cycles);
+extern void dumpPipelineProfile(ProfileWriter write);
+
+#define PROFILE_PIPELINE_BEGIN() ProfileCycles profilePipelineBegin = PIPELINE_PROFILE_CYCLES()
+#define PROFILE_PIPELINE_END(pipeline) profilePipeline(pipeline, PIPELINE_PROFILE_CYCLES() - profilePipelineBegin)
+#define PROFILE_STEP_BEGIN() ProfileCycles profileStepBegin = PIPELINE_PROFILE_CYCLES()
+#define PROFILE_STEP_END(type, stackIndex) \
+	do { \
+		pipelineProfile.steps[(type)].count++; \
+		pipelineProfile.steps[(type)].cycles += (ProfileCycles)(PIPELINE_PROFILE_CYCLES() - profileStepBegin); \
+		uint8_t profileDepth = (uint8_t)((stackIndex) + 1); \
+		if(profileDepth > pipelineProfile.maxStackDepth){ \
+			pipelineProfile.maxStackDepth = profileDepth; \
+		} \
+	} while(0)
+#define PROFILE_OPERATION(op) profileOperation(op)
+
+#else
+
+#define PROFILE_PIPELINE_BEGIN()
+#define PROFILE_PIPELINE_END(pipeline)
+#define PROFILE_STEP_BEGIN()
+#define PROFILE_STEP_END(type, stackIndex)
+#define PROFILE_OPERATION(op)
+
+#endif
+
+#endif
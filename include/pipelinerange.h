@@ -0,0 +1,44 @@
+#ifndef PIPELINERANGE_H
+#define PIPELINERANGE_H
+
+#include "../include/execpipeline.h"
+#include <inttypes.h>
+#include <stdbool.h>
+
+// Interval analysis of a compiled pipeline. Declared variable ranges are propagated through every
+// step, both branches of a conditional region are joined where they merge. Registered operations
+// are opaque and may return any value. Results hold only while the variables stay in their ranges.
+
+typedef struct {
+	ValueType low;
+	ValueType high;
+} ValueRange;
+
+#define FULL_VALUE_RANGE ((ValueRange){.low = INT32_MIN, .high = INT32_MAX})
+
+typedef enum {
+	// the step never wraps around, set for every step that cannot overflow at all
+	RANGE_NO_OVERFLOW = 0x01,
+	// division and modulo never see a zero divisor or INT32_MIN / -1, set for every other step
+	RANGE_NO_DIVISION_FAULT = 0x02,
+	// operands and result (the quotient too for modulo) fit int16_t or int8_t
+	RANGE_FITS_16 = 0x04,
+	RANGE_FITS_8 = 0x08
+} StepRangeFlags;
+
+typedef struct {
+	// value pushed by the step, the tested value for jumps
+	ValueRange result;
+	uint8_t flags;
+} StepRange;
+
+// Fills steps[] (one entry per pipeline step) from variableRanges[] (one entry per variable index,
+// NULL for unconstrained variables). Returns false for a malformed pipeline.
+extern bool analyzePipelineRanges(const Pipeline* pipeline, const ValueRange variableRanges[], int8_t variableCount, StepRange steps[]);
+
+// Rewrites ADD, SUB, MUL, DIV and MOD steps proven to fit 16 bits into their 16 bit opcodes and
+// returns how many were narrowed. C promotes 8 bit arithmetic to int, steps fitting 8 bits are only
+// reported. Other passes do not know the narrow opcodes, narrow last.
+extern uint8_t narrowPipeline(Pipeline* pipeline, const StepRange steps[]);
+
+#endif
@@ -0,0 +1,74 @@
+#ifndef PIPELINESTREAM_H
+#define PIPELINESTREAM_H
+
+#include "../include/expressionparser.h"
+#include <inttypes.h>
+#include <stdbool.h>
+
+// Stateful evaluation over a stream of samples. Expressions compiled with compileStreamExpression
+// may use the history functions below, each distinct use becomes a synthetic variable that
+// stepPipelineStream fills in O(1) from ring buffers before running the plain pipeline.
+//   prev(x) prev(x, k)  value of x k samples ago (k = 1 by default)
+//   delta(x)            x - prev(x)
+//   sum(x, n) avg(x, n) sum and truncated average of the last n samples of x, this one included
+//   out(k)              result of the expression k samples ago
+// History starts zero filled.
+
+#ifndef PIPELINE_STREAM_MAX_VARIABLES
+#define PIPELINE_STREAM_MAX_VARIABLES 16
+#endif
+
+#ifndef PIPELINE_STREAM_MAX_SLOTS
+#define PIPELINE_STREAM_MAX_SLOTS 8
+#endif
+
+// ring index of the expression output
+#define STREAM_OUTPUT_RING PIPELINE_STREAM_MAX_VARIABLES
+
+typedef enum {
+	STREAM_PREV,
+	STREAM_DELTA,
+	STREAM_SUM,
+	STREAM_AVG,
+	STREAM_OUT
+} StreamSlotKind;
+
+typedef struct {
+	StreamSlotKind kind;
+	Index source;
+	uint16_t param;
+	ValueType sum;
+} StreamSlot;
+
+typedef struct {
+	ValueType* values;
+	uint16_t length;
+	uint16_t head;
+} StreamRing;
+
+typedef struct PipelineStream {
+	const Pipeline* pipeline;
+	PipelineVariable variables[PIPELINE_STREAM_MAX_VARIABLES + PIPELINE_STREAM_MAX_SLOTS];
+	int8_t sampleLen;
+	StreamSlot slots[PIPELINE_STREAM_MAX_SLOTS];
+	uint8_t slotCount;
+	StreamRing rings[PIPELINE_STREAM_MAX_VARIABLES + 1];
+	ValueType* historyStorage;
+	uint16_t historyCapacity;
+} PipelineStream;
+
+extern void initPipelineStream(PipelineStream* stream, ValueType historyStorage[], uint16_t historyCapacity);
+
+// Compiles an expression over sampleVariables, ring buffers are sized from the history it uses and
+// carved from the history storage, HISTORY_FULL is reported when the storage or slots run out.
+extern ParsingError compileStreamExpression(PipelineStream* stream, Pipeline* pipeline, PeekableStringSlice* peekableSlice, PipelineVariablesSlice sampleVariables);
+
+// Returns the synthetic variable index of a history slot, NONE_INDEX when all slots are taken.
+extern Index addStreamSlot(PipelineStream* stream, StreamSlotKind kind, Index source, uint16_t param);
+
+// Evaluates the next sample, sample[] holds one value per sample variable.
+extern ValueType stepPipelineStream(PipelineStream* stream, PipelineStack* stack, const ValueType sample[]);
+
+extern void resetPipelineStream(PipelineStream* stream);
+
+#endif
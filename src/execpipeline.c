@@ -1,4 +1,5 @@
 #include "../include/execpipeline.h"
+#include "../include/pipelineprofile.h"
 
 // PIPELINE STACK
 
@@ -67,10 +68,25 @@ PipelineVariant makeStepAsVariableIndex(Index value){
     return result;
 }
 
-PipelineVariant makeStepAsOperation(PipelineOperation value){
+PipelineVariant makeStepAsOperation(PipelineOperation value, uint8_t argCount){
     PipelineVariant result;
     result.type = OPERATION;
     result.asOperation = value;
+    result.asOperationArgCount = argCount;
+    return result;
+}
+
+PipelineVariant makeStepAsDivisor(PipelineVariantType type, ConstantDivisor divisor){
+    PipelineVariant result;
+    result.type = type;
+    result.asDivisor = divisor;
+    return result;
+}
+
+PipelineVariant makeStepAsJump(PipelineVariantType type, Index target){
+    PipelineVariant result;
+    result.type = type;
+    result.asJumpTarget = target;
     return result;
 }
 
@@ -125,77 +141,238 @@ uint8_t lengthOfPipeline(const Pipeline *pipeline){
 
 ValueType executePipeline(const Pipeline *pipeline, PipelineStack *stack, PipelineVariablesSlice variables){
 
+	PROFILE_PIPELINE_BEGIN();
 	clearStack(stack);
-	ValueType right;
+	// the top of the stack lives in `right` and is spilled only when another value is pushed,
+	// entries[stackIndex] holds the value below it, the bottom slot is a dummy spill of the empty stack
+	ValueType right = 0;
 	ValueType left;
 	
 	ValueType* stackStorage = stack->entries;
-	Index* stackIndex = &stack->index;
+	Index stackIndex = stack->index;
 	
 	uint8_t pipelineLength = pipeline->index + 1;
 	for(Index pipelineIdx = 0; pipelineIdx < pipelineLength; pipelineIdx++){
 		const PipelineVariant* variant = &pipeline->entries[pipelineIdx];
+		PROFILE_STEP_BEGIN();
 		switch (variant->type)
 		{
 			case OPERATION_NATIVE_ADD:
 				{
-					--(*stackIndex);
-					left = stackStorage[(*stackIndex)];
-					right = stackStorage[(*stackIndex)] = left + right;
+					left = stackStorage[stackIndex--];
+					right = left + right;
 				}
 				break;
 			case OPERATION_NATIVE_SUB:
-				{						
-					--(*stackIndex);
-					left = stackStorage[(*stackIndex)];
-					right = stackStorage[(*stackIndex)] = left - right;
+				{
+					left = stackStorage[stackIndex--];
+					right = left - right;
 				}
 				break;
 			case OPERATION_NATIVE_MUL:
-				{						
-					--(*stackIndex);
-					left = stackStorage[(*stackIndex)];
-					right = stackStorage[(*stackIndex)] = left * right;
+				{
+					left = stackStorage[stackIndex--];
+					right = left * right;
 				}
 				break;
 			case OPERATION_NATIVE_DIV:
-				{						
-					--(*stackIndex);
-					left = stackStorage[(*stackIndex)];
-					right = stackStorage[(*stackIndex)] = left / right;
+				{
+					left = stackStorage[stackIndex--];
+					right = left / right;
 				}
 				break;
 			case OPERATION_NATIVE_MOD:
-				{						
-					--(*stackIndex);
-					left = stackStorage[(*stackIndex)];
-					right = stackStorage[(*stackIndex)] = left % right;
+				{
+					left = stackStorage[stackIndex--];
+					right = left % right;
+				}
+				break;
+			case OPERATION_NATIVE_RSUB:
+				{
+					left = stackStorage[stackIndex--];
+					right = right - left;
+				}
+				break;
+			case OPERATION_NATIVE_RDIV:
+				{
+					left = stackStorage[stackIndex--];
+					right = right / left;
+				}
+				break;
+			case OPERATION_NATIVE_RMOD:
+				{
+					left = stackStorage[stackIndex--];
+					right = right % left;
+				}
+				break;
+			case OPERATION_NATIVE_ADD16:
+				{
+					left = stackStorage[stackIndex--];
+					right = (int16_t)left + (int16_t)right;
+				}
+				break;
+			case OPERATION_NATIVE_SUB16:
+				{
+					left = stackStorage[stackIndex--];
+					right = (int16_t)left - (int16_t)right;
+				}
+				break;
+			case OPERATION_NATIVE_MUL16:
+				{
+					left = stackStorage[stackIndex--];
+					right = (int16_t)left * (int16_t)right;
+				}
+				break;
+			case OPERATION_NATIVE_DIV16:
+				{
+					left = stackStorage[stackIndex--];
+					right = (int16_t)left / (int16_t)right;
+				}
+				break;
+			case OPERATION_NATIVE_MOD16:
+				{
+					left = stackStorage[stackIndex--];
+					right = (int16_t)left % (int16_t)right;
+				}
+				break;
+			case OPERATION_NATIVE_SHL:
+				{
+					right = shiftLeftByConstant(right, &variant->asDivisor);
+				}
+				break;
+			case OPERATION_NATIVE_DIV_POW2:
+				{
+					right = divideByPow2Constant(right, &variant->asDivisor);
+				}
+				break;
+			case OPERATION_NATIVE_MOD_POW2:
+				{
+					right = moduloByPow2Constant(right, &variant->asDivisor);
+				}
+				break;
+			case OPERATION_NATIVE_DIV_MAGIC:
+				{
+					left = stackStorage[stackIndex--];
+					right = divideByMagicConstant(left, right, &variant->asDivisor);
+				}
+				break;
+			case OPERATION_NATIVE_MOD_MAGIC:
+				{
+					left = stackStorage[stackIndex--];
+					right = moduloByMagicConstant(left, right, &variant->asDivisor);
+				}
+				break;
+			case OPERATION_NATIVE_LT:
+				{
+					left = stackStorage[stackIndex--];
+					right = left < right;
+				}
+				break;
+			case OPERATION_NATIVE_LE:
+				{
+					left = stackStorage[stackIndex--];
+					right = left <= right;
+				}
+				break;
+			case OPERATION_NATIVE_GT:
+				{
+					left = stackStorage[stackIndex--];
+					right = left > right;
+				}
+				break;
+			case OPERATION_NATIVE_GE:
+				{
+					left = stackStorage[stackIndex--];
+					right = left >= right;
+				}
+				break;
+			case OPERATION_NATIVE_EQ:
+				{
+					left = stackStorage[stackIndex--];
+					right = left == right;
+				}
+				break;
+			case OPERATION_NATIVE_NE:
+				{
+					left = stackStorage[stackIndex--];
+					right = left != right;
+				}
+				break;
+			case OPERATION_NATIVE_BOOL:
+				{
+					right = right != 0;
+				}
+				break;
+			case JUMP:
+				{
+					pipelineIdx = variant->asJumpTarget - 1;
+				}
+				break;
+			case JUMP_IF_ZERO:
+				{
+					if(right == 0){
+						pipelineIdx = variant->asJumpTarget - 1;
+					}
+					right = stackStorage[stackIndex--];
+				}
+				break;
+			case JUMP_IF_ZERO_OR_POP:
+				{
+					if(right == 0){
+						pipelineIdx = variant->asJumpTarget - 1;
+					}
+					else {
+						right = stackStorage[stackIndex--];
+					}
+				}
+				break;
+			case JUMP_IF_NONZERO_OR_POP:
+				{
+					if(right != 0){
+						pipelineIdx = variant->asJumpTarget - 1;
+					}
+					else {
+						right = stackStorage[stackIndex--];
+					}
 				}
 				break;
 			case CONSTANT:
 				{	
+					stackStorage[++stackIndex] = right;
 					right = variant->asConstant;
-					pushStackUnchecked(stack, right);
 				}
 				break;
 			case VARIABLE_INDEX:
 				{
-					VariableIndex variableIndex = variant->asVariableIndex;
+					stackStorage[++stackIndex] = right;
 					right = variables.vars[variant->asVariableIndex].value;
-					pushStackUnchecked(stack, right);
 				}
 				break;
 			case OPERATION:
 				{
 					PipelineOperation op = variant->asOperation;
-					right = op(stack);
-					pushStackUnchecked(stack, right);
+					uint8_t argCount = variant->asOperationArgCount;
+					PROFILE_OPERATION(op);
+					if(argCount == 0){
+						stackStorage[++stackIndex] = right;
+						right = op(stackStorage, 0);
+					}
+					else {
+						// the arguments below the top are already contiguous in the spilled entries
+						stackIndex -= argCount - 1;
+						right = op(&stackStorage[stackIndex + 1], right);
+					}
 				}
 				break;
 			case NONE:
+				stack->index = stackIndex;
+				PROFILE_PIPELINE_END(pipeline);
 				return MISSING_VALUE;
 		}
+		PROFILE_STEP_END(variant->type, stackIndex);
 	}
 
-	return popStackUnchecked(stack);
+	stack->index = stackIndex - 1;
+	PROFILE_PIPELINE_END(pipeline);
+	return right;
 }
@@ -3,6 +3,10 @@
 #include <ctype.h>
 
 #include "../include/expressionparser.h"
+#include "../include/pipelinestream.h"
+#include "../include/pipelinedefinition.h"
+#include "../include/pipelineincremental.h"
+#include "../include/pipelineoptimizer.h"
 
 // helper static functions
 
@@ -20,8 +24,9 @@ static char peekToken(PeekableStringSlice* input){
 		return '\0';
 	}
 
-	while (isspace(slice.str[input->cursor])) input->cursor++;
-    return slice.str[input->cursor];
+	while (input->cursor < slice.len && isspace(slice.str[input->cursor])) input->cursor++;
+	// trailing whitespace must not expose the characters behind the slice
+	return input->cursor < slice.len ? slice.str[input->cursor] : '\0';
 }
 
 static char consumeToken(PeekableStringSlice* input) {
@@ -37,9 +42,267 @@ static bool matchToken(PeekableStringSlice* input, char expected) {
     return false;
 }
 
+static bool matchTokenPair(PeekableStringSlice* input, char first, char second) {
+	if (peekToken(input) == first && input->cursor + 1 < input->slice.len && input->slice.str[input->cursor + 1] == second) {
+		input->cursor += 2;
+		return true;
+	}
+	return false;
+}
 
-// extern functions
-ParsingError parseConstantVariableOperationToken(Pipeline* pipeline, PeekableStringSlice* peekableSlice, PipelineVariablesSlice variables) {
+static void pushBoolPipeline(Pipeline* pipeline, const PeekableStringSlice* peekableSlice){
+	// the last step only proves a boolean result when no branch of a conditional ends here
+	Index end = pipeline->index + 1;
+	if(pipeline->index != NONE_INDEX && isBooleanStep(&pipeline->entries[pipeline->index]) && peekableSlice->conditionalEnd != end){
+		return;
+	}
+	pushPipeline(pipeline, (PipelineVariant){.type = OPERATION_NATIVE_BOOL});
+}
+
+// emits a jump with unknown target, patchJumpPipeline points it to the next emitted step
+static Index pushJumpPipeline(Pipeline* pipeline, PipelineVariantType type){
+	pushPipeline(pipeline, makeStepAsJump(type, NONE_INDEX));
+	return pipeline->index;
+}
+
+static void patchJumpPipeline(Pipeline* pipeline, PeekableStringSlice* peekableSlice, Index jumpIdx){
+	pipeline->entries[jumpIdx].asJumpTarget = pipeline->index + 1;
+	peekableSlice->conditionalEnd = pipeline->index + 1;
+}
+
+// jumps of an expanded definition body, or of the argument it ends with, can land past the expansion
+static void markExpandedConditionalEnd(const Pipeline* pipeline, PeekableStringSlice* peekableSlice, Index begin){
+	Index end = pipeline->index + 1;
+	for(Index pipelineIdx = begin; pipelineIdx < end; pipelineIdx++){
+		const PipelineVariant* variant = &pipeline->entries[pipelineIdx];
+		if(isJumpStep(variant) && variant->asJumpTarget == end){
+			peekableSlice->conditionalEnd = end;
+			return;
+		}
+	}
+}
+
+static PipelineSpans* spansOf(const PeekableStringSlice* peekableSlice){
+	return peekableSlice->context != NULL ? peekableSlice->context->spans : NULL;
+}
+
+static void recordSpan(PipelineSpans* spans, PipelineSpan span){
+	// a range an enclosing level parsed again keeps only the outermost level
+	span.reserve = spans->pendingReserve;
+	spans->pendingReserve = 0;
+	if(spans->count > 0){
+		PipelineSpan* last = &spans->entries[spans->count - 1];
+		if(last->sourceBegin == span.sourceBegin && last->sourceEnd == span.sourceEnd){
+			last->level = span.level;
+			return;
+		}
+	}
+	if(spans->count >= spans->capacity){
+		spans->overflowed = true;
+		return;
+	}
+	spans->entries[spans->count++] = span;
+}
+
+// runs one grammar level and records the span it parsed when the input carries a span table
+static ParsingError parseRecordingSpan(
+	Pipeline* pipeline,
+	PeekableStringSlice* peekableSlice,
+	PipelineVariablesSlice variables,
+	ParsingError (*parseLevel)(Pipeline*, PeekableStringSlice*, PipelineVariablesSlice),
+	SpanLevel level
+){
+	PipelineSpans* spans = spansOf(peekableSlice);
+	if(spans == NULL){
+		return parseLevel(pipeline, peekableSlice, variables);
+	}
+	peekToken(peekableSlice);
+	size_t sourceBegin = peekableSlice->cursor;
+	Index stepBegin = lengthOfPipeline(pipeline);
+	ParsingError err = parseLevel(pipeline, peekableSlice, variables);
+	if(err.type == NOERROR && !(pipeline->errorMask & OVERFLOW)){
+		recordSpan(spans, (PipelineSpan){
+			.sourceBegin = (uint16_t)sourceBegin,
+			.sourceEnd = (uint16_t)peekableSlice->cursor,
+			.stepBegin = stepBegin,
+			.stepEnd = lengthOfPipeline(pipeline),
+			.level = (uint8_t)level,
+			.reserve = 0
+		});
+	}
+	return err;
+}
+
+static ParsingError parseBinaryTokens(
+	Pipeline* pipeline,
+	PeekableStringSlice* peekableSlice,
+	PipelineVariablesSlice variables,
+	ParsingError (*parseOperand)(Pipeline*, PeekableStringSlice*, PipelineVariablesSlice),
+	const char tokens[][2],
+	const PipelineVariantType types[],
+	size_t tokenCount
+){
+	ParsingError err = parseOperand(pipeline, peekableSlice, variables);
+	if(err.type != NOERROR){
+		return err;
+	}
+	while (1) {
+		size_t tokenIdx = 0;
+		for(; tokenIdx < tokenCount; tokenIdx++){
+			// two character tokens are listed before their one character prefixes
+			bool matched = tokens[tokenIdx][1] != '\0'
+				? matchTokenPair(peekableSlice, tokens[tokenIdx][0], tokens[tokenIdx][1])
+				: matchToken(peekableSlice, tokens[tokenIdx][0]);
+			if(matched){
+				break;
+			}
+		}
+		if(tokenIdx == tokenCount){
+			break;
+		}
+		err = parseOperand(pipeline, peekableSlice, variables);
+		if(err.type != NOERROR){
+			return err;
+		}
+		pushPipeline(pipeline, (PipelineVariant){.type = types[tokenIdx]});
+		if(pipeline->errorMask & OVERFLOW){
+			return PARSING_ERROR(PIPELINE_FULL, peekableSlice->cursor, peekToken(peekableSlice));
+		}
+	}
+	return err;
+}
+
+static bool parseConstantArgument(PeekableStringSlice* peekableSlice, uint16_t* value){
+	if(!isdigit(peekToken(peekableSlice))){
+		return false;
+	}
+	StringSlice constantSlice = {.str = &peekableSlice->slice.str[peekableSlice->cursor], .len = 0};
+	while (isdigit(peekToken(peekableSlice))) {
+		consumeToken(peekableSlice);
+		constantSlice.len++;
+	}
+	ValueType constantValue;
+	if(!sliceToInt(constantSlice, &constantValue) || constantValue < 1 || constantValue > UINT16_MAX){
+		return false;
+	}
+	*value = (uint16_t)constantValue;
+	return true;
+}
+
+// history functions of stream expressions, `handled` stays false for any other name
+static ParsingError parseStreamToken(Pipeline* pipeline, PeekableStringSlice* peekableSlice, PipelineVariablesSlice variables, StringSlice name, bool* handled){
+	static const struct {
+		StringSlice name;
+		StreamSlotKind kind;
+	} streamFunctions[] = {
+		{MAKE_SLICE_FROM_CONST_STRING("prev"), STREAM_PREV},
+		{MAKE_SLICE_FROM_CONST_STRING("delta"), STREAM_DELTA},
+		{MAKE_SLICE_FROM_CONST_STRING("sum"), STREAM_SUM},
+		{MAKE_SLICE_FROM_CONST_STRING("avg"), STREAM_AVG},
+		{MAKE_SLICE_FROM_CONST_STRING("out"), STREAM_OUT}
+	};
+
+	*handled = false;
+	size_t functionIdx = 0;
+	for(; functionIdx < ARRAY_CONST_SIZE(streamFunctions); functionIdx++){
+		if(isSliceEqual(streamFunctions[functionIdx].name, name)){
+			break;
+		}
+	}
+	if(functionIdx == ARRAY_CONST_SIZE(streamFunctions)){
+		return NO_PARSING_ERROR;
+	}
+	*handled = true;
+	StreamSlotKind kind = streamFunctions[functionIdx].kind;
+
+	if(!matchToken(peekableSlice, '(')){
+		return PARSING_ERROR(UNEXPECTED, peekableSlice->cursor, peekToken(peekableSlice));
+	}
+
+	Index source = NONE_INDEX;
+	uint16_t param = 1;
+	if(kind != STREAM_OUT){
+		char varName = peekToken(peekableSlice);
+		for(int8_t varIdx = 0; varIdx < variables.len; varIdx++){
+			if(variables.vars[varIdx].name == varName){
+				source = varIdx;
+				break;
+			}
+		}
+		if(source == NONE_INDEX || !isalpha(varName)){
+			return PARSING_ERROR(UNKNOWN_VARIABLE, peekableSlice->cursor, varName);
+		}
+		consumeToken(peekableSlice);
+	}
+
+	bool needsParam = kind == STREAM_SUM || kind == STREAM_AVG || kind == STREAM_OUT;
+	bool hasParam = kind == STREAM_OUT || matchToken(peekableSlice, ',');
+	if(needsParam && !hasParam){
+		return PARSING_ERROR(TOO_LITTLE_ARGUMENTS, peekableSlice->cursor, peekToken(peekableSlice));
+	}
+	if(hasParam && kind == STREAM_DELTA){
+		return PARSING_ERROR(TOO_MANY_ARGUMENTS, peekableSlice->cursor, peekToken(peekableSlice));
+	}
+	if(hasParam && !parseConstantArgument(peekableSlice, &param)){
+		return PARSING_ERROR(UNEXPECTED, peekableSlice->cursor, peekToken(peekableSlice));
+	}
+	if(!matchToken(peekableSlice, ')')){
+		return PARSING_ERROR(UNEXPECTED, peekableSlice->cursor, peekToken(peekableSlice));
+	}
+
+	Index slotVariable = addStreamSlot(peekableSlice->context->stream, kind, source, param);
+	if(slotVariable == NONE_INDEX){
+		return PARSING_ERROR(HISTORY_FULL, peekableSlice->cursor, peekToken(peekableSlice));
+	}
+	pushPipeline(pipeline, makeStepAsVariableIndex(slotVariable));
+	if(pipeline->errorMask & OVERFLOW){
+		return PARSING_ERROR(PIPELINE_FULL, peekableSlice->cursor, peekToken(peekableSlice));
+	}
+	return NO_PARSING_ERROR;
+}
+
+static ParsingError parseDefinitionCallToken(Pipeline* pipeline, PeekableStringSlice* peekableSlice, PipelineVariablesSlice variables, const PipelineDefinition* definition){
+	if(!matchToken(peekableSlice, '(')){
+		return PARSING_ERROR(UNEXPECTED, peekableSlice->cursor, peekToken(peekableSlice));
+	}
+	PipelineSpans* spans = spansOf(peekableSlice);
+	uint16_t spanCount = spans != NULL ? spans->count : 0;
+	// arguments are compiled in place and replaced by the expanded body afterwards
+	Index argBegins[PIPELINE_DEFINITION_MAX_PARAMS];
+	uint8_t argCount = 0;
+	if(!matchToken(peekableSlice, ')')){
+		do {
+			if(argCount >= definition->paramCount){
+				return PARSING_ERROR(TOO_MANY_ARGUMENTS, peekableSlice->cursor, peekToken(peekableSlice));
+			}
+			argBegins[argCount++] = lengthOfPipeline(pipeline);
+			ParsingError err = compileExpression(pipeline, peekableSlice, variables);
+			if(err.type != NOERROR){
+				return err;
+			}
+		} while(matchToken(peekableSlice, ','));
+		if(!matchToken(peekableSlice, ')')){
+			return PARSING_ERROR(UNEXPECTED, peekableSlice->cursor, peekToken(peekableSlice));
+		}
+	}
+	if(argCount != definition->paramCount){
+		return PARSING_ERROR(TOO_LITTLE_ARGUMENTS, peekableSlice->cursor, peekToken(peekableSlice));
+	}
+	Index argsBegin = argCount > 0 ? argBegins[0] : lengthOfPipeline(pipeline);
+	Index argsLength = (Index)(lengthOfPipeline(pipeline) - argsBegin);
+	if(!inlinePipelineDefinition(pipeline, peekableSlice->context->definitions, definition, argBegins)){
+		return PARSING_ERROR(PIPELINE_FULL, peekableSlice->cursor, peekToken(peekableSlice));
+	}
+	markExpandedConditionalEnd(pipeline, peekableSlice, argsBegin);
+	// the argument steps moved into the expansion, only the whole call keeps a span
+	if(spans != NULL){
+		spans->count = spanCount;
+		spans->pendingReserve = argsLength;
+	}
+	return NO_PARSING_ERROR;
+}
+
+static ParsingError parsePrimaryLevel(Pipeline* pipeline, PeekableStringSlice* peekableSlice, PipelineVariablesSlice variables) {
     if (isdigitforsign(peekToken(peekableSlice))) {
 		StringSlice constantSlice = {.str = &peekableSlice->slice.str[peekableSlice->cursor], .len = 0};
         while (isdigit(peekToken(peekableSlice))) {
@@ -77,6 +340,21 @@ ParsingError parseConstantVariableOperationToken(Pipeline* pipeline, PeekableStr
 			}
 			return PARSING_ERROR(UNKNOWN_VARIABLE, peekableSlice->cursor-1, operationOrVariableSlice.str[0]);
 		}
+
+		if(peekableSlice->context != NULL && peekableSlice->context->definitions != NULL){
+			const PipelineDefinition* definition = findPipelineDefinition(peekableSlice->context->definitions, operationOrVariableSlice);
+			if(definition != NULL){
+				return parseDefinitionCallToken(pipeline, peekableSlice, variables, definition);
+			}
+		}
+
+		if(peekableSlice->context != NULL && peekableSlice->context->stream != NULL){
+			bool handled;
+			ParsingError err = parseStreamToken(pipeline, peekableSlice, variables, operationOrVariableSlice, &handled);
+			if(handled){
+				return err;
+			}
+		}
 	
         PipelineOperation op = getOperationByName(operationOrVariableSlice);
 
@@ -122,7 +400,7 @@ ParsingError parseConstantVariableOperationToken(Pipeline* pipeline, PeekableStr
 				return PARSING_ERROR(UNEXPECTED, peekableSlice->cursor, peekToken(peekableSlice));
 			}
 
-			pushPipeline(pipeline, makeStepAsOperation(op));
+			pushPipeline(pipeline, makeStepAsOperation(op, (uint8_t)opArgCount));
 			if(pipeline->errorMask & OVERFLOW){
 				return PARSING_ERROR(PIPELINE_FULL, peekableSlice->cursor, peekToken(peekableSlice));
 			}
@@ -147,7 +425,7 @@ ParsingError parseConstantVariableOperationToken(Pipeline* pipeline, PeekableStr
 }
 
 
-ParsingError parseMulDivToken(Pipeline* pipeline, PeekableStringSlice* peekableSlice, PipelineVariablesSlice variables) {
+static ParsingError parseMulDivLevel(Pipeline* pipeline, PeekableStringSlice* peekableSlice, PipelineVariablesSlice variables) {
     ParsingError err = parseConstantVariableOperationToken(pipeline, peekableSlice, variables);
     while (1) {
         if (matchToken(peekableSlice, '*')) {
@@ -187,7 +465,7 @@ ParsingError parseMulDivToken(Pipeline* pipeline, PeekableStringSlice* peekableS
 }
 
 
-ParsingError parseAddSubToken(Pipeline* pipeline, PeekableStringSlice* peekableSlice, PipelineVariablesSlice variables){
+static ParsingError parseAddSubLevel(Pipeline* pipeline, PeekableStringSlice* peekableSlice, PipelineVariablesSlice variables){
 	ParsingError err = parseMulDivToken(pipeline, peekableSlice, variables);
     while (1) {
         if (matchToken(peekableSlice, '+')) {
@@ -216,11 +494,147 @@ ParsingError parseAddSubToken(Pipeline* pipeline, PeekableStringSlice* peekableS
 
 }
 
+static ParsingError parseRelationalLevel(Pipeline* pipeline, PeekableStringSlice* peekableSlice, PipelineVariablesSlice variables){
+	static const char tokens[][2] = {{'<', '='}, {'>', '='}, {'<', '\0'}, {'>', '\0'}};
+	static const PipelineVariantType types[] = {OPERATION_NATIVE_LE, OPERATION_NATIVE_GE, OPERATION_NATIVE_LT, OPERATION_NATIVE_GT};
+	return parseBinaryTokens(pipeline, peekableSlice, variables, parseAddSubToken, tokens, types, ARRAY_CONST_SIZE(types));
+}
+
+static ParsingError parseEqualityLevel(Pipeline* pipeline, PeekableStringSlice* peekableSlice, PipelineVariablesSlice variables){
+	static const char tokens[][2] = {{'=', '='}, {'!', '='}};
+	static const PipelineVariantType types[] = {OPERATION_NATIVE_EQ, OPERATION_NATIVE_NE};
+	return parseBinaryTokens(pipeline, peekableSlice, variables, parseRelationalToken, tokens, types, ARRAY_CONST_SIZE(types));
+}
+
+static ParsingError parseLogicalAndLevel(Pipeline* pipeline, PeekableStringSlice* peekableSlice, PipelineVariablesSlice variables){
+	ParsingError err = parseEqualityToken(pipeline, peekableSlice, variables);
+	if(err.type != NOERROR){
+		return err;
+	}
+	while (matchTokenPair(peekableSlice, '&', '&')) {
+		// a zero left side is already the result, otherwise the right side decides
+		Index jumpIdx = pushJumpPipeline(pipeline, JUMP_IF_ZERO_OR_POP);
+		err = parseEqualityToken(pipeline, peekableSlice, variables);
+		if(err.type != NOERROR){
+			return err;
+		}
+		pushBoolPipeline(pipeline, peekableSlice);
+		if(pipeline->errorMask & OVERFLOW){
+			return PARSING_ERROR(PIPELINE_FULL, peekableSlice->cursor, peekToken(peekableSlice));
+		}
+		patchJumpPipeline(pipeline, peekableSlice, jumpIdx);
+	}
+	return err;
+}
+
+static ParsingError parseLogicalOrLevel(Pipeline* pipeline, PeekableStringSlice* peekableSlice, PipelineVariablesSlice variables){
+	ParsingError err = parseLogicalAndToken(pipeline, peekableSlice, variables);
+	if(err.type != NOERROR){
+		return err;
+	}
+	while (matchTokenPair(peekableSlice, '|', '|')) {
+		// the left side is normalized first so a kept non zero value reads as 1
+		pushBoolPipeline(pipeline, peekableSlice);
+		Index jumpIdx = pushJumpPipeline(pipeline, JUMP_IF_NONZERO_OR_POP);
+		err = parseLogicalAndToken(pipeline, peekableSlice, variables);
+		if(err.type != NOERROR){
+			return err;
+		}
+		pushBoolPipeline(pipeline, peekableSlice);
+		if(pipeline->errorMask & OVERFLOW){
+			return PARSING_ERROR(PIPELINE_FULL, peekableSlice->cursor, peekToken(peekableSlice));
+		}
+		patchJumpPipeline(pipeline, peekableSlice, jumpIdx);
+	}
+	return err;
+}
+
+static ParsingError parseConditionalLevel(Pipeline* pipeline, PeekableStringSlice* peekableSlice, PipelineVariablesSlice variables){
+	ParsingError err = parseLogicalOrToken(pipeline, peekableSlice, variables);
+	if(err.type != NOERROR || !matchToken(peekableSlice, '?')){
+		return err;
+	}
+	Index falseJumpIdx = pushJumpPipeline(pipeline, JUMP_IF_ZERO);
+	err = parseConditionalToken(pipeline, peekableSlice, variables);
+	if(err.type != NOERROR){
+		return err;
+	}
+	if(!matchToken(peekableSlice, ':')){
+		return PARSING_ERROR(UNEXPECTED, peekableSlice->cursor, peekToken(peekableSlice));
+	}
+	Index endJumpIdx = pushJumpPipeline(pipeline, JUMP);
+	if(pipeline->errorMask & OVERFLOW){
+		return PARSING_ERROR(PIPELINE_FULL, peekableSlice->cursor, peekToken(peekableSlice));
+	}
+	patchJumpPipeline(pipeline, peekableSlice, falseJumpIdx);
+	err = parseConditionalToken(pipeline, peekableSlice, variables);
+	if(err.type != NOERROR){
+		return err;
+	}
+	if(pipeline->errorMask & OVERFLOW){
+		return PARSING_ERROR(PIPELINE_FULL, peekableSlice->cursor, peekToken(peekableSlice));
+	}
+	patchJumpPipeline(pipeline, peekableSlice, endJumpIdx);
+	return err;
+}
+
+// extern functions
+
+ParsingError parseConstantVariableOperationToken(Pipeline* pipeline, PeekableStringSlice* peekableSlice, PipelineVariablesSlice variables){
+	return parseRecordingSpan(pipeline, peekableSlice, variables, parsePrimaryLevel, SPAN_PRIMARY);
+}
+
+ParsingError parseMulDivToken(Pipeline* pipeline, PeekableStringSlice* peekableSlice, PipelineVariablesSlice variables){
+	return parseRecordingSpan(pipeline, peekableSlice, variables, parseMulDivLevel, SPAN_MUL_DIV);
+}
+
+ParsingError parseAddSubToken(Pipeline* pipeline, PeekableStringSlice* peekableSlice, PipelineVariablesSlice variables){
+	return parseRecordingSpan(pipeline, peekableSlice, variables, parseAddSubLevel, SPAN_ADD_SUB);
+}
+
+ParsingError parseRelationalToken(Pipeline* pipeline, PeekableStringSlice* peekableSlice, PipelineVariablesSlice variables){
+	return parseRecordingSpan(pipeline, peekableSlice, variables, parseRelationalLevel, SPAN_RELATIONAL);
+}
+
+ParsingError parseEqualityToken(Pipeline* pipeline, PeekableStringSlice* peekableSlice, PipelineVariablesSlice variables){
+	return parseRecordingSpan(pipeline, peekableSlice, variables, parseEqualityLevel, SPAN_EQUALITY);
+}
+
+ParsingError parseLogicalAndToken(Pipeline* pipeline, PeekableStringSlice* peekableSlice, PipelineVariablesSlice variables){
+	return parseRecordingSpan(pipeline, peekableSlice, variables, parseLogicalAndLevel, SPAN_LOGICAL_AND);
+}
+
+ParsingError parseLogicalOrToken(Pipeline* pipeline, PeekableStringSlice* peekableSlice, PipelineVariablesSlice variables){
+	return parseRecordingSpan(pipeline, peekableSlice, variables, parseLogicalOrLevel, SPAN_LOGICAL_OR);
+}
+
+ParsingError parseConditionalToken(Pipeline* pipeline, PeekableStringSlice* peekableSlice, PipelineVariablesSlice variables){
+	return parseRecordingSpan(pipeline, peekableSlice, variables, parseConditionalLevel, SPAN_CONDITIONAL);
+}
+
+bool isBooleanStep(const PipelineVariant* variant){
+	switch (variant->type)
+	{
+		case OPERATION_NATIVE_LT:
+		case OPERATION_NATIVE_LE:
+		case OPERATION_NATIVE_GT:
+		case OPERATION_NATIVE_GE:
+		case OPERATION_NATIVE_EQ:
+		case OPERATION_NATIVE_NE:
+		case OPERATION_NATIVE_BOOL:
+			return true;
+		default:
+			return false;
+	}
+}
+
 ParsingError compileExpression(Pipeline* pipeline, PeekableStringSlice* peekableSlice, PipelineVariablesSlice variables){
 	if(peekableSlice->slice.len == 0 || peekableSlice->slice.str == NULL){
 		return PARSING_ERROR(INPUT_EMPTY, 0, ' ');
 	}
-	return parseAddSubToken(pipeline, peekableSlice, variables);
+	// jumps patched before this expression land before its first step
+	peekableSlice->conditionalEnd = 0;
+	return parseConditionalToken(pipeline, peekableSlice, variables);
 }
 
 void validateStackSizeWithPipeline(PipelineStack *stack, const Pipeline *pipeline){
@@ -245,7 +659,7 @@ void validateStackSizeWithPipeline(PipelineStack *stack, const Pipeline *pipelin
 				break;
 			case OPERATION:
 				{
-					size_t argCount = getMetaByOperation(variant->asOperation).argCount;
+					size_t argCount = variant->asOperationArgCount;
 					for(size_t argPop = 0; argPop < argCount; argPop++){
 						popStack(stack);
 						if(pipeline->errorMask != NO_ERROR || stack->errorMask != NO_ERROR){
@@ -255,8 +669,27 @@ void validateStackSizeWithPipeline(PipelineStack *stack, const Pipeline *pipelin
 					pushStack(stack, 1);
 				}
 				break;
+			case JUMP:
+				// the false branch starts from the depth before the true branch pushed its value
+				popStack(stack);
+				break;
+			case JUMP_IF_ZERO:
+			case JUMP_IF_ZERO_OR_POP:
+			case JUMP_IF_NONZERO_OR_POP:
+				// walks the fall through path, which pops the condition
+				popStack(stack);
+				break;
 			case NONE:
 				return;
+			default:
+				{
+					uint8_t argCount = getStepArgCount(variant);
+					for(uint8_t argPop = 0; argPop < argCount; argPop++){
+						popStack(stack);
+					}
+					pushStack(stack, 1);
+				}
+				break;
 
 			if(pipeline->errorMask != NO_ERROR || stack->errorMask != NO_ERROR){
 				return;
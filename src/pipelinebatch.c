@@ -0,0 +1,349 @@
+#include "../include/pipelinebatch.h"
+#include "../include/pipelineoptimizer.h"
+
+// helper static functions
+
+typedef struct {
+	Index begin;
+	bool uniform;
+	// contains a division that may trap, evaluated only when the branch holding it is taken
+	bool mayFault;
+} HoistOperand;
+
+static bool isDivisionStep(PipelineVariantType type){
+	return type == OPERATION_NATIVE_DIV || type == OPERATION_NATIVE_MOD;
+}
+
+// position among the arguments of the divisor of a step that traps on a zero divisor or INT32_MIN / -1,
+// NONE_INDEX for steps that never trap
+static Index getTrappingDivisorArg(const PipelineVariant* variant){
+	switch (variant->type)
+	{
+		case OPERATION_NATIVE_DIV:
+		case OPERATION_NATIVE_MOD:
+		case OPERATION_NATIVE_DIV16:
+		case OPERATION_NATIVE_MOD16:
+			return 1;
+		case OPERATION_NATIVE_RDIV:
+		case OPERATION_NATIVE_RMOD:
+			return 0;
+		case OPERATION:
+			return variant->asOperation == opDiv || variant->asOperation == opMod ? 1 : NONE_INDEX;
+		default:
+			return NONE_INDEX;
+	}
+}
+
+static bool isProvenDivisor(const Pipeline* source, Index begin, Index end){
+	const PipelineVariant* divisor = &source->entries[begin];
+	return begin == end && divisor->type == CONSTANT && divisor->asConstant != 0 && divisor->asConstant != -1;
+}
+
+static void addHoisted(HoistedPipeline* hoisted, Index begin, Index end, PipelineVariantType divisionType){
+	if(hoisted->hoistedCount >= PIPELINE_MAX_HOISTED){
+		// leftovers are simply evaluated per row
+		return;
+	}
+	// keep ordered by position, subexpressions found later can start earlier
+	uint8_t at = hoisted->hoistedCount;
+	while(at > 0 && hoisted->hoisted[at - 1].sourceBegin > begin){
+		hoisted->hoisted[at] = hoisted->hoisted[at - 1];
+		at--;
+	}
+	hoisted->hoisted[at] = (HoistedExpression){.sourceBegin = begin, .sourceEnd = end, .divisionType = divisionType};
+	hoisted->hoistedCount++;
+}
+
+// operand consumed by a jump or ending a conditional region, hoisted when uniform and not a single step,
+// hoisted operands are evaluated unconditionally so one inside a branch must not be able to trap
+static void hoistBranchTail(HoistedPipeline* hoisted, const HoistOperand* operand, Index end, bool inBranch){
+	if(operand->uniform && operand->begin != end && !(inBranch && operand->mayFault)){
+		addHoisted(hoisted, operand->begin, end, NONE);
+	}
+}
+
+static ValueType evaluateRange(const Pipeline* source, Index begin, Index end, PipelineStack* stack, PipelineVariablesSlice variables){
+	Pipeline range = {
+		.index = end - begin,
+		.capacity = end - begin + 1,
+		.errorMask = NO_ERROR,
+		.entries = &source->entries[begin]
+	};
+	return executePipeline(&range, stack, variables);
+}
+
+static ValueType getSweepPoint(const PipelineSweep* sweep, size_t pointIdx){
+	return (ValueType)((uint32_t)sweep->start + (uint32_t)sweep->step * (uint32_t)pointIdx);
+}
+
+static void sweepWithDegree(const Pipeline* pipeline, PipelineStack* stack, PipelineVariable variables[], int8_t variablesLen, const PipelineSweep* sweep, uint8_t degree, ValueType results[]){
+	PipelineVariablesSlice slice = {variables, variablesLen};
+	if(degree == PIPELINE_NOT_POLYNOMIAL || sweep->count <= (size_t)degree + 1){
+		for(size_t pointIdx = 0; pointIdx < sweep->count; pointIdx++){
+			variables[sweep->variable].value = getSweepPoint(sweep, pointIdx);
+			results[pointIdx] = executePipeline(pipeline, stack, slice);
+		}
+		return;
+	}
+
+	// differences[k] is the k-th forward difference at the current point, seeded from the first
+	// degree + 1 points, the difference of order degree is constant
+	uint32_t differences[PIPELINE_SWEEP_MAX_DEGREE + 1];
+	for(uint8_t order = 0; order <= degree; order++){
+		variables[sweep->variable].value = getSweepPoint(sweep, order);
+		differences[order] = (uint32_t)executePipeline(pipeline, stack, slice);
+	}
+	for(uint8_t order = 1; order <= degree; order++){
+		for(uint8_t at = degree; at >= order; at--){
+			differences[at] -= differences[at - 1];
+		}
+	}
+
+	results[0] = (ValueType)differences[0];
+	for(size_t pointIdx = 1; pointIdx < sweep->count; pointIdx++){
+		for(uint8_t order = 0; order < degree; order++){
+			differences[order] += differences[order + 1];
+		}
+		results[pointIdx] = (ValueType)differences[0];
+	}
+}
+
+// extern functions
+
+void executePipelineBatch(const Pipeline* pipeline, PipelineStack* stack, PipelineVariable variables[], int8_t variablesLen, const ValueType* const columns[], size_t rowCount, ValueType results[]){
+	Index varying[INT8_MAX];
+	uint8_t varyingCount = 0;
+	for(int8_t varIdx = 0; varIdx < variablesLen; varIdx++){
+		if(columns[varIdx] != NULL){
+			varying[varyingCount++] = varIdx;
+		}
+	}
+
+	PipelineVariablesSlice slice = {variables, variablesLen};
+	for(size_t row = 0; row < rowCount; row++){
+		for(uint8_t idx = 0; idx < varyingCount; idx++){
+			Index varIdx = varying[idx];
+			variables[varIdx].value = columns[varIdx][row];
+		}
+		results[row] = executePipeline(pipeline, stack, slice);
+	}
+}
+
+uint8_t getPipelinePolynomialDegree(const Pipeline* pipeline, Index variable){
+	if(pipeline->index == NONE_INDEX){
+		return PIPELINE_NOT_POLYNOMIAL;
+	}
+	uint8_t degrees[PIPELINE_STACK_SIZE];
+	uint8_t depth = 0;
+	uint8_t pipelineLength = pipeline->index + 1;
+	for(Index pipelineIdx = 0; pipelineIdx < pipelineLength; pipelineIdx++){
+		const PipelineVariant* variant = &pipeline->entries[pipelineIdx];
+		if(isJumpStep(variant) || variant->type == NONE){
+			return PIPELINE_NOT_POLYNOMIAL;
+		}
+		uint8_t argCount = getStepArgCount(variant);
+		if(argCount > depth){
+			return PIPELINE_NOT_POLYNOMIAL;
+		}
+		uint8_t* args = &degrees[depth - argCount];
+		uint8_t degree = 0;
+		switch (variant->type)
+		{
+			case CONSTANT:
+				break;
+			case VARIABLE_INDEX:
+				degree = variant->asVariableIndex == variable ? 1 : 0;
+				break;
+			case OPERATION_NATIVE_ADD:
+			case OPERATION_NATIVE_SUB:
+			case OPERATION_NATIVE_RSUB:
+				degree = args[0] > args[1] ? args[0] : args[1];
+				break;
+			case OPERATION_NATIVE_MUL:
+				degree = args[0] + args[1];
+				break;
+			case OPERATION_NATIVE_SHL:
+				degree = args[0];
+				break;
+			default:
+				// piecewise or opaque, fine only while the swept variable does not reach it
+				for(uint8_t arg = 0; arg < argCount; arg++){
+					if(args[arg] != 0){
+						return PIPELINE_NOT_POLYNOMIAL;
+					}
+				}
+				break;
+		}
+		if(degree > PIPELINE_SWEEP_MAX_DEGREE){
+			return PIPELINE_NOT_POLYNOMIAL;
+		}
+		depth -= argCount;
+		if(depth >= PIPELINE_STACK_SIZE){
+			return PIPELINE_NOT_POLYNOMIAL;
+		}
+		degrees[depth++] = degree;
+	}
+	return depth == 1 ? degrees[0] : PIPELINE_NOT_POLYNOMIAL;
+}
+
+void executePipelineSweep(const Pipeline* pipeline, PipelineStack* stack, PipelineVariable variables[], int8_t variablesLen, PipelineSweep sweep, ValueType results[]){
+	uint8_t degree = getPipelinePolynomialDegree(pipeline, sweep.variable);
+	sweepWithDegree(pipeline, stack, variables, variablesLen, &sweep, degree, results);
+}
+
+void executePipelineGrid(const Pipeline* pipeline, PipelineStack* stack, PipelineVariable variables[], int8_t variablesLen, PipelineSweep outer, PipelineSweep inner, ValueType results[]){
+	uint8_t degree = getPipelinePolynomialDegree(pipeline, inner.variable);
+	for(size_t outerIdx = 0; outerIdx < outer.count; outerIdx++){
+		variables[outer.variable].value = getSweepPoint(&outer, outerIdx);
+		sweepWithDegree(pipeline, stack, variables, variablesLen, &inner, degree, &results[outerIdx * inner.count]);
+	}
+}
+
+void hoistUniformPipeline(HoistedPipeline* hoisted, const Pipeline* source, PipelineVariant perRowStorage[], uint8_t perRowCapacity, const bool uniform[]){
+	hoisted->source = source;
+	hoisted->perRow = createPipeline(perRowStorage, perRowCapacity);
+	hoisted->hoistedCount = 0;
+	if(source->index == NONE_INDEX){
+		return;
+	}
+
+	HoistOperand operands[PIPELINE_STACK_SIZE];
+	uint8_t depth = 0;
+	ControlFlowTracker controlFlow;
+	initControlFlow(&controlFlow);
+	Index regionBegin;
+
+	uint8_t pipelineLength = source->index + 1;
+	for(Index pipelineIdx = 0; pipelineIdx < pipelineLength; pipelineIdx++){
+		const PipelineVariant* variant = &source->entries[pipelineIdx];
+		// conditionals are evaluated per row, uniform parts inside their branches still get hoisted
+		while(depth > 0 && mergeControlFlow(&controlFlow, pipelineIdx, &regionBegin)){
+			hoistBranchTail(hoisted, &operands[depth - 1], pipelineIdx - 1, true);
+			operands[depth - 1] = (HoistOperand){.begin = regionBegin, .uniform = false, .mayFault = true};
+		}
+		bool inBranch = controlFlow.count > 0;
+		if(isJumpStep(variant)){
+			if(depth == 0){
+				hoisted->hoistedCount = 0;
+				return;
+			}
+			depth--;
+			hoistBranchTail(hoisted, &operands[depth], pipelineIdx - 1, inBranch);
+			enterControlFlow(&controlFlow, variant, operands[depth].begin);
+			continue;
+		}
+
+		uint8_t argCount = getStepArgCount(variant);
+		if(argCount > depth){
+			// malformed pipeline, nothing is hoisted
+			hoisted->hoistedCount = 0;
+			return;
+		}
+
+		HoistOperand result = {.begin = pipelineIdx, .uniform = true, .mayFault = false};
+		if(variant->type == VARIABLE_INDEX){
+			result.uniform = uniform[variant->asVariableIndex];
+		}
+		uint8_t firstArg = depth - argCount;
+		for(uint8_t arg = firstArg; arg < depth; arg++){
+			result.uniform = result.uniform && operands[arg].uniform;
+			result.mayFault = result.mayFault || operands[arg].mayFault;
+		}
+		if(argCount > 0){
+			result.begin = operands[firstArg].begin;
+		}
+		Index divisorArg = getTrappingDivisorArg(variant);
+		if(divisorArg != NONE_INDEX && divisorArg < argCount){
+			uint8_t arg = firstArg + divisorArg;
+			Index end = (arg + 1 < depth) ? operands[arg + 1].begin - 1 : pipelineIdx - 1;
+			result.mayFault = result.mayFault || !isProvenDivisor(source, operands[arg].begin, end);
+		}
+
+		if(!result.uniform){
+			// uniform operands of a varying step are maximal, hoist those worth evaluating once
+			for(uint8_t arg = firstArg; arg < depth; arg++){
+				if(!operands[arg].uniform){
+					continue;
+				}
+				Index begin = operands[arg].begin;
+				Index end = (arg + 1 < depth) ? operands[arg + 1].begin - 1 : pipelineIdx - 1;
+				bool isDivisor = isDivisionStep(variant->type) && arg == depth - 1;
+				bool isConstantDivisor = isDivisor && begin == end && source->entries[begin].type == CONSTANT;
+				if((begin != end || isDivisor) && !isConstantDivisor && !(inBranch && operands[arg].mayFault)){
+					addHoisted(hoisted, begin, end, isDivisor ? variant->type : NONE);
+				}
+			}
+		}
+
+		depth = firstArg;
+		if(depth >= PIPELINE_STACK_SIZE){
+			hoisted->hoistedCount = 0;
+			return;
+		}
+		operands[depth++] = result;
+	}
+
+	while(depth > 0 && mergeControlFlow(&controlFlow, pipelineLength, &regionBegin)){
+		hoistBranchTail(hoisted, &operands[depth - 1], pipelineLength - 1, true);
+		operands[depth - 1] = (HoistOperand){.begin = regionBegin, .uniform = false, .mayFault = true};
+	}
+	if(depth == 1 && operands[0].uniform && pipelineLength > 1){
+		addHoisted(hoisted, 0, pipelineLength - 1, NONE);
+	}
+}
+
+void prepareHoistedPipeline(HoistedPipeline* hoisted, PipelineStack* stack, PipelineVariablesSlice variables){
+	const Pipeline* source = hoisted->source;
+	Pipeline* perRow = &hoisted->perRow;
+	clearPipeline(perRow);
+	if(source->index == NONE_INDEX){
+		return;
+	}
+
+	uint8_t pipelineLength = source->index + 1;
+	uint8_t nextHoisted = 0;
+	// position in perRow of every source step, jumps are retargeted once everything is emitted
+	Index perRowIndex[NONE_INDEX + 1];
+	for(uint16_t pipelineIdx = 0; pipelineIdx < pipelineLength;){
+		uint8_t emitted = lengthOfPipeline(perRow);
+		if(nextHoisted < hoisted->hoistedCount && hoisted->hoisted[nextHoisted].sourceBegin == pipelineIdx){
+			const HoistedExpression* expression = &hoisted->hoisted[nextHoisted++];
+			ValueType value = evaluateRange(source, expression->sourceBegin, expression->sourceEnd, stack, variables);
+			uint16_t hoistedEnd = expression->sourceEnd + 1;
+
+			PipelineVariant reduced[2];
+			uint8_t reducedCount = expression->divisionType != NONE ? reduceStepByConstant(expression->divisionType, value, reduced) : 0;
+			if(reducedCount != 0){
+				// the division step right after the divisor is replaced by its reciprocal form
+				for(uint8_t reducedIdx = 0; reducedIdx < reducedCount; reducedIdx++){
+					pushPipeline(perRow, reduced[reducedIdx]);
+				}
+				hoistedEnd++;
+			}
+			else {
+				pushPipeline(perRow, makeStepAsConstant(value));
+			}
+			for(; pipelineIdx < hoistedEnd; pipelineIdx++){
+				perRowIndex[pipelineIdx] = emitted;
+			}
+			continue;
+		}
+		perRowIndex[pipelineIdx] = emitted;
+		pushPipeline(perRow, source->entries[pipelineIdx]);
+		pipelineIdx++;
+	}
+	perRowIndex[pipelineLength] = lengthOfPipeline(perRow);
+
+	uint8_t perRowLength = lengthOfPipeline(perRow);
+	for(Index pipelineIdx = 0; pipelineIdx < perRowLength; pipelineIdx++){
+		PipelineVariant* variant = &perRow->entries[pipelineIdx];
+		if(isJumpStep(variant)){
+			variant->asJumpTarget = perRowIndex[variant->asJumpTarget];
+		}
+	}
+}
+
+void executeHoistedPipelineBatch(HoistedPipeline* hoisted, PipelineStack* stack, PipelineVariable variables[], int8_t variablesLen, const ValueType* const columns[], size_t rowCount, ValueType results[]){
+	prepareHoistedPipeline(hoisted, stack, (PipelineVariablesSlice){variables, variablesLen});
+	executePipelineBatch(&hoisted->perRow, stack, variables, variablesLen, columns, rowCount, results);
+}
@@ -0,0 +1,359 @@
+#include "../include/pipelinechecked.h"
+#include "../include/pipelinemath.h"
+#include "../include/pipelineoptimizer.h"
+
+// helper static functions
+
+// INT32_MAX for a non negative sign, INT32_MIN for a negative one
+static inline ValueType clampBySign(ValueType sign){
+	return (ValueType)((uint32_t)INT32_MAX + ((uint32_t)sign >> 31));
+}
+
+// branch free select, replaces value by replacement where mask is all ones
+static inline ValueType replaceMasked(ValueType value, ValueType replacement, ValueType mask){
+	return value ^ ((value ^ replacement) & mask);
+}
+
+static inline ValueType maskOf(bool condition){
+	return -(ValueType)condition;
+}
+
+// saturate is all ones in saturating mode and 0 in wrapping mode
+static inline ValueType checkedAdd(ValueType left, ValueType right, ValueType saturate, uint8_t* faults){
+	ValueType sum;
+	bool overflow = __builtin_add_overflow(left, right, &sum);
+	*faults |= (uint8_t)overflow * ARITHMETIC_OVERFLOW;
+	// both operands share the sign of the overflow
+	return replaceMasked(sum, clampBySign(left), maskOf(overflow) & saturate);
+}
+
+static inline ValueType checkedSub(ValueType left, ValueType right, ValueType saturate, uint8_t* faults){
+	ValueType difference;
+	bool overflow = __builtin_sub_overflow(left, right, &difference);
+	*faults |= (uint8_t)overflow * ARITHMETIC_OVERFLOW;
+	// only operands of opposite signs overflow, towards the sign of left
+	return replaceMasked(difference, clampBySign(left), maskOf(overflow) & saturate);
+}
+
+static inline ValueType checkedMul(ValueType left, ValueType right, ValueType saturate, uint8_t* faults){
+	ValueType product;
+	bool overflow = __builtin_mul_overflow(left, right, &product);
+	*faults |= (uint8_t)overflow * ARITHMETIC_OVERFLOW;
+	return replaceMasked(product, clampBySign(left ^ right), maskOf(overflow) & saturate);
+}
+
+static inline ValueType checkedShiftLeft(ValueType left, const ConstantDivisor* divisor, ValueType saturate, uint8_t* faults){
+	ValueType shifted = shiftLeftByConstant(left, divisor);
+	bool overflow = (shifted >> divisor->shift) != left;
+	*faults |= (uint8_t)overflow * ARITHMETIC_OVERFLOW;
+	return replaceMasked(shifted, clampBySign(left), maskOf(overflow) & saturate);
+}
+
+static inline ValueType checkedDiv(ValueType left, ValueType right, ValueType saturate, uint8_t* faults){
+	bool zero = right == 0;
+	bool overflow = (left == INT32_MIN) & (right == -1);
+	*faults |= (uint8_t)zero * ARITHMETIC_DIVISION_BY_ZERO | (uint8_t)overflow * ARITHMETIC_OVERFLOW;
+	// a faulting divisor is replaced by 1, which already gives the wrapped INT32_MIN / -1
+	ValueType quotient = left / replaceMasked(right, 1, maskOf(zero | overflow));
+	quotient = replaceMasked(quotient, INT32_MAX, maskOf(overflow) & saturate);
+	ValueType zeroQuotient = clampBySign(left) & maskOf(left != 0) & saturate;
+	return replaceMasked(quotient, zeroQuotient, maskOf(zero));
+}
+
+static inline ValueType checkedMod(ValueType left, ValueType right, uint8_t* faults){
+	bool zero = right == 0;
+	*faults |= (uint8_t)zero * ARITHMETIC_DIVISION_BY_ZERO;
+	// INT32_MIN % -1 is 0 like any remainder by 1, which also stands in for the zero divisor
+	return left % replaceMasked(right, 1, maskOf(zero | (right == -1)));
+}
+
+static inline bool isProvenStep(const CheckedPipeline* checked, Index pipelineIdx){
+	return (checked->provenSteps[pipelineIdx / 32] >> (pipelineIdx % 32)) & 1;
+}
+
+static inline void markProvenStep(CheckedPipeline* checked, Index pipelineIdx){
+	checked->provenSteps[pipelineIdx / 32] |= (uint32_t)1 << (pipelineIdx % 32);
+}
+
+// `x c DIV` and `x c MOD` with c other than 0 and -1 never fault, unless a jump lands on the division
+// and c is only one of the values reaching it
+static void markConstantDivisors(CheckedPipeline* checked, const Pipeline* pipeline){
+	uint32_t targets[ARRAY_CONST_SIZE(checked->provenSteps)] = {0};
+	uint8_t pipelineLength = lengthOfPipeline(pipeline);
+	for(Index pipelineIdx = 0; pipelineIdx < pipelineLength; pipelineIdx++){
+		const PipelineVariant* variant = &pipeline->entries[pipelineIdx];
+		if(isJumpStep(variant)){
+			targets[variant->asJumpTarget / 32] |= (uint32_t)1 << (variant->asJumpTarget % 32);
+		}
+	}
+	for(Index pipelineIdx = 1; pipelineIdx < pipelineLength; pipelineIdx++){
+		PipelineVariantType type = pipeline->entries[pipelineIdx].type;
+		const PipelineVariant* divisor = &pipeline->entries[pipelineIdx - 1];
+		bool isDivision = type == OPERATION_NATIVE_DIV || type == OPERATION_NATIVE_DIV16 || type == OPERATION_NATIVE_MOD || type == OPERATION_NATIVE_MOD16;
+		if(isDivision && divisor->type == CONSTANT && divisor->asConstant != 0 && divisor->asConstant != -1
+			&& !((targets[pipelineIdx / 32] >> (pipelineIdx % 32)) & 1)){
+			markProvenStep(checked, pipelineIdx);
+		}
+	}
+}
+
+// extern functions
+
+void prepareCheckedPipeline(CheckedPipeline* checked, const Pipeline* pipeline, ArithmeticMode mode, const StepRange steps[]){
+	checked->pipeline = pipeline;
+	checked->mode = mode;
+	for(uint8_t wordIdx = 0; wordIdx < ARRAY_CONST_SIZE(checked->provenSteps); wordIdx++){
+		checked->provenSteps[wordIdx] = 0;
+	}
+	markConstantDivisors(checked, pipeline);
+	if(steps == NULL){
+		return;
+	}
+	uint8_t pipelineLength = lengthOfPipeline(pipeline);
+	uint8_t proven = RANGE_NO_OVERFLOW | RANGE_NO_DIVISION_FAULT;
+	for(Index pipelineIdx = 0; pipelineIdx < pipelineLength; pipelineIdx++){
+		if(!(steps[pipelineIdx].flags & RANGE_NO_DIVISION_FAULT)){
+			// the result substituted for a faulting division is outside the analyzed range,
+			// proofs of the steps that may consume it no longer hold
+			return;
+		}
+		if((steps[pipelineIdx].flags & proven) == proven){
+			markProvenStep(checked, pipelineIdx);
+		}
+	}
+}
+
+ValueType executeCheckedPipeline(const CheckedPipeline* checked, PipelineStack* stack, PipelineVariablesSlice variables, uint8_t* errors){
+	const Pipeline* pipeline = checked->pipeline;
+	clearStack(stack);
+	// same stack layout as executePipeline, the top of the stack lives in `right`
+	ValueType right = 0;
+	ValueType left;
+	ValueType saturate = maskOf(checked->mode == ARITHMETIC_SATURATING);
+	uint8_t faults = ARITHMETIC_NO_ERROR;
+
+	ValueType* stackStorage = stack->entries;
+	Index stackIndex = stack->index;
+
+	uint8_t pipelineLength = pipeline->index + 1;
+	for(Index pipelineIdx = 0; pipelineIdx < pipelineLength; pipelineIdx++){
+		const PipelineVariant* variant = &pipeline->entries[pipelineIdx];
+		switch (variant->type)
+		{
+			case OPERATION_NATIVE_ADD:
+			case OPERATION_NATIVE_ADD16:
+				{
+					left = stackStorage[stackIndex--];
+					right = isProvenStep(checked, pipelineIdx) ? left + right : checkedAdd(left, right, saturate, &faults);
+				}
+				break;
+			case OPERATION_NATIVE_SUB:
+			case OPERATION_NATIVE_SUB16:
+				{
+					left = stackStorage[stackIndex--];
+					right = isProvenStep(checked, pipelineIdx) ? left - right : checkedSub(left, right, saturate, &faults);
+				}
+				break;
+			case OPERATION_NATIVE_MUL:
+			case OPERATION_NATIVE_MUL16:
+				{
+					left = stackStorage[stackIndex--];
+					right = isProvenStep(checked, pipelineIdx) ? left * right : checkedMul(left, right, saturate, &faults);
+				}
+				break;
+			case OPERATION_NATIVE_DIV:
+			case OPERATION_NATIVE_DIV16:
+				{
+					left = stackStorage[stackIndex--];
+					right = isProvenStep(checked, pipelineIdx) ? left / right : checkedDiv(left, right, saturate, &faults);
+				}
+				break;
+			case OPERATION_NATIVE_MOD:
+			case OPERATION_NATIVE_MOD16:
+				{
+					left = stackStorage[stackIndex--];
+					right = isProvenStep(checked, pipelineIdx) ? left % right : checkedMod(left, right, &faults);
+				}
+				break;
+			case OPERATION_NATIVE_RSUB:
+				{
+					left = stackStorage[stackIndex--];
+					right = isProvenStep(checked, pipelineIdx) ? right - left : checkedSub(right, left, saturate, &faults);
+				}
+				break;
+			case OPERATION_NATIVE_RDIV:
+				{
+					left = stackStorage[stackIndex--];
+					right = isProvenStep(checked, pipelineIdx) ? right / left : checkedDiv(right, left, saturate, &faults);
+				}
+				break;
+			case OPERATION_NATIVE_RMOD:
+				{
+					left = stackStorage[stackIndex--];
+					right = isProvenStep(checked, pipelineIdx) ? right % left : checkedMod(right, left, &faults);
+				}
+				break;
+			case OPERATION_NATIVE_SHL:
+				{
+					right = isProvenStep(checked, pipelineIdx) ? shiftLeftByConstant(right, &variant->asDivisor) : checkedShiftLeft(right, &variant->asDivisor, saturate, &faults);
+				}
+				break;
+			// constant divisors other than 0 and +-1, these never fault
+			case OPERATION_NATIVE_DIV_POW2:
+				{
+					right = divideByPow2Constant(right, &variant->asDivisor);
+				}
+				break;
+			case OPERATION_NATIVE_MOD_POW2:
+				{
+					right = moduloByPow2Constant(right, &variant->asDivisor);
+				}
+				break;
+			case OPERATION_NATIVE_DIV_MAGIC:
+				{
+					left = stackStorage[stackIndex--];
+					right = divideByMagicConstant(left, right, &variant->asDivisor);
+				}
+				break;
+			case OPERATION_NATIVE_MOD_MAGIC:
+				{
+					left = stackStorage[stackIndex--];
+					right = moduloByMagicConstant(left, right, &variant->asDivisor);
+				}
+				break;
+			case OPERATION_NATIVE_LT:
+				{
+					left = stackStorage[stackIndex--];
+					right = left < right;
+				}
+				break;
+			case OPERATION_NATIVE_LE:
+				{
+					left = stackStorage[stackIndex--];
+					right = left <= right;
+				}
+				break;
+			case OPERATION_NATIVE_GT:
+				{
+					left = stackStorage[stackIndex--];
+					right = left > right;
+				}
+				break;
+			case OPERATION_NATIVE_GE:
+				{
+					left = stackStorage[stackIndex--];
+					right = left >= right;
+				}
+				break;
+			case OPERATION_NATIVE_EQ:
+				{
+					left = stackStorage[stackIndex--];
+					right = left == right;
+				}
+				break;
+			case OPERATION_NATIVE_NE:
+				{
+					left = stackStorage[stackIndex--];
+					right = left != right;
+				}
+				break;
+			case OPERATION_NATIVE_BOOL:
+				{
+					right = right != 0;
+				}
+				break;
+			case JUMP:
+				{
+					pipelineIdx = variant->asJumpTarget - 1;
+				}
+				break;
+			case JUMP_IF_ZERO:
+				{
+					if(right == 0){
+						pipelineIdx = variant->asJumpTarget - 1;
+					}
+					right = stackStorage[stackIndex--];
+				}
+				break;
+			case JUMP_IF_ZERO_OR_POP:
+				{
+					if(right == 0){
+						pipelineIdx = variant->asJumpTarget - 1;
+					}
+					else {
+						right = stackStorage[stackIndex--];
+					}
+				}
+				break;
+			case JUMP_IF_NONZERO_OR_POP:
+				{
+					if(right != 0){
+						pipelineIdx = variant->asJumpTarget - 1;
+					}
+					else {
+						right = stackStorage[stackIndex--];
+					}
+				}
+				break;
+			case CONSTANT:
+				{
+					stackStorage[++stackIndex] = right;
+					right = variant->asConstant;
+				}
+				break;
+			case VARIABLE_INDEX:
+				{
+					stackStorage[++stackIndex] = right;
+					right = variables.vars[variant->asVariableIndex].value;
+				}
+				break;
+			case OPERATION:
+				{
+					PipelineOperation op = variant->asOperation;
+					uint8_t argCount = variant->asOperationArgCount;
+					if(op == opDiv || op == opMod){
+						left = stackStorage[stackIndex--];
+						right = op == opDiv ? checkedDiv(left, right, saturate, &faults) : checkedMod(left, right, &faults);
+					}
+					else if(argCount == 0){
+						stackStorage[++stackIndex] = right;
+						right = op(stackStorage, 0);
+					}
+					else {
+						stackIndex -= argCount - 1;
+						right = op(&stackStorage[stackIndex + 1], right);
+					}
+				}
+				break;
+			case NONE:
+				stack->index = stackIndex;
+				*errors |= faults;
+				return MISSING_VALUE;
+		}
+	}
+
+	stack->index = stackIndex - 1;
+	*errors |= faults;
+	return right;
+}
+
+void executeCheckedPipelineBatch(const CheckedPipeline* checked, PipelineStack* stack, PipelineVariable variables[], int8_t variablesLen, const ValueType* const columns[], size_t rowCount, ValueType results[], uint8_t* errors){
+	Index varying[INT8_MAX];
+	uint8_t varyingCount = 0;
+	for(int8_t varIdx = 0; varIdx < variablesLen; varIdx++){
+		if(columns[varIdx] != NULL){
+			varying[varyingCount++] = varIdx;
+		}
+	}
+
+	PipelineVariablesSlice slice = {variables, variablesLen};
+	uint8_t faults = ARITHMETIC_NO_ERROR;
+	for(size_t row = 0; row < rowCount; row++){
+		for(uint8_t idx = 0; idx < varyingCount; idx++){
+			Index varIdx = varying[idx];
+			variables[varIdx].value = columns[varIdx][row];
+		}
+		results[row] = executeCheckedPipeline(checked, stack, slice, &faults);
+	}
+	*errors |= faults;
+}
@@ -0,0 +1,351 @@
+#include "../include/pipelinecodegen.h"
+#include "../include/pipelinemath.h"
+#include "../include/pipelineoptimizer.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+
+// lines are flushed once they pass CODEGEN_LINE_WRAP, no single fragment is longer than the rest
+#define CODEGEN_LINE_SIZE 192
+#define CODEGEN_LINE_WRAP 100
+
+typedef struct {
+	CodegenWriter write;
+	void* context;
+	char line[CODEGEN_LINE_SIZE];
+	size_t length;
+} CodegenOutput;
+
+// helper static functions
+
+static void appendText(CodegenOutput* output, const char* format, ...){
+	va_list args;
+	va_start(args, format);
+	int written = vsnprintf(output->line + output->length, CODEGEN_LINE_SIZE - output->length, format, args);
+	va_end(args);
+	if(written > 0){
+		output->length += (size_t)written;
+		if(output->length >= CODEGEN_LINE_SIZE){
+			output->length = CODEGEN_LINE_SIZE - 1;
+		}
+	}
+}
+
+static void flushLine(CodegenOutput* output){
+	output->write(output->context, output->line);
+	output->length = 0;
+	output->line[0] = '\0';
+}
+
+// "sA, sB, ..." for count slots from first, wrapped onto continuation lines
+static void appendSlots(CodegenOutput* output, uint16_t first, uint16_t count){
+	for(uint16_t slot = first; slot < first + count; slot++){
+		if(output->length > CODEGEN_LINE_WRAP){
+			flushLine(output);
+			appendText(output, "\t\t");
+		}
+		appendText(output, slot + 1 < first + count ? "s%u, " : "s%u", slot);
+	}
+}
+
+static void appendConstant(CodegenOutput* output, ValueType value){
+	// -2147483648 would be the negation of a constant that does not fit int
+	if(value == INT32_MIN){
+		appendText(output, "INT32_MIN");
+	}
+	else {
+		appendText(output, "%" PRId32, value);
+	}
+}
+
+// C expression of a binary step applied to two stack slots, reversed steps swap the slots
+static const char* getBinaryFormat(PipelineVariantType type){
+	switch (type)
+	{
+		// through uint32_t so wrapping around stays defined, like the interpreter's results
+		case OPERATION_NATIVE_ADD:
+			return "(ValueType)((uint32_t)s%u + (uint32_t)s%u)";
+		case OPERATION_NATIVE_SUB:
+		case OPERATION_NATIVE_RSUB:
+			return "(ValueType)((uint32_t)s%u - (uint32_t)s%u)";
+		case OPERATION_NATIVE_MUL:
+			return "(ValueType)((uint32_t)s%u * (uint32_t)s%u)";
+		case OPERATION_NATIVE_DIV:
+		case OPERATION_NATIVE_RDIV:
+			return "s%u / s%u";
+		case OPERATION_NATIVE_MOD:
+		case OPERATION_NATIVE_RMOD:
+			return "s%u %% s%u";
+		case OPERATION_NATIVE_ADD16:
+			return "(int16_t)s%u + (int16_t)s%u";
+		case OPERATION_NATIVE_SUB16:
+			return "(int16_t)s%u - (int16_t)s%u";
+		case OPERATION_NATIVE_MUL16:
+			return "(int16_t)s%u * (int16_t)s%u";
+		case OPERATION_NATIVE_DIV16:
+			return "(int16_t)s%u / (int16_t)s%u";
+		case OPERATION_NATIVE_MOD16:
+			return "(int16_t)s%u %% (int16_t)s%u";
+		case OPERATION_NATIVE_LT:
+			return "s%u < s%u";
+		case OPERATION_NATIVE_LE:
+			return "s%u <= s%u";
+		case OPERATION_NATIVE_GT:
+			return "s%u > s%u";
+		case OPERATION_NATIVE_GE:
+			return "s%u >= s%u";
+		case OPERATION_NATIVE_EQ:
+			return "s%u == s%u";
+		case OPERATION_NATIVE_NE:
+			return "s%u != s%u";
+		default:
+			return NULL;
+	}
+}
+
+static bool isReversedStep(PipelineVariantType type){
+	return type == OPERATION_NATIVE_RSUB || type == OPERATION_NATIVE_RDIV || type == OPERATION_NATIVE_RMOD;
+}
+
+// inline helper of execpipeline.h computing a strength reduced step, NULL for other steps
+static const char* getReducedHelper(PipelineVariantType type){
+	switch (type)
+	{
+		case OPERATION_NATIVE_SHL:
+			return "shiftLeftByConstant";
+		case OPERATION_NATIVE_DIV_POW2:
+			return "divideByPow2Constant";
+		case OPERATION_NATIVE_MOD_POW2:
+			return "moduloByPow2Constant";
+		case OPERATION_NATIVE_DIV_MAGIC:
+			return "divideByMagicConstant";
+		case OPERATION_NATIVE_MOD_MAGIC:
+			return "moduloByMagicConstant";
+		default:
+			return NULL;
+	}
+}
+
+static const char* getOperationSymbol(PipelineOperation op){
+	const OperationMapEntry* entry = getEntryByOperation(op);
+	return entry != NULL ? entry->symbol : NULL;
+}
+
+// Stack depth on entry of every step (and past the end), -1 where no path arrives. Unlike the
+// optimizer's estimate both edges into a step have to agree, each depth is a fixed set of locals.
+static bool computeStepDepths(const Pipeline* pipeline, int16_t depthAt[], uint8_t* maxDepth){
+	uint8_t pipelineLength = lengthOfPipeline(pipeline);
+	for(uint16_t pipelineIdx = 0; pipelineIdx <= pipelineLength; pipelineIdx++){
+		depthAt[pipelineIdx] = -1;
+	}
+	depthAt[0] = 0;
+	*maxDepth = 0;
+
+	for(uint16_t pipelineIdx = 0; pipelineIdx < pipelineLength; pipelineIdx++){
+		const PipelineVariant* variant = &pipeline->entries[pipelineIdx];
+		int16_t depth = depthAt[pipelineIdx];
+		if(depth < 0){
+			continue;
+		}
+		int16_t fallthrough;
+		if(isJumpStep(variant)){
+			Index target = variant->asJumpTarget;
+			if((depth < 1 && variant->type != JUMP) || target <= pipelineIdx || target > pipelineLength){
+				return false;
+			}
+			int16_t jumped = variant->type == JUMP_IF_ZERO ? depth - 1 : depth;
+			if(depthAt[target] >= 0 && depthAt[target] != jumped){
+				return false;
+			}
+			depthAt[target] = jumped;
+			if(variant->type == JUMP){
+				continue;
+			}
+			fallthrough = depth - 1;
+		}
+		else if(variant->type == NONE){
+			continue;
+		}
+		else {
+			if(variant->type == OPERATION && getOperationSymbol(variant->asOperation) == NULL){
+				return false;
+			}
+			int16_t argCount = getStepArgCount(variant);
+			if(argCount > depth){
+				return false;
+			}
+			fallthrough = depth - argCount + 1;
+		}
+		if(depthAt[pipelineIdx + 1] >= 0 && depthAt[pipelineIdx + 1] != fallthrough){
+			return false;
+		}
+		depthAt[pipelineIdx + 1] = fallthrough;
+		if(fallthrough > *maxDepth){
+			*maxDepth = (uint8_t)fallthrough;
+		}
+	}
+	return pipelineLength == 0 || depthAt[pipelineLength] < 0 || depthAt[pipelineLength] == 1;
+}
+
+static bool isJumpTarget(const Pipeline* pipeline, uint16_t stepIdx){
+	uint8_t pipelineLength = lengthOfPipeline(pipeline);
+	for(uint16_t pipelineIdx = 0; pipelineIdx < stepIdx && pipelineIdx < pipelineLength; pipelineIdx++){
+		const PipelineVariant* variant = &pipeline->entries[pipelineIdx];
+		if(isJumpStep(variant) && variant->asJumpTarget == stepIdx){
+			return true;
+		}
+	}
+	return false;
+}
+
+// an operation is declared at its first call only
+static bool isFirstCall(const Pipeline* pipeline, uint16_t stepIdx){
+	PipelineOperation op = pipeline->entries[stepIdx].asOperation;
+	for(uint16_t pipelineIdx = 0; pipelineIdx < stepIdx; pipelineIdx++){
+		const PipelineVariant* variant = &pipeline->entries[pipelineIdx];
+		if(variant->type == OPERATION && variant->asOperation == op){
+			return false;
+		}
+	}
+	return true;
+}
+
+static void generateStep(CodegenOutput* output, const PipelineVariant* variant, uint16_t depth){
+	// the top of the stack is s(depth - 1)
+	uint16_t top = depth - 1;
+	const char* format = getBinaryFormat(variant->type);
+	if(format != NULL){
+		appendText(output, "\ts%u = ", depth - 2);
+		if(isReversedStep(variant->type)){
+			appendText(output, format, top, depth - 2);
+		}
+		else {
+			appendText(output, format, depth - 2, top);
+		}
+		appendText(output, ";");
+		flushLine(output);
+		return;
+	}
+	const char* helper = getReducedHelper(variant->type);
+	if(helper != NULL){
+		// same helpers as the interpreter, the constant divisor lets the compiler fold them,
+		// the magic forms read their magic number from the local its CONSTANT step assigned
+		const ConstantDivisor* divisor = &variant->asDivisor;
+		if(getStepArgCount(variant) == 2){
+			appendText(output, "\ts%u = %s(s%u, s%u, ", depth - 2, helper, depth - 2, top);
+		}
+		else {
+			appendText(output, "\ts%u = %s(s%u, ", top, helper, top);
+		}
+		appendText(output, "&(const ConstantDivisor){.divisor = %d, .shift = %u, .sign = %d});", divisor->divisor, divisor->shift, divisor->sign);
+		flushLine(output);
+		return;
+	}
+	switch (variant->type)
+	{
+		case OPERATION_NATIVE_BOOL:
+			appendText(output, "\ts%u = s%u != 0;", top, top);
+			break;
+		case JUMP:
+			appendText(output, "\tgoto L%u;", variant->asJumpTarget);
+			break;
+		case JUMP_IF_ZERO:
+		case JUMP_IF_ZERO_OR_POP:
+			// popping is implicit, the fallthrough simply continues one slot lower
+			appendText(output, "\tif(s%u == 0) goto L%u;", top, variant->asJumpTarget);
+			break;
+		case JUMP_IF_NONZERO_OR_POP:
+			appendText(output, "\tif(s%u != 0) goto L%u;", top, variant->asJumpTarget);
+			break;
+		case CONSTANT:
+			appendText(output, "\ts%u = ", depth);
+			appendConstant(output, variant->asConstant);
+			appendText(output, ";");
+			break;
+		case VARIABLE_INDEX:
+			appendText(output, "\ts%u = variables[%u].value;", depth, variant->asVariableIndex);
+			break;
+		case OPERATION:
+			{
+				const char* symbol = getOperationSymbol(variant->asOperation);
+				uint8_t argCount = variant->asOperationArgCount;
+				if(argCount == 0){
+					appendText(output, "\ts%u = %s((const ValueType[]){0}, 0);", depth, symbol);
+				}
+				else {
+					// args[] carries every argument, the last one is passed by value too
+					uint16_t first = depth - argCount;
+					appendText(output, "\ts%u = %s((const ValueType[]){", first, symbol);
+					appendSlots(output, first, argCount);
+					appendText(output, "}, s%u);", top);
+				}
+			}
+			break;
+		case NONE:
+			appendText(output, "\treturn MISSING_VALUE;");
+			break;
+		default:
+			break;
+	}
+	flushLine(output);
+}
+
+// extern functions
+
+bool generatePipelineFunction(const Pipeline* pipeline, const char* functionName, CodegenWriter write, void* context){
+	int16_t depthAt[NONE_INDEX + 2];
+	uint8_t maxDepth;
+	if(!computeStepDepths(pipeline, depthAt, &maxDepth)){
+		return false;
+	}
+	uint8_t pipelineLength = lengthOfPipeline(pipeline);
+
+	CodegenOutput output = {.write = write, .context = context, .length = 0};
+	output.line[0] = '\0';
+	bool declared = false;
+	for(uint16_t pipelineIdx = 0; pipelineIdx < pipelineLength; pipelineIdx++){
+		const PipelineVariant* variant = &pipeline->entries[pipelineIdx];
+		if(variant->type == OPERATION && isFirstCall(pipeline, pipelineIdx)){
+			appendText(&output, "extern ValueType %s(const ValueType args[], ValueType last);", getOperationSymbol(variant->asOperation));
+			flushLine(&output);
+			declared = true;
+		}
+	}
+	if(declared){
+		flushLine(&output);
+	}
+
+	appendText(&output, "ValueType %s(const PipelineVariable variables[]){", functionName);
+	flushLine(&output);
+	if(maxDepth > 0){
+		appendText(&output, "\tValueType ");
+		appendSlots(&output, 0, maxDepth);
+		appendText(&output, ";");
+		flushLine(&output);
+	}
+	for(uint16_t pipelineIdx = 0; pipelineIdx < pipelineLength; pipelineIdx++){
+		if(depthAt[pipelineIdx] < 0){
+			continue;
+		}
+		if(isJumpTarget(pipeline, pipelineIdx)){
+			appendText(&output, "L%u:", pipelineIdx);
+			flushLine(&output);
+		}
+		generateStep(&output, &pipeline->entries[pipelineIdx], (uint16_t)depthAt[pipelineIdx]);
+	}
+	if(pipelineLength == 0){
+		appendText(&output, "\treturn 0;");
+		flushLine(&output);
+	}
+	else if(depthAt[pipelineLength] >= 0){
+		if(isJumpTarget(pipeline, pipelineLength)){
+			appendText(&output, "L%u:", pipelineLength);
+			flushLine(&output);
+		}
+		appendText(&output, "\treturn s0;");
+		flushLine(&output);
+	}
+	appendText(&output, "}");
+	flushLine(&output);
+	return true;
+}
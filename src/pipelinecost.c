@@ -0,0 +1,249 @@
+#include "../include/pipelinecost.h"
+#include "../include/pipelinemath.h"
+#include "../include/pipelineoptimizer.h"
+
+// COST TABLES
+
+// the fixed point operations use 64 bit products, a library call on M0, qdiv divides 64 by 32 bits
+static const uint16_t operationsCortexM0[] = {
+	[OPERATION_MAP_ADD] = 4,
+	[OPERATION_MAP_SUB] = 4,
+	[OPERATION_MAP_MUL] = 5,
+	[OPERATION_MAP_DIV] = 110,
+	[OPERATION_MAP_MOD] = 120,
+	[OPERATION_MAP_POW2] = 5,
+	[OPERATION_MAP_ISQRT] = 150,
+	[OPERATION_MAP_SQRT] = 480,
+	[OPERATION_MAP_EXP] = 110,
+	[OPERATION_MAP_LOG] = 120,
+	[OPERATION_MAP_SIN] = 450,
+	[OPERATION_MAP_COS] = 450,
+	[OPERATION_MAP_LERP] = 45,
+	[OPERATION_MAP_QMUL] = 40,
+	[OPERATION_MAP_QDIV] = 300
+};
+
+static const uint16_t operationsCortexM4[] = {
+	[OPERATION_MAP_ADD] = 2,
+	[OPERATION_MAP_SUB] = 2,
+	[OPERATION_MAP_MUL] = 2,
+	[OPERATION_MAP_DIV] = 14,
+	[OPERATION_MAP_MOD] = 16,
+	[OPERATION_MAP_POW2] = 2,
+	[OPERATION_MAP_ISQRT] = 80,
+	[OPERATION_MAP_SQRT] = 240,
+	[OPERATION_MAP_EXP] = 30,
+	[OPERATION_MAP_LOG] = 35,
+	[OPERATION_MAP_SIN] = 170,
+	[OPERATION_MAP_COS] = 170,
+	[OPERATION_MAP_LERP] = 6,
+	[OPERATION_MAP_QMUL] = 4,
+	[OPERATION_MAP_QDIV] = 120
+};
+
+static const uint16_t operationsX86[] = {
+	[OPERATION_MAP_ADD] = 1,
+	[OPERATION_MAP_SUB] = 1,
+	[OPERATION_MAP_MUL] = 3,
+	[OPERATION_MAP_DIV] = 26,
+	[OPERATION_MAP_MOD] = 26,
+	[OPERATION_MAP_POW2] = 3,
+	[OPERATION_MAP_ISQRT] = 90,
+	[OPERATION_MAP_SQRT] = 140,
+	[OPERATION_MAP_EXP] = 20,
+	[OPERATION_MAP_LOG] = 25,
+	[OPERATION_MAP_SIN] = 200,
+	[OPERATION_MAP_COS] = 200,
+	[OPERATION_MAP_LERP] = 4,
+	[OPERATION_MAP_QMUL] = 4,
+	[OPERATION_MAP_QDIV] = 40
+};
+
+// a gap in a table reads 0 and is charged unknownOperation, a table missing the last operations is caught here
+_Static_assert(ARRAY_CONST_SIZE(operationsCortexM0) == OPERATION_MAP_COUNT, "cost of every registered operation on M0");
+_Static_assert(ARRAY_CONST_SIZE(operationsCortexM4) == OPERATION_MAP_COUNT, "cost of every registered operation on M4");
+_Static_assert(ARRAY_CONST_SIZE(operationsX86) == OPERATION_MAP_COUNT, "cost of every registered operation on x86");
+
+// no hardware divider, 64 bit multiplication is a library call
+const PipelineCostTable pipelineCostCortexM0 = {
+	.dispatch = 12,
+	.steps = {
+		[OPERATION_NATIVE_ADD] = 8,
+		[OPERATION_NATIVE_SUB] = 8,
+		[OPERATION_NATIVE_MUL] = 9,
+		[OPERATION_NATIVE_DIV] = 120,
+		[OPERATION_NATIVE_MOD] = 130,
+		[OPERATION_NATIVE_RSUB] = 8,
+		[OPERATION_NATIVE_RDIV] = 120,
+		[OPERATION_NATIVE_RMOD] = 130,
+		[OPERATION_NATIVE_ADD16] = 8,
+		[OPERATION_NATIVE_SUB16] = 8,
+		[OPERATION_NATIVE_MUL16] = 9,
+		[OPERATION_NATIVE_DIV16] = 90,
+		[OPERATION_NATIVE_MOD16] = 100,
+		[OPERATION_NATIVE_SHL] = 6,
+		[OPERATION_NATIVE_DIV_POW2] = 10,
+		[OPERATION_NATIVE_MOD_POW2] = 14,
+		[OPERATION_NATIVE_DIV_MAGIC] = 48,
+		[OPERATION_NATIVE_MOD_MAGIC] = 54,
+		[OPERATION_NATIVE_LT] = 10,
+		[OPERATION_NATIVE_LE] = 10,
+		[OPERATION_NATIVE_GT] = 10,
+		[OPERATION_NATIVE_GE] = 10,
+		[OPERATION_NATIVE_EQ] = 10,
+		[OPERATION_NATIVE_NE] = 10,
+		[OPERATION_NATIVE_BOOL] = 6,
+		[JUMP] = 4,
+		[JUMP_IF_ZERO] = 10,
+		[JUMP_IF_ZERO_OR_POP] = 10,
+		[JUMP_IF_NONZERO_OR_POP] = 10,
+		[CONSTANT] = 10,
+		[VARIABLE_INDEX] = 14,
+		[OPERATION] = 28,
+		[NONE] = 6
+	},
+	.operations = operationsCortexM0,
+	.operationCount = ARRAY_CONST_SIZE(operationsCortexM0),
+	.unknownOperation = 200
+};
+
+const PipelineCostTable pipelineCostCortexM4 = {
+	.dispatch = 6,
+	.steps = {
+		[OPERATION_NATIVE_ADD] = 4,
+		[OPERATION_NATIVE_SUB] = 4,
+		[OPERATION_NATIVE_MUL] = 4,
+		[OPERATION_NATIVE_DIV] = 16,
+		[OPERATION_NATIVE_MOD] = 18,
+		[OPERATION_NATIVE_RSUB] = 4,
+		[OPERATION_NATIVE_RDIV] = 16,
+		[OPERATION_NATIVE_RMOD] = 18,
+		[OPERATION_NATIVE_ADD16] = 4,
+		[OPERATION_NATIVE_SUB16] = 4,
+		[OPERATION_NATIVE_MUL16] = 4,
+		[OPERATION_NATIVE_DIV16] = 16,
+		[OPERATION_NATIVE_MOD16] = 18,
+		[OPERATION_NATIVE_SHL] = 3,
+		[OPERATION_NATIVE_DIV_POW2] = 5,
+		[OPERATION_NATIVE_MOD_POW2] = 7,
+		[OPERATION_NATIVE_DIV_MAGIC] = 7,
+		[OPERATION_NATIVE_MOD_MAGIC] = 9,
+		[OPERATION_NATIVE_LT] = 5,
+		[OPERATION_NATIVE_LE] = 5,
+		[OPERATION_NATIVE_GT] = 5,
+		[OPERATION_NATIVE_GE] = 5,
+		[OPERATION_NATIVE_EQ] = 5,
+		[OPERATION_NATIVE_NE] = 5,
+		[OPERATION_NATIVE_BOOL] = 3,
+		[JUMP] = 3,
+		[JUMP_IF_ZERO] = 6,
+		[JUMP_IF_ZERO_OR_POP] = 6,
+		[JUMP_IF_NONZERO_OR_POP] = 6,
+		[CONSTANT] = 5,
+		[VARIABLE_INDEX] = 7,
+		[OPERATION] = 14,
+		[NONE] = 3
+	},
+	.operations = operationsCortexM4,
+	.operationCount = ARRAY_CONST_SIZE(operationsCortexM4),
+	.unknownOperation = 100
+};
+
+// branch mispredictions dominate, every jump and the dispatch assume a miss
+const PipelineCostTable pipelineCostX86 = {
+	.dispatch = 4,
+	.steps = {
+		[OPERATION_NATIVE_ADD] = 2,
+		[OPERATION_NATIVE_SUB] = 2,
+		[OPERATION_NATIVE_MUL] = 4,
+		[OPERATION_NATIVE_DIV] = 28,
+		[OPERATION_NATIVE_MOD] = 28,
+		[OPERATION_NATIVE_RSUB] = 2,
+		[OPERATION_NATIVE_RDIV] = 28,
+		[OPERATION_NATIVE_RMOD] = 28,
+		[OPERATION_NATIVE_ADD16] = 2,
+		[OPERATION_NATIVE_SUB16] = 2,
+		[OPERATION_NATIVE_MUL16] = 4,
+		[OPERATION_NATIVE_DIV16] = 28,
+		[OPERATION_NATIVE_MOD16] = 28,
+		[OPERATION_NATIVE_SHL] = 2,
+		[OPERATION_NATIVE_DIV_POW2] = 4,
+		[OPERATION_NATIVE_MOD_POW2] = 5,
+		[OPERATION_NATIVE_DIV_MAGIC] = 6,
+		[OPERATION_NATIVE_MOD_MAGIC] = 9,
+		[OPERATION_NATIVE_LT] = 2,
+		[OPERATION_NATIVE_LE] = 2,
+		[OPERATION_NATIVE_GT] = 2,
+		[OPERATION_NATIVE_GE] = 2,
+		[OPERATION_NATIVE_EQ] = 2,
+		[OPERATION_NATIVE_NE] = 2,
+		[OPERATION_NATIVE_BOOL] = 2,
+		[JUMP] = 16,
+		[JUMP_IF_ZERO] = 18,
+		[JUMP_IF_ZERO_OR_POP] = 18,
+		[JUMP_IF_NONZERO_OR_POP] = 18,
+		[CONSTANT] = 2,
+		[VARIABLE_INDEX] = 3,
+		[OPERATION] = 8,
+		[NONE] = 2
+	},
+	.operations = operationsX86,
+	.operationCount = ARRAY_CONST_SIZE(operationsX86),
+	.unknownOperation = 50
+};
+
+// extern functions
+
+uint32_t getStepCost(const PipelineVariant* variant, const PipelineCostTable* table){
+	uint32_t cost = (uint32_t)table->dispatch + table->steps[variant->type];
+	if(variant->type == OPERATION){
+		Index mapIdx = getOperationMapIndex(variant->asOperation);
+		uint16_t operationCost = mapIdx < table->operationCount ? table->operations[mapIdx] : 0;
+		cost += operationCost != 0 ? operationCost : table->unknownOperation;
+	}
+	return cost;
+}
+
+PipelineCost estimatePipelineCost(const Pipeline* pipeline, const PipelineCostTable* table){
+	PipelineCost cost = {.cycles = 0, .stackBytes = 0, .maxStackDepth = 0};
+	if(pipeline->index == NONE_INDEX){
+		return cost;
+	}
+
+	// worst cycles from each step to the end, filled backwards since jump targets lie ahead
+	uint32_t worstFrom[NONE_INDEX + 2];
+	uint8_t pipelineLength = pipeline->index + 1;
+	worstFrom[pipelineLength] = 0;
+	for(int16_t pipelineIdx = pipelineLength - 1; pipelineIdx >= 0; pipelineIdx--){
+		const PipelineVariant* variant = &pipeline->entries[pipelineIdx];
+		uint32_t next = worstFrom[pipelineIdx + 1];
+		if(isJumpStep(variant)){
+			Index target = variant->asJumpTarget;
+			uint32_t jumped = target <= pipelineLength ? worstFrom[target] : 0;
+			if(variant->type == JUMP || jumped > next){
+				next = jumped;
+			}
+		}
+		worstFrom[pipelineIdx] = getStepCost(variant, table) + next;
+	}
+
+	cost.cycles = worstFrom[0];
+	cost.maxStackDepth = getPipelineMaxStackDepth(pipeline);
+	cost.stackBytes = (uint16_t)(cost.maxStackDepth * sizeof(ValueType));
+	return cost;
+}
+
+ParsingError compileExpressionWithBudget(Pipeline* pipeline, PeekableStringSlice* peekableSlice, PipelineVariablesSlice variables, const PipelineCostTable* table, PipelineCost budget){
+	ParsingError err = compileExpression(pipeline, peekableSlice, variables);
+	if(err.type != NOERROR){
+		return err;
+	}
+	PipelineCost cost = estimatePipelineCost(pipeline, table);
+	bool overCycles = budget.cycles != 0 && cost.cycles > budget.cycles;
+	bool overStack = budget.stackBytes != 0 && cost.stackBytes > budget.stackBytes;
+	bool overDepth = budget.maxStackDepth != 0 && cost.maxStackDepth > budget.maxStackDepth;
+	if(overCycles || overStack || overDepth){
+		return PARSING_ERROR(BUDGET_EXCEEDED, peekableSlice->cursor, ' ');
+	}
+	return NO_PARSING_ERROR;
+}
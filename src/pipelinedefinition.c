@@ -0,0 +1,173 @@
+#include "../include/pipelinedefinition.h"
+#include "../include/pipelineoptimizer.h"
+
+#include <ctype.h>
+#include <string.h>
+
+// helper static functions
+
+static char skipSpaces(PeekableStringSlice* input){
+	while(input->cursor < input->slice.len && isspace((unsigned char)input->slice.str[input->cursor])){
+		input->cursor++;
+	}
+	return input->cursor < input->slice.len ? input->slice.str[input->cursor] : '\0';
+}
+
+static bool matchChar(PeekableStringSlice* input, char expected){
+	if(skipSpaces(input) == expected){
+		input->cursor++;
+		return true;
+	}
+	return false;
+}
+
+static ParsingError unexpectedAt(PeekableStringSlice* input){
+	return PARSING_ERROR(UNEXPECTED, input->cursor, skipSpaces(input));
+}
+
+// copies steps [begin, end) to at, moving their jump targets along
+static void copySteps(PipelineVariant entries[], uint16_t begin, uint16_t end, uint16_t at){
+	for(uint16_t stepIdx = begin; stepIdx < end; stepIdx++){
+		PipelineVariant step = entries[stepIdx];
+		if(isJumpStep(&step)){
+			step.asJumpTarget = (Index)(step.asJumpTarget + at - begin);
+		}
+		entries[at + stepIdx - begin] = step;
+	}
+}
+
+// extern functions
+
+void initPipelineDefinitions(PipelineDefinitions* definitions, PipelineVariant fragmentStorage[], uint8_t fragmentCapacity){
+	definitions->definitionCount = 0;
+	definitions->fragments = createPipeline(fragmentStorage, fragmentCapacity);
+}
+
+const PipelineDefinition* findPipelineDefinition(const PipelineDefinitions* definitions, StringSlice name){
+	// latest first so redefinitions win
+	for(uint8_t definitionIdx = definitions->definitionCount; definitionIdx > 0; definitionIdx--){
+		const PipelineDefinition* definition = &definitions->definitions[definitionIdx - 1];
+		if(definition->nameLength == name.len && memcmp(definition->name, name.str, name.len) == 0){
+			return definition;
+		}
+	}
+	return NULL;
+}
+
+ParsingError definePipelineExpression(PipelineDefinitions* definitions, PeekableStringSlice* peekableSlice){
+	if(definitions->definitionCount >= PIPELINE_MAX_DEFINITIONS){
+		return PARSING_ERROR(DEFINITIONS_FULL, peekableSlice->cursor, skipSpaces(peekableSlice));
+	}
+	PipelineDefinition definition = {.nameLength = 0, .paramCount = 0};
+
+	if(!isalpha((unsigned char)skipSpaces(peekableSlice))){
+		return unexpectedAt(peekableSlice);
+	}
+	size_t nameBegin = peekableSlice->cursor;
+	while(peekableSlice->cursor < peekableSlice->slice.len && isalnum((unsigned char)peekableSlice->slice.str[peekableSlice->cursor])){
+		peekableSlice->cursor++;
+	}
+	size_t nameLength = peekableSlice->cursor - nameBegin;
+	if(nameLength < 2 || nameLength > PIPELINE_DEFINITION_MAX_NAME){
+		return PARSING_ERROR(UNEXPECTED, nameBegin, peekableSlice->slice.str[nameBegin]);
+	}
+	memcpy(definition.name, &peekableSlice->slice.str[nameBegin], nameLength);
+	definition.nameLength = (uint8_t)nameLength;
+
+	// parameters become the variables of the body
+	PipelineVariable params[PIPELINE_DEFINITION_MAX_PARAMS];
+	if(!matchChar(peekableSlice, '(')){
+		return unexpectedAt(peekableSlice);
+	}
+	if(!matchChar(peekableSlice, ')')){
+		do {
+			char param = skipSpaces(peekableSlice);
+			if(!isalpha((unsigned char)param)){
+				return unexpectedAt(peekableSlice);
+			}
+			if(definition.paramCount >= PIPELINE_DEFINITION_MAX_PARAMS){
+				return PARSING_ERROR(TOO_MANY_ARGUMENTS, peekableSlice->cursor, param);
+			}
+			params[definition.paramCount++] = (PipelineVariable){.name = param, .value = 0};
+			peekableSlice->cursor++;
+		} while(matchChar(peekableSlice, ','));
+		if(!matchChar(peekableSlice, ')')){
+			return unexpectedAt(peekableSlice);
+		}
+	}
+	if(!matchChar(peekableSlice, ':') || peekableSlice->cursor >= peekableSlice->slice.len || peekableSlice->slice.str[peekableSlice->cursor] != '='){
+		return unexpectedAt(peekableSlice);
+	}
+	peekableSlice->cursor++;
+
+	Pipeline* fragments = &definitions->fragments;
+	Index previousIndex = fragments->index;
+	definition.begin = lengthOfPipeline(fragments);
+	PipelineVariablesSlice paramSlice = {params, (int8_t)definition.paramCount};
+	ParsingError err = compileExpressionWithDefinitions(fragments, peekableSlice, paramSlice, definitions);
+	if(err.type == NOERROR && skipSpaces(peekableSlice) != '\0'){
+		err = unexpectedAt(peekableSlice);
+	}
+	if(err.type != NOERROR){
+		fragments->index = previousIndex;
+		fragments->errorMask = NO_ERROR;
+		return err;
+	}
+	definition.length = (Index)(lengthOfPipeline(fragments) - definition.begin);
+	definitions->definitions[definitions->definitionCount++] = definition;
+	return NO_PARSING_ERROR;
+}
+
+ParsingError compileExpressionWithDefinitions(Pipeline* pipeline, PeekableStringSlice* peekableSlice, PipelineVariablesSlice variables, PipelineDefinitions* definitions){
+	ParsingContext* previousContext = peekableSlice->context;
+	ParsingContext context = previousContext != NULL ? *previousContext : (ParsingContext){.stream = NULL, .definitions = NULL, .spans = NULL};
+	context.definitions = definitions;
+	peekableSlice->context = &context;
+	ParsingError err = compileExpression(pipeline, peekableSlice, variables);
+	peekableSlice->context = previousContext;
+	return err;
+}
+
+bool inlinePipelineDefinition(Pipeline* pipeline, const PipelineDefinitions* definitions, const PipelineDefinition* definition, const Index argBegins[]){
+	PipelineVariant* entries = pipeline->entries;
+	const PipelineVariant* fragment = &definitions->fragments.entries[definition->begin];
+	uint16_t end = lengthOfPipeline(pipeline);
+	uint16_t argsBegin = definition->paramCount > 0 ? argBegins[0] : end;
+
+	// the expansion is built behind the arguments and moved over them at the end,
+	// expandedAt maps fragment steps to their offset in the expansion for the jump targets
+	uint16_t expandedAt[NONE_INDEX + 1];
+	uint16_t out = end;
+	for(Index fragmentIdx = 0; fragmentIdx < definition->length; fragmentIdx++){
+		expandedAt[fragmentIdx] = out - end;
+		const PipelineVariant* step = &fragment[fragmentIdx];
+		if(step->type == VARIABLE_INDEX){
+			Index param = step->asVariableIndex;
+			uint16_t argBegin = argBegins[param];
+			uint16_t argEnd = param + 1 < definition->paramCount ? argBegins[param + 1] : end;
+			if(out + argEnd - argBegin > pipeline->capacity){
+				return false;
+			}
+			copySteps(entries, argBegin, argEnd, out);
+			out += argEnd - argBegin;
+		}
+		else {
+			if(out >= pipeline->capacity){
+				return false;
+			}
+			entries[out++] = *step;
+		}
+	}
+	expandedAt[definition->length] = out - end;
+
+	for(Index fragmentIdx = 0; fragmentIdx < definition->length; fragmentIdx++){
+		const PipelineVariant* step = &fragment[fragmentIdx];
+		if(isJumpStep(step)){
+			entries[end + expandedAt[fragmentIdx]].asJumpTarget = (Index)(end + expandedAt[step->asJumpTarget - definition->begin]);
+		}
+	}
+
+	copySteps(entries, end, out, argsBegin);
+	pipeline->index = (Index)(argsBegin + out - end - 1);
+	return true;
+}
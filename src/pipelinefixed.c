@@ -0,0 +1,201 @@
+#include "../include/pipelinefixed.h"
+
+#include <stdbool.h>
+
+// TABLES
+
+// 2^(i/64) for i = 0..64 in Q2.30
+static const uint32_t exp2Table[65] = {
+	1073741824u, 1085434106u, 1097253708u, 1109202018u, 1121280436u, 1133490379u,
+	1145833280u, 1158310587u, 1170923762u, 1183674286u, 1196563654u, 1209593378u,
+	1222764986u, 1236080024u, 1249540052u, 1263146652u, 1276901417u, 1290805962u,
+	1304861917u, 1319070932u, 1333434672u, 1347954824u, 1362633090u, 1377471191u,
+	1392470869u, 1407633882u, 1422962010u, 1438457051u, 1454120821u, 1469955159u,
+	1485961921u, 1502142985u, 1518500250u, 1535035634u, 1551751076u, 1568648537u,
+	1585730000u, 1602997467u, 1620452965u, 1638098541u, 1655936265u, 1673968228u,
+	1692196547u, 1710623359u, 1729250827u, 1748081133u, 1767116489u, 1786359126u,
+	1805811301u, 1825475297u, 1845353420u, 1865448001u, 1885761398u, 1906295993u,
+	1927054196u, 1948038440u, 1969251188u, 1990694927u, 2012372174u, 2034285470u,
+	2056437387u, 2078830522u, 2101467502u, 2124350982u, 2147483648u
+};
+
+// log2(1 + i/64) for i = 0..64 in Q2.30
+static const uint32_t log2Table[65] = {
+	0u, 24017256u, 47667823u, 70962728u, 93912511u, 116527248u,
+	138816582u, 160789745u, 182455581u, 203822568u, 224898839u, 245692198u,
+	266210141u, 286459867u, 306448299u, 326182095u, 345667660u, 364911162u,
+	383918542u, 402695523u, 421247625u, 439580170u, 457698295u, 475606957u,
+	493310944u, 510814882u, 528123241u, 545240343u, 562170370u, 578917365u,
+	595485245u, 611877800u, 628098702u, 644151509u, 660039669u, 675766525u,
+	691335320u, 706749198u, 722011213u, 737124328u, 752091421u, 766915285u,
+	781598637u, 796144114u, 810554283u, 824831638u, 838978604u, 852997541u,
+	866890747u, 880660455u, 894308843u, 907838029u, 921250079u, 934547002u,
+	947730758u, 960803257u, 973766362u, 986621888u, 999371606u, 1012017244u,
+	1024560487u, 1037002979u, 1049346328u, 1061592099u, 1073741824u
+};
+
+// atan(2^-i) in Q2.30
+static const int32_t atanTable[FIXED_CORDIC_ITERATIONS] = {
+	843314857, 497837829, 263043837, 133525159, 67021687, 33543516,
+	16775851, 8388437, 4194283, 2097149, 1048576, 524288,
+	262144, 131072, 65536, 32768, 16384, 8192,
+	4096, 2048, 1024, 512, 256, 128
+};
+
+// 1 / prod(sqrt(1 + 2^-2i)) over the iterations in Q2.30, the start vector absorbs the CORDIC gain
+#define CORDIC_GAIN_Q30 652032874
+
+#define LOG2_E_Q30 1549082005
+#define LN_2_Q32 2977044472u
+#define TWO_PI_Q32 26986075409LL
+#define PI_Q32 13493037705LL
+#define HALF_PI_Q32 6746518852LL
+#define INV_TWO_PI_Q32 683565276LL
+
+// helper static functions
+
+// linear interpolation between table[slot] and table[slot + 1], within is the 16 bit position between them
+static uint32_t interpolateTable(const uint32_t table[], uint32_t slot, uint32_t within){
+	uint32_t low = table[slot];
+	return low + (uint32_t)(((uint64_t)(table[slot + 1] - low) * within) >> 16);
+}
+
+// extern functions
+
+ValueType fixedIntegerSqrt(ValueType value){
+	if(value <= 0){
+		return 0;
+	}
+	uint32_t remainder = (uint32_t)value;
+	uint32_t root = 0;
+	uint32_t bit = 1u << 30;
+	while(bit > remainder){
+		bit >>= 2;
+	}
+	while(bit != 0){
+		// branch free, the digit is as good as random
+		uint32_t trial = root + bit;
+		uint32_t taken = (uint32_t)0 - (remainder >= trial);
+		remainder -= trial & taken;
+		root = (root >> 1) + (bit & taken);
+		bit >>= 2;
+	}
+	return (ValueType)root;
+}
+
+ValueType fixedSqrt(ValueType value){
+	if(value <= 0){
+		return 0;
+	}
+	// sqrt(x / 2^16) * 2^16 == sqrt(x * 2^16)
+	uint64_t remainder = (uint64_t)value << FIXED_FRACTION_BITS;
+	uint64_t root = 0;
+	uint64_t bit = (uint64_t)1 << 46;
+	while(bit > remainder){
+		bit >>= 2;
+	}
+	while(bit != 0){
+		// branch free, the digit is as good as random
+		uint64_t trial = root + bit;
+		uint64_t taken = (uint64_t)0 - (remainder >= trial);
+		remainder -= trial & taken;
+		root = (root >> 1) + (bit & taken);
+		bit >>= 2;
+	}
+	return (ValueType)root;
+}
+
+ValueType fixedExp(ValueType value){
+	// e^x == 2^(x log2 e), the exponent is split into its integer part and a 32 bit fraction
+	int64_t exponent = ((int64_t)value * LOG2_E_Q30) >> 14;
+	int32_t whole = (int32_t)(exponent >> 32);
+	uint32_t fraction = (uint32_t)exponent;
+	if(whole > 14){
+		return INT32_MAX;
+	}
+	if(whole < -17){
+		return 0;
+	}
+	uint32_t power = interpolateTable(exp2Table, fraction >> 26, (fraction >> 10) & 0xFFFFu);
+	uint8_t shift = (uint8_t)(30 - FIXED_FRACTION_BITS - whole);
+	if(shift == 0){
+		return (ValueType)power;
+	}
+	return (ValueType)((power + (1u << (shift - 1))) >> shift);
+}
+
+ValueType fixedLog(ValueType value){
+	if(value <= 0){
+		return INT32_MIN;
+	}
+	// value == mantissa * 2^(exponent - 30) * 2^16 with the mantissa normalized to [2^30, 2^31)
+	uint32_t mantissa = (uint32_t)value;
+	int32_t exponent = 30 - FIXED_FRACTION_BITS;
+	for(uint8_t step = 16; step > 0; step >>= 1){
+		if(mantissa < (1u << (31 - step))){
+			mantissa <<= step;
+			exponent -= step;
+		}
+	}
+	uint32_t fraction = mantissa - (1u << 30);
+	uint32_t log2Mantissa = interpolateTable(log2Table, fraction >> 24, (fraction >> 8) & 0xFFFFu);
+	int64_t logQ32 = (int64_t)exponent * LN_2_Q32 + (int64_t)(((uint64_t)log2Mantissa * LN_2_Q32) >> 30);
+	return (ValueType)((logQ32 + (1 << 15)) >> 16);
+}
+
+void fixedSinCos(ValueType angle, ValueType* sine, ValueType* cosine){
+	// reduce to [-pi, pi] in Q32 by the nearest number of turns, then to [-pi/2, pi/2] by a half turn
+	int64_t reduced = (int64_t)angle * FIXED_ONE;
+	int64_t turns = ((int64_t)angle * INV_TWO_PI_Q32 + ((int64_t)1 << 47)) >> 48;
+	reduced -= turns * TWO_PI_Q32;
+	if(reduced > PI_Q32){
+		reduced -= TWO_PI_Q32;
+	}
+	else if(reduced < -PI_Q32){
+		reduced += TWO_PI_Q32;
+	}
+	bool halfTurn = false;
+	if(reduced > HALF_PI_Q32){
+		reduced -= PI_Q32;
+		halfTurn = true;
+	}
+	else if(reduced < -HALF_PI_Q32){
+		reduced += PI_Q32;
+		halfTurn = true;
+	}
+
+	// rotation mode, drives the residual angle to zero rotating (gain, 0) along
+	int32_t theta = (int32_t)(reduced >> 2);
+	int32_t x = CORDIC_GAIN_Q30;
+	int32_t y = 0;
+	for(uint8_t iteration = 0; iteration < FIXED_CORDIC_ITERATIONS; iteration++){
+		// direction -1 or +1 applied as (v ^ sign) - sign, the sign of the residual is unpredictable
+		int32_t sign = theta < 0 ? -1 : 0;
+		int32_t dx = ((x >> iteration) ^ sign) - sign;
+		int32_t dy = ((y >> iteration) ^ sign) - sign;
+		x -= dy;
+		y += dx;
+		theta -= (atanTable[iteration] ^ sign) - sign;
+	}
+	if(halfTurn){
+		x = -x;
+		y = -y;
+	}
+	*sine = (y + (1 << 13)) >> 14;
+	*cosine = (x + (1 << 13)) >> 14;
+}
+
+ValueType fixedLerp(ValueType from, ValueType to, ValueType t){
+	return (ValueType)(from + ((((int64_t)to - from) * t) >> FIXED_FRACTION_BITS));
+}
+
+ValueType fixedMul(ValueType left, ValueType right){
+	return (ValueType)(((int64_t)left * right) >> FIXED_FRACTION_BITS);
+}
+
+ValueType fixedDiv(ValueType left, ValueType right){
+	if(right == 0){
+		return 0;
+	}
+	return (ValueType)((int64_t)left * FIXED_ONE / right);
+}
@@ -0,0 +1,293 @@
+#include "../include/pipelinegradient.h"
+
+// extern functions
+
+ValueType executePipelineGradient(const Pipeline* pipeline, GradientStack* stack, PipelineVariablesSlice variables, const Index wrt[], uint8_t wrtCount, ValueType gradient[]){
+	clearStack(&stack->values);
+	if(wrt == NULL){
+		wrtCount = (uint8_t)variables.len;
+	}
+	if(wrtCount > PIPELINE_GRADIENT_SIZE){
+		wrtCount = PIPELINE_GRADIENT_SIZE;
+	}
+
+	ValueType* values = stack->values.entries;
+	ValueType (*tangents)[PIPELINE_GRADIENT_SIZE] = stack->tangents;
+	Index* stackIndex = &stack->values.index;
+
+	uint8_t pipelineLength = pipeline->index + 1;
+	for(Index pipelineIdx = 0; pipelineIdx < pipelineLength; pipelineIdx++){
+		const PipelineVariant* variant = &pipeline->entries[pipelineIdx];
+		Index top = *stackIndex;
+		switch (variant->type)
+		{
+			case OPERATION_NATIVE_ADD:
+			case OPERATION_NATIVE_SUB:
+			case OPERATION_NATIVE_MUL:
+			case OPERATION_NATIVE_DIV:
+			case OPERATION_NATIVE_MOD:
+			case OPERATION_NATIVE_RSUB:
+			case OPERATION_NATIVE_RDIV:
+			case OPERATION_NATIVE_RMOD:
+			case OPERATION_NATIVE_ADD16:
+			case OPERATION_NATIVE_SUB16:
+			case OPERATION_NATIVE_MUL16:
+			case OPERATION_NATIVE_DIV16:
+			case OPERATION_NATIVE_MOD16:
+				{
+					// narrowed steps were proven to give the same values, tangents use the full width
+					Index below = --(*stackIndex);
+					ValueType left = values[below];
+					ValueType right = values[top];
+					for(uint8_t k = 0; k < wrtCount; k++){
+						ValueType leftTangent = tangents[below][k];
+						ValueType rightTangent = tangents[top][k];
+						ValueType tangent;
+						switch (variant->type)
+						{
+							case OPERATION_NATIVE_ADD:
+							case OPERATION_NATIVE_ADD16:
+								tangent = leftTangent + rightTangent;
+								break;
+							case OPERATION_NATIVE_SUB:
+							case OPERATION_NATIVE_SUB16:
+								tangent = leftTangent - rightTangent;
+								break;
+							case OPERATION_NATIVE_MUL:
+							case OPERATION_NATIVE_MUL16:
+								tangent = leftTangent * right + left * rightTangent;
+								break;
+							case OPERATION_NATIVE_DIV:
+							case OPERATION_NATIVE_DIV16:
+								if(!getQuotientTangent(left, right, leftTangent, rightTangent, &tangent)){
+									stack->values.errorMask |= NO_DERIVATIVE;
+									tangent = 0;
+								}
+								break;
+							case OPERATION_NATIVE_RSUB:
+								tangent = rightTangent - leftTangent;
+								break;
+							case OPERATION_NATIVE_RDIV:
+								if(!getQuotientTangent(right, left, rightTangent, leftTangent, &tangent)){
+									stack->values.errorMask |= NO_DERIVATIVE;
+									tangent = 0;
+								}
+								break;
+							case OPERATION_NATIVE_RMOD:
+								tangent = rightTangent - (right / left) * leftTangent;
+								break;
+							default:
+								tangent = leftTangent - (left / right) * rightTangent;
+								break;
+						}
+						tangents[below][k] = tangent;
+					}
+					switch (variant->type)
+					{
+						case OPERATION_NATIVE_ADD:
+						case OPERATION_NATIVE_ADD16:
+							values[below] = left + right;
+							break;
+						case OPERATION_NATIVE_SUB:
+						case OPERATION_NATIVE_SUB16:
+							values[below] = left - right;
+							break;
+						case OPERATION_NATIVE_MUL:
+						case OPERATION_NATIVE_MUL16:
+							values[below] = left * right;
+							break;
+						case OPERATION_NATIVE_DIV:
+						case OPERATION_NATIVE_DIV16:
+							values[below] = left / right;
+							break;
+						case OPERATION_NATIVE_RSUB:
+							values[below] = right - left;
+							break;
+						case OPERATION_NATIVE_RDIV:
+							values[below] = right / left;
+							break;
+						case OPERATION_NATIVE_RMOD:
+							values[below] = right % left;
+							break;
+						default:
+							values[below] = left % right;
+							break;
+					}
+				}
+				break;
+			case OPERATION_NATIVE_SHL:
+				{
+					values[top] = shiftLeftByConstant(values[top], &variant->asDivisor);
+					for(uint8_t k = 0; k < wrtCount; k++){
+						tangents[top][k] = shiftLeftByConstant(tangents[top][k], &variant->asDivisor);
+					}
+				}
+				break;
+			case OPERATION_NATIVE_DIV_POW2:
+				{
+					values[top] = divideByPow2Constant(values[top], &variant->asDivisor);
+					for(uint8_t k = 0; k < wrtCount; k++){
+						tangents[top][k] = divideByPow2Constant(tangents[top][k], &variant->asDivisor);
+					}
+				}
+				break;
+			case OPERATION_NATIVE_DIV_MAGIC:
+				{
+					// the magic number on top is a constant without tangent
+					Index below = --(*stackIndex);
+					values[below] = divideByMagicConstant(values[below], values[top], &variant->asDivisor);
+					for(uint8_t k = 0; k < wrtCount; k++){
+						tangents[below][k] = divideByMagicConstant(tangents[below][k], values[top], &variant->asDivisor);
+					}
+				}
+				break;
+			case OPERATION_NATIVE_MOD_POW2:
+				{
+					// modulo by a constant keeps the tangent of the dividend
+					values[top] = moduloByPow2Constant(values[top], &variant->asDivisor);
+				}
+				break;
+			case OPERATION_NATIVE_MOD_MAGIC:
+				{
+					Index below = --(*stackIndex);
+					values[below] = moduloByMagicConstant(values[below], values[top], &variant->asDivisor);
+				}
+				break;
+			case OPERATION_NATIVE_LT:
+			case OPERATION_NATIVE_LE:
+			case OPERATION_NATIVE_GT:
+			case OPERATION_NATIVE_GE:
+			case OPERATION_NATIVE_EQ:
+			case OPERATION_NATIVE_NE:
+				{
+					// comparisons are piecewise constant
+					Index below = --(*stackIndex);
+					ValueType left = values[below];
+					ValueType right = values[top];
+					switch (variant->type)
+					{
+						case OPERATION_NATIVE_LT:
+							values[below] = left < right;
+							break;
+						case OPERATION_NATIVE_LE:
+							values[below] = left <= right;
+							break;
+						case OPERATION_NATIVE_GT:
+							values[below] = left > right;
+							break;
+						case OPERATION_NATIVE_GE:
+							values[below] = left >= right;
+							break;
+						case OPERATION_NATIVE_EQ:
+							values[below] = left == right;
+							break;
+						default:
+							values[below] = left != right;
+							break;
+					}
+					for(uint8_t k = 0; k < wrtCount; k++){
+						tangents[below][k] = 0;
+					}
+				}
+				break;
+			case OPERATION_NATIVE_BOOL:
+				{
+					values[top] = values[top] != 0;
+					for(uint8_t k = 0; k < wrtCount; k++){
+						tangents[top][k] = 0;
+					}
+				}
+				break;
+			// only the taken branch contributes to the derivative
+			case JUMP:
+				{
+					pipelineIdx = variant->asJumpTarget - 1;
+				}
+				break;
+			case JUMP_IF_ZERO:
+				{
+					--(*stackIndex);
+					if(values[top] == 0){
+						pipelineIdx = variant->asJumpTarget - 1;
+					}
+				}
+				break;
+			case JUMP_IF_ZERO_OR_POP:
+			case JUMP_IF_NONZERO_OR_POP:
+				{
+					bool jumps = (values[top] == 0) == (variant->type == JUMP_IF_ZERO_OR_POP);
+					if(jumps){
+						pipelineIdx = variant->asJumpTarget - 1;
+					}
+					else {
+						--(*stackIndex);
+					}
+				}
+				break;
+			case CONSTANT:
+				{
+					pushStackUnchecked(&stack->values, variant->asConstant);
+					Index pushed = *stackIndex;
+					for(uint8_t k = 0; k < wrtCount; k++){
+						tangents[pushed][k] = 0;
+					}
+				}
+				break;
+			case VARIABLE_INDEX:
+				{
+					VariableIndex variableIndex = variant->asVariableIndex;
+					pushStackUnchecked(&stack->values, variables.vars[variableIndex].value);
+					Index pushed = *stackIndex;
+					for(uint8_t k = 0; k < wrtCount; k++){
+						Index seed = wrt != NULL ? wrt[k] : k;
+						tangents[pushed][k] = seed == variableIndex ? 1 : 0;
+					}
+				}
+				break;
+			case OPERATION:
+				{
+					const OperationMapEntry* entry = getEntryByOperation(variant->asOperation);
+					uint8_t argCount = variant->asOperationArgCount;
+					Index firstArg = (Index)(top + 1 - argCount);
+					ValueType args[PIPELINE_STACK_SIZE];
+					for(uint8_t arg = 0; arg < argCount; arg++){
+						args[arg] = values[firstArg + arg];
+					}
+
+					ValueType resultTangents[PIPELINE_GRADIENT_SIZE];
+					for(uint8_t k = 0; k < wrtCount; k++){
+						if(entry == NULL || entry->derivative == NULL){
+							stack->values.errorMask |= NO_DERIVATIVE;
+							resultTangents[k] = 0;
+							continue;
+						}
+						ValueType argTangents[PIPELINE_STACK_SIZE];
+						for(uint8_t arg = 0; arg < argCount; arg++){
+							argTangents[arg] = tangents[firstArg + arg][k];
+						}
+						resultTangents[k] = entry->derivative(args, argTangents);
+					}
+
+					ValueType result = variant->asOperation(args, argCount > 0 ? args[argCount - 1] : 0);
+					*stackIndex = (Index)(firstArg - 1);
+					pushStackUnchecked(&stack->values, result);
+					Index pushed = *stackIndex;
+					for(uint8_t k = 0; k < wrtCount; k++){
+						tangents[pushed][k] = resultTangents[k];
+					}
+				}
+				break;
+			case NONE:
+				for(uint8_t k = 0; k < wrtCount; k++){
+					gradient[k] = 0;
+				}
+				return MISSING_VALUE;
+		}
+	}
+
+	Index top = *stackIndex;
+	for(uint8_t k = 0; k < wrtCount; k++){
+		gradient[k] = tangents[top][k];
+	}
+	return popStackUnchecked(&stack->values);
+}
@@ -0,0 +1,101 @@
+#include "../include/pipelinehandle.h"
+
+// helper static functions
+
+static bool isVersionReclaimable(PipelineHandle* handle, const PipelineVersion* version){
+	for(uint8_t readerId = 0; readerId < PIPELINE_HANDLE_MAX_READERS; readerId++){
+		uint32_t readerEpoch = atomic_load(&handle->readers[readerId].epoch);
+		if(readerEpoch != 0 && readerEpoch < version->retiredEpoch){
+			return false;
+		}
+	}
+	return true;
+}
+
+static void lockWriters(PipelineHandle* handle){
+	while(atomic_flag_test_and_set_explicit(&handle->writerLock, memory_order_acquire)){
+	}
+}
+
+static void unlockWriters(PipelineHandle* handle){
+	atomic_flag_clear_explicit(&handle->writerLock, memory_order_release);
+}
+
+// extern functions
+
+void initPipelineVersion(PipelineVersion* version, PipelineVariant storage[], uint8_t storageCapacity){
+	version->pipeline = createPipeline(storage, storageCapacity);
+	version->version = 0;
+	version->retiredEpoch = 0;
+	version->state = PIPELINE_VERSION_FREE;
+}
+
+void initPipelineHandle(PipelineHandle* handle, PipelineVersion versions[], uint8_t versionCount){
+	atomic_init(&handle->current, NULL);
+	// 0 marks a reader outside the handle
+	atomic_init(&handle->epoch, 1);
+	for(uint8_t readerId = 0; readerId < PIPELINE_HANDLE_MAX_READERS; readerId++){
+		atomic_init(&handle->readers[readerId].epoch, 0);
+	}
+	handle->versions = versions;
+	handle->versionCount = versionCount;
+	atomic_flag_clear(&handle->writerLock);
+	handle->nextVersion = 1;
+}
+
+const PipelineVersion* enterPipelineHandle(PipelineHandle* handle, uint8_t readerId){
+	// the announcement is ordered before the load of current, a writer retiring the loaded version
+	// either sees the announcement or has already advanced the epoch past it
+	atomic_store(&handle->readers[readerId].epoch, atomic_load(&handle->epoch));
+	return atomic_load(&handle->current);
+}
+
+void leavePipelineHandle(PipelineHandle* handle, uint8_t readerId){
+	atomic_store_explicit(&handle->readers[readerId].epoch, 0, memory_order_release);
+}
+
+ValueType executePipelineHandle(PipelineHandle* handle, uint8_t readerId, PipelineStack* stack, PipelineVariablesSlice variables){
+	const PipelineVersion* version = enterPipelineHandle(handle, readerId);
+	ValueType result = version != NULL ? executePipeline(&version->pipeline, stack, variables) : MISSING_VALUE;
+	leavePipelineHandle(handle, readerId);
+	return result;
+}
+
+PipelineVersion* acquirePipelineVersion(PipelineHandle* handle){
+	lockWriters(handle);
+	for(uint8_t versionIdx = 0; versionIdx < handle->versionCount; versionIdx++){
+		PipelineVersion* version = &handle->versions[versionIdx];
+		if(version->state == PIPELINE_VERSION_RETIRED && isVersionReclaimable(handle, version)){
+			version->state = PIPELINE_VERSION_FREE;
+		}
+		if(version->state == PIPELINE_VERSION_FREE){
+			version->state = PIPELINE_VERSION_WRITING;
+			unlockWriters(handle);
+			clearPipeline(&version->pipeline);
+			return version;
+		}
+	}
+	unlockWriters(handle);
+	return NULL;
+}
+
+void publishPipelineVersion(PipelineHandle* handle, PipelineVersion* version){
+	// under the lock version numbers reach current in increasing order
+	lockWriters(handle);
+	version->version = handle->nextVersion++;
+	version->state = PIPELINE_VERSION_CURRENT;
+	PipelineVersion* replaced = atomic_exchange(&handle->current, version);
+	uint32_t epoch = atomic_fetch_add(&handle->epoch, 1) + 1;
+	if(replaced != NULL){
+		replaced->retiredEpoch = epoch;
+		replaced->state = PIPELINE_VERSION_RETIRED;
+	}
+	unlockWriters(handle);
+}
+
+void abandonPipelineVersion(PipelineHandle* handle, PipelineVersion* version){
+	lockWriters(handle);
+	version->state = PIPELINE_VERSION_FREE;
+	unlockWriters(handle);
+}
+
@@ -0,0 +1,245 @@
+#include "../include/pipelineincremental.h"
+#include "../include/pipelineoptimizer.h"
+
+#include <ctype.h>
+
+// helper static functions
+
+static ParsingError (*const parseLevels[])(Pipeline*, PeekableStringSlice*, PipelineVariablesSlice) = {
+	[SPAN_PRIMARY] = parseConstantVariableOperationToken,
+	[SPAN_MUL_DIV] = parseMulDivToken,
+	[SPAN_ADD_SUB] = parseAddSubToken,
+	[SPAN_RELATIONAL] = parseRelationalToken,
+	[SPAN_EQUALITY] = parseEqualityToken,
+	[SPAN_LOGICAL_AND] = parseLogicalAndToken,
+	[SPAN_LOGICAL_OR] = parseLogicalOrToken,
+	[SPAN_CONDITIONAL] = parseConditionalToken
+};
+
+// whether && and || take steps [begin, end) as a boolean already or normalize them with a BOOL step,
+// the same test the parser makes when they end the pipeline
+static bool endsBoolean(const PipelineVariant entries[], Index begin, Index end){
+	if(!isBooleanStep(&entries[end - 1])){
+		return false;
+	}
+	for(Index pipelineIdx = begin; pipelineIdx < end; pipelineIdx++){
+		if(isJumpStep(&entries[pipelineIdx]) && entries[pipelineIdx].asJumpTarget == end){
+			return false;
+		}
+	}
+	return true;
+}
+
+// the parser reads letters and digits across whitespace as one token, a reparsed range that starts or
+// ends with one next to another outside would be cut apart where the whole text reads one token
+static bool mergesWithNeighbours(const char* text, uint16_t length, uint16_t begin, uint16_t end){
+	uint16_t first = begin;
+	while(first < end && isspace((unsigned char)text[first])) first++;
+	uint16_t before = begin;
+	while(before > 0 && isspace((unsigned char)text[before - 1])) before--;
+	if(first < end && before > 0 && isalnum((unsigned char)text[first]) && isalnum((unsigned char)text[before - 1])){
+		return true;
+	}
+	uint16_t last = end;
+	while(last > begin && isspace((unsigned char)text[last - 1])) last--;
+	uint16_t after = end;
+	while(after < length && isspace((unsigned char)text[after])) after++;
+	return last > begin && after < length && isalnum((unsigned char)text[last - 1]) && isalnum((unsigned char)text[after]);
+}
+
+static void reverseSteps(PipelineVariant entries[], uint16_t begin, uint16_t end){
+	while(begin + 1 < end){
+		PipelineVariant swapped = entries[begin];
+		entries[begin++] = entries[--end];
+		entries[end] = swapped;
+	}
+}
+
+static void reverseSpans(PipelineSpan entries[], uint16_t begin, uint16_t end){
+	while(begin + 1 < end){
+		PipelineSpan swapped = entries[begin];
+		entries[begin++] = entries[--end];
+		entries[end] = swapped;
+	}
+}
+
+// smallest span enclosing [begin, end) that is longer than shorterThan, -1 if there is none
+static int32_t findEnclosingSpan(const PipelineSpans* spans, uint16_t begin, uint16_t end, uint16_t shorterThan){
+	int32_t found = -1;
+	uint16_t foundLength = UINT16_MAX;
+	for(uint16_t spanIdx = 0; spanIdx < spans->count; spanIdx++){
+		const PipelineSpan* span = &spans->entries[spanIdx];
+		uint16_t spanLength = span->sourceEnd - span->sourceBegin;
+		if(span->sourceBegin <= begin && end <= span->sourceEnd && spanLength > shorterThan && spanLength < foundLength){
+			found = spanIdx;
+			foundLength = spanLength;
+		}
+	}
+	return found;
+}
+
+static ParsingError compileText(IncrementalExpression* expression){
+	Pipeline* pipeline = expression->pipeline;
+	clearPipeline(pipeline);
+	expression->spans.count = 0;
+	expression->spans.overflowed = false;
+	expression->spans.pendingReserve = 0;
+	ParsingContext context = {.stream = NULL, .definitions = expression->definitions, .spans = &expression->spans};
+	PeekableStringSlice input = {.slice = {.str = expression->text, .len = expression->length}, .cursor = 0, .context = &context};
+	ParsingError err = compileExpression(pipeline, &input, expression->variables);
+	expression->compiled = err.type == NOERROR && pipeline->errorMask == NO_ERROR;
+	expression->reparsedLength = expression->length;
+	return err;
+}
+
+// Reparses the span at spanIdx, whose text end moved by textDelta, behind the pipeline and splices
+// the steps and spans over the old ones. Returns false and changes nothing when the new text does not
+// compile as that span on its own.
+static bool reparseSpan(IncrementalExpression* expression, uint16_t spanIdx, int32_t textDelta){
+	Pipeline* pipeline = expression->pipeline;
+	PipelineSpans* spans = &expression->spans;
+	PipelineSpan span = spans->entries[spanIdx];
+	uint16_t sourceEnd = (uint16_t)(span.sourceEnd + textDelta);
+	uint16_t length = lengthOfPipeline(pipeline);
+	if(sourceEnd <= span.sourceBegin || length >= pipeline->capacity || spans->count >= spans->capacity
+		|| mergesWithNeighbours(expression->text, expression->length, span.sourceBegin, sourceEnd)){
+		return false;
+	}
+
+	// steps and spans of the new text go into the free storage behind the current ones
+	Pipeline reparsed = createPipeline(&pipeline->entries[length], (uint8_t)(pipeline->capacity - length));
+	PipelineSpans reparsedSpans = {.entries = &spans->entries[spans->count], .count = 0, .capacity = spans->capacity - spans->count, .overflowed = false, .pendingReserve = 0};
+	ParsingContext context = {.stream = NULL, .definitions = expression->definitions, .spans = &reparsedSpans};
+	PeekableStringSlice input = {.slice = {.str = expression->text, .len = sourceEnd}, .cursor = span.sourceBegin, .context = &context};
+	ParsingError err = parseLevels[span.level](&reparsed, &input, expression->variables);
+	if(err.type != NOERROR || reparsed.errorMask != NO_ERROR || reparsedSpans.overflowed || input.cursor != sourceEnd){
+		return false;
+	}
+	uint16_t reparsedLength = lengthOfPipeline(&reparsed);
+	if(endsBoolean(reparsed.entries, 0, reparsedLength) != endsBoolean(pipeline->entries, span.stepBegin, span.stepEnd)){
+		// the enclosing && or || would add or drop its BOOL step
+		return false;
+	}
+
+	int32_t stepDelta = (int32_t)reparsedLength - (span.stepEnd - span.stepBegin);
+	// a definition call behind the span expands its body behind its own end, a longer span may leave
+	// no room for that where the full compile of the text would fail
+	for(uint16_t otherIdx = spanIdx + 1; stepDelta > 0 && otherIdx < spans->count; otherIdx++){
+		const PipelineSpan* other = &spans->entries[otherIdx];
+		if(other->sourceBegin >= span.sourceEnd && other->stepEnd + stepDelta + other->reserve > pipeline->capacity){
+			return false;
+		}
+	}
+
+	// STEPS
+	PipelineVariant* entries = pipeline->entries;
+	for(uint16_t pipelineIdx = 0; pipelineIdx < length; pipelineIdx++){
+		bool outside = pipelineIdx < span.stepBegin || pipelineIdx >= span.stepEnd;
+		if(outside && isJumpStep(&entries[pipelineIdx]) && entries[pipelineIdx].asJumpTarget >= span.stepEnd){
+			entries[pipelineIdx].asJumpTarget = (Index)(entries[pipelineIdx].asJumpTarget + stepDelta);
+		}
+	}
+	for(uint16_t pipelineIdx = length; pipelineIdx < length + reparsedLength; pipelineIdx++){
+		if(isJumpStep(&entries[pipelineIdx])){
+			entries[pipelineIdx].asJumpTarget += span.stepBegin;
+		}
+	}
+	// [old][behind][new] becomes [new][behind] by rotating the last two and closing the gap
+	reverseSteps(entries, span.stepEnd, length);
+	reverseSteps(entries, length, length + reparsedLength);
+	reverseSteps(entries, span.stepEnd, length + reparsedLength);
+	memmove(&entries[span.stepBegin], &entries[span.stepEnd], (length + reparsedLength - span.stepEnd) * sizeof(PipelineVariant));
+	pipeline->index = (Index)(length + stepDelta - 1);
+
+	// SPANS
+	uint16_t reparsedBegin = reparsedSpans.entries[reparsedSpans.count - 1].sourceBegin;
+	// the span is the last of the block holding everything inside it
+	uint16_t blockBegin = spanIdx;
+	while(blockBegin > 0 && spans->entries[blockBegin - 1].sourceBegin >= span.sourceBegin && spans->entries[blockBegin - 1].sourceEnd <= span.sourceEnd){
+		blockBegin--;
+	}
+	for(uint16_t otherIdx = 0; otherIdx < spans->count; otherIdx++){
+		PipelineSpan* other = &spans->entries[otherIdx];
+		if(otherIdx >= blockBegin && otherIdx <= spanIdx){
+			continue;
+		}
+		if(other->sourceBegin <= span.sourceBegin && other->sourceEnd >= span.sourceEnd){
+			// whitespace inserted in front moves the start of the spans beginning with this one
+			if(other->sourceBegin == span.sourceBegin){
+				other->sourceBegin = reparsedBegin;
+			}
+			other->sourceEnd = (uint16_t)(other->sourceEnd + textDelta);
+			other->stepEnd = (Index)(other->stepEnd + stepDelta);
+		}
+		else if(other->sourceBegin >= span.sourceEnd){
+			other->sourceBegin = (uint16_t)(other->sourceBegin + textDelta);
+			other->sourceEnd = (uint16_t)(other->sourceEnd + textDelta);
+			other->stepBegin = (Index)(other->stepBegin + stepDelta);
+			other->stepEnd = (Index)(other->stepEnd + stepDelta);
+		}
+	}
+	for(uint16_t reparsedIdx = 0; reparsedIdx < reparsedSpans.count; reparsedIdx++){
+		reparsedSpans.entries[reparsedIdx].stepBegin += span.stepBegin;
+		reparsedSpans.entries[reparsedIdx].stepEnd += span.stepBegin;
+	}
+	uint16_t count = spans->count;
+	reverseSpans(spans->entries, spanIdx + 1, count);
+	reverseSpans(spans->entries, count, count + reparsedSpans.count);
+	reverseSpans(spans->entries, spanIdx + 1, count + reparsedSpans.count);
+	memmove(&spans->entries[blockBegin], &spans->entries[spanIdx + 1], (count + reparsedSpans.count - spanIdx - 1) * sizeof(PipelineSpan));
+	spans->count = (uint16_t)(count - (spanIdx + 1 - blockBegin) + reparsedSpans.count);
+
+	expression->reparsedLength = sourceEnd - span.sourceBegin;
+	return true;
+}
+
+// extern functions
+
+void initIncrementalExpression(IncrementalExpression* expression, char textStorage[], uint16_t textCapacity, Pipeline* pipeline, PipelineVariablesSlice variables, PipelineSpan spanStorage[], uint16_t spanCapacity){
+	expression->text = textStorage;
+	expression->length = 0;
+	expression->textCapacity = textCapacity;
+	expression->pipeline = pipeline;
+	expression->variables = variables;
+	expression->spans = (PipelineSpans){.entries = spanStorage, .count = 0, .capacity = spanCapacity, .overflowed = false, .pendingReserve = 0};
+	expression->definitions = NULL;
+	expression->compiled = false;
+	expression->reparsedLength = 0;
+}
+
+ParsingError compileIncrementalExpression(IncrementalExpression* expression, StringSlice source){
+	if(source.len > expression->textCapacity){
+		return PARSING_ERROR(TEXT_FULL, expression->textCapacity, '\0');
+	}
+	memcpy(expression->text, source.str, source.len);
+	expression->length = (uint16_t)source.len;
+	return compileText(expression);
+}
+
+ParsingError editIncrementalExpression(IncrementalExpression* expression, uint16_t offset, uint16_t removed, StringSlice inserted){
+	if(offset > expression->length || removed > expression->length - offset){
+		return PARSING_ERROR(UNEXPECTED, offset, '\0');
+	}
+	if(expression->length - removed + inserted.len > expression->textCapacity){
+		return PARSING_ERROR(TEXT_FULL, offset, '\0');
+	}
+	char* text = expression->text;
+	memmove(&text[offset + inserted.len], &text[offset + removed], expression->length - offset - removed);
+	memcpy(&text[offset], inserted.str, inserted.len);
+	expression->length = (uint16_t)(expression->length - removed + inserted.len);
+	int32_t textDelta = (int32_t)inserted.len - removed;
+
+	// spans still describe the text before the edit, the smallest one around it is tried first
+	if(expression->compiled && !expression->spans.overflowed){
+		uint16_t triedLength = 0;
+		int32_t spanIdx;
+		while((spanIdx = findEnclosingSpan(&expression->spans, offset, offset + removed, triedLength)) >= 0){
+			const PipelineSpan* span = &expression->spans.entries[spanIdx];
+			triedLength = span->sourceEnd - span->sourceBegin;
+			if(reparseSpan(expression, (uint16_t)spanIdx, textDelta)){
+				return NO_PARSING_ERROR;
+			}
+		}
+	}
+	return compileText(expression);
+}
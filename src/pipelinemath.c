@@ -1,57 +1,187 @@
 #include "../include/pipelinemath.h"
+#include "../include/pipelinefixed.h"
 
 #include <ctype.h>
 
 // operations 
-ValueType opAdd(PipelineStack* stack){
-	ValueType right = popStackUnchecked(stack);
-	ValueType left = popStackUnchecked(stack);
+ValueType opAdd(const ValueType args[], ValueType last){
+	return args[0] + last;
+}
+
+ValueType opSub(const ValueType args[], ValueType last){
+	return args[0] - last;
+}
+
+ValueType opMul(const ValueType args[], ValueType last){
+	return args[0] * last;
+}
+
+ValueType opDiv(const ValueType args[], ValueType last){
+	return args[0] / last;
+}
+
+ValueType opMod(const ValueType args[], ValueType last){
+	return args[0] % last;
+}
+
+ValueType opPow2(const ValueType args[], ValueType last){
+	(void)args;
+	return last * last;
+}
+
+ValueType opIsqrt(const ValueType args[], ValueType last){
+	(void)args;
+	return fixedIntegerSqrt(last);
+}
+
+ValueType opSqrt(const ValueType args[], ValueType last){
+	(void)args;
+	return fixedSqrt(last);
+}
+
+ValueType opExp(const ValueType args[], ValueType last){
+	(void)args;
+	return fixedExp(last);
+}
+
+ValueType opLog(const ValueType args[], ValueType last){
+	(void)args;
+	return fixedLog(last);
+}
+
+ValueType opSin(const ValueType args[], ValueType last){
+	(void)args;
+	ValueType sine, cosine;
+	fixedSinCos(last, &sine, &cosine);
+	return sine;
+}
+
+ValueType opCos(const ValueType args[], ValueType last){
+	(void)args;
+	ValueType sine, cosine;
+	fixedSinCos(last, &sine, &cosine);
+	return cosine;
+}
+
+ValueType opLerp(const ValueType args[], ValueType last){
+	return fixedLerp(args[0], args[1], last);
+}
+
+ValueType opQmul(const ValueType args[], ValueType last){
+	return fixedMul(args[0], last);
+}
+
+ValueType opQdiv(const ValueType args[], ValueType last){
+	return fixedDiv(args[0], last);
+}
+
+
+// derivatives
+
+bool getQuotientTangent(ValueType dividend, ValueType divisor, ValueType dividendTangent, ValueType divisorTangent, ValueType* tangent){
+	// the squared divisor overflows int32_t from 46341 on and wraps to 0 for multiples of 65536
+	int64_t numerator;
+	if(divisor == 0 || __builtin_sub_overflow((int64_t)dividendTangent * divisor, (int64_t)dividend * divisorTangent, &numerator)){
+		return false;
+	}
+	int64_t quotient = numerator / ((int64_t)divisor * divisor);
+	if(quotient < INT32_MIN || quotient > INT32_MAX){
+		return false;
+	}
+	*tangent = (ValueType)quotient;
+	return true;
+}
+
+ValueType derivativeAdd(const ValueType args[], const ValueType tangents[]){
+	(void)args;
+	return tangents[0] + tangents[1];
+}
+
+ValueType derivativeSub(const ValueType args[], const ValueType tangents[]){
+	(void)args;
+	return tangents[0] - tangents[1];
+}
+
+ValueType derivativeMul(const ValueType args[], const ValueType tangents[]){
+	return tangents[0] * args[1] + args[0] * tangents[1];
+}
+
+ValueType derivativeDiv(const ValueType args[], const ValueType tangents[]){
+	ValueType tangent;
+	return getQuotientTangent(args[0], args[1], tangents[0], tangents[1], &tangent) ? tangent : 0;
+}
+
+ValueType derivativeMod(const ValueType args[], const ValueType tangents[]){
+	// a % b == a - (a / b) * b with the truncated quotient locally constant
+	return tangents[0] - (args[0] / args[1]) * tangents[1];
+}
 
-	return left + right;
+ValueType derivativePow2(const ValueType args[], const ValueType tangents[]){
+	return 2 * args[0] * tangents[0];
 }
 
-ValueType opSub(PipelineStack* stack){
-	ValueType right = popStackUnchecked(stack);
-	ValueType left = popStackUnchecked(stack);
+// fixed point tangents are scaled like their values, the derivative is applied as a Q16.16 factor
 
-	return left - right;
+ValueType derivativeIsqrt(const ValueType args[], const ValueType tangents[]){
+	ValueType root = fixedIntegerSqrt(args[0]);
+	return root > 0 ? tangents[0] / (2 * root) : 0;
 }
 
-ValueType opMul(PipelineStack* stack){
-	ValueType right = popStackUnchecked(stack);
-	ValueType left = popStackUnchecked(stack);
+ValueType derivativeSqrt(const ValueType args[], const ValueType tangents[]){
+	ValueType root = fixedSqrt(args[0]);
+	return root > 0 ? (ValueType)((int64_t)tangents[0] * (FIXED_ONE / 2) / root) : 0;
+}
+
+ValueType derivativeExp(const ValueType args[], const ValueType tangents[]){
+	return fixedMul(tangents[0], fixedExp(args[0]));
+}
 
-	return left * right;
+ValueType derivativeLog(const ValueType args[], const ValueType tangents[]){
+	return args[0] > 0 ? fixedDiv(tangents[0], args[0]) : 0;
 }
 
-ValueType opDiv(PipelineStack* stack){
-	ValueType right = popStackUnchecked(stack);
-	ValueType left = popStackUnchecked(stack);
-	return left / right;
+ValueType derivativeSin(const ValueType args[], const ValueType tangents[]){
+	ValueType sine, cosine;
+	fixedSinCos(args[0], &sine, &cosine);
+	return fixedMul(tangents[0], cosine);
 }
 
-ValueType opMod(PipelineStack* stack){
-	ValueType right = popStackUnchecked(stack);
-	ValueType left = popStackUnchecked(stack);
-	return left % right;
+ValueType derivativeCos(const ValueType args[], const ValueType tangents[]){
+	ValueType sine, cosine;
+	fixedSinCos(args[0], &sine, &cosine);
+	return -fixedMul(tangents[0], sine);
 }
 
-ValueType opPow2(PipelineStack* stack){
-	ValueType powered = popStackUnchecked(stack);
-	return powered * powered;
+ValueType derivativeLerp(const ValueType args[], const ValueType tangents[]){
+	return tangents[0] + fixedMul(tangents[1] - tangents[0], args[2]) + fixedMul(args[1] - args[0], tangents[2]);
 }
 
+ValueType derivativeQmul(const ValueType args[], const ValueType tangents[]){
+	return fixedMul(tangents[0], args[1]) + fixedMul(args[0], tangents[1]);
+}
 
+ValueType derivativeQdiv(const ValueType args[], const ValueType tangents[]){
+	return fixedDiv(tangents[0] - fixedMul(fixedDiv(args[0], args[1]), tangents[1]), args[1]);
+}
 
 // operation map
 
-const OperationMapEntry operationMap [] = {
-	{opAdd,	{MAKE_SLICE_FROM_CONST_STRING("add"), 2}},
-	{opSub, {MAKE_SLICE_FROM_CONST_STRING("sub"), 2}},
-	{opMul, {MAKE_SLICE_FROM_CONST_STRING("mul"), 2}},
-	{opDiv, {MAKE_SLICE_FROM_CONST_STRING("div"), 2}},
-	{opMod, {MAKE_SLICE_FROM_CONST_STRING("mod"), 2}},
-	{opPow2, {MAKE_SLICE_FROM_CONST_STRING("pow2"), 0}}
+const OperationMapEntry operationMap [OPERATION_MAP_COUNT] = {
+	[OPERATION_MAP_ADD] = {opAdd, {MAKE_SLICE_FROM_CONST_STRING("add"), 2}, derivativeAdd, "opAdd"},
+	[OPERATION_MAP_SUB] = {opSub, {MAKE_SLICE_FROM_CONST_STRING("sub"), 2}, derivativeSub, "opSub"},
+	[OPERATION_MAP_MUL] = {opMul, {MAKE_SLICE_FROM_CONST_STRING("mul"), 2}, derivativeMul, "opMul"},
+	[OPERATION_MAP_DIV] = {opDiv, {MAKE_SLICE_FROM_CONST_STRING("div"), 2}, derivativeDiv, "opDiv"},
+	[OPERATION_MAP_MOD] = {opMod, {MAKE_SLICE_FROM_CONST_STRING("mod"), 2}, derivativeMod, "opMod"},
+	[OPERATION_MAP_POW2] = {opPow2, {MAKE_SLICE_FROM_CONST_STRING("pow2"), 1}, derivativePow2, "opPow2"},
+	[OPERATION_MAP_ISQRT] = {opIsqrt, {MAKE_SLICE_FROM_CONST_STRING("isqrt"), 1}, derivativeIsqrt, "opIsqrt"},
+	[OPERATION_MAP_SQRT] = {opSqrt, {MAKE_SLICE_FROM_CONST_STRING("sqrt"), 1}, derivativeSqrt, "opSqrt"},
+	[OPERATION_MAP_EXP] = {opExp, {MAKE_SLICE_FROM_CONST_STRING("exp"), 1}, derivativeExp, "opExp"},
+	[OPERATION_MAP_LOG] = {opLog, {MAKE_SLICE_FROM_CONST_STRING("log"), 1}, derivativeLog, "opLog"},
+	[OPERATION_MAP_SIN] = {opSin, {MAKE_SLICE_FROM_CONST_STRING("sin"), 1}, derivativeSin, "opSin"},
+	[OPERATION_MAP_COS] = {opCos, {MAKE_SLICE_FROM_CONST_STRING("cos"), 1}, derivativeCos, "opCos"},
+	[OPERATION_MAP_LERP] = {opLerp, {MAKE_SLICE_FROM_CONST_STRING("lerp"), 3}, derivativeLerp, "opLerp"},
+	[OPERATION_MAP_QMUL] = {opQmul, {MAKE_SLICE_FROM_CONST_STRING("qmul"), 2}, derivativeQmul, "opQmul"},
+	[OPERATION_MAP_QDIV] = {opQdiv, {MAKE_SLICE_FROM_CONST_STRING("qdiv"), 2}, derivativeQdiv, "opQdiv"}
 };
 
 PipelineOperation getOperationByName(StringSlice name){
@@ -67,13 +197,30 @@ PipelineOperation getOperationByName(StringSlice name){
 
 PipelineOperationMeta getMetaByOperation(PipelineOperation op)
 {
+	const OperationMapEntry* entry = getEntryByOperation(op);
+	if(entry != NULL){
+		return entry->meta;
+	}
+	return (PipelineOperationMeta){.name = MAKE_EMPTY_SLICE, .argCount = 0};
+}
+
+Index getOperationMapIndex(PipelineOperation op){
+	for(size_t idx = 0;  idx < ARRAY_CONST_SIZE(operationMap); idx++){
+		if(operationMap[idx].op == op){
+			return (Index)idx;
+		}
+	}
+	return NONE_INDEX;
+}
+
+const OperationMapEntry* getEntryByOperation(PipelineOperation op){
 	for(size_t idx = 0;  idx < ARRAY_CONST_SIZE(operationMap); idx++){
 		const OperationMapEntry* entry = &operationMap[idx];
 		if(entry->op == op){
-			return entry->meta;
+			return entry;
 		}
 	}
-	return (PipelineOperationMeta){.name = MAKE_EMPTY_SLICE, .argCount = 0};
+	return NULL;
 }
 
 
@@ -0,0 +1,126 @@
+#include "../include/pipelinememo.h"
+
+#include <string.h>
+
+// helper static functions
+
+static uint32_t hashKeys(const ValueType keys[], uint8_t keyCount){
+	uint32_t hash = 0x811C9DC5u;
+	for(uint8_t keyIdx = 0; keyIdx < keyCount; keyIdx++){
+		hash = (hash ^ (uint32_t)keys[keyIdx]) * 0x9E3779B1u;
+		hash ^= hash >> 15;
+	}
+	return hash;
+}
+
+static bool isKeyEqual(const PipelineMemoEntry* entry, const ValueType keys[], uint8_t keyCount){
+	if(!entry->valid){
+		return false;
+	}
+	for(uint8_t keyIdx = 0; keyIdx < keyCount; keyIdx++){
+		if(entry->keys[keyIdx] != keys[keyIdx]){
+			return false;
+		}
+	}
+	return true;
+}
+
+// extern functions
+
+void initPipelineMemo(PipelineMemo* memo, const Pipeline* pipeline, PipelineMemoEntry storage[], uint16_t storageCapacity){
+	memo->pipeline = pipeline;
+	memo->entries = storage;
+	memo->keyCount = 0;
+	memo->bypass = false;
+	memo->hits = 0;
+	memo->misses = 0;
+	memo->bypassed = 0;
+
+	uint16_t setCount = 1;
+	while((uint32_t)setCount * 2 * PIPELINE_MEMO_WAYS <= storageCapacity){
+		setCount *= 2;
+	}
+	memo->setMask = setCount - 1;
+	if(storageCapacity < PIPELINE_MEMO_WAYS){
+		memo->bypass = true;
+	}
+
+	bool hasOperation = false;
+	uint8_t pipelineLength = pipeline->index + 1;
+	for(Index pipelineIdx = 0; pipelineIdx < pipelineLength; pipelineIdx++){
+		const PipelineVariant* variant = &pipeline->entries[pipelineIdx];
+		if(variant->type == OPERATION){
+			hasOperation = true;
+		}
+		if(variant->type != VARIABLE_INDEX){
+			continue;
+		}
+		bool known = false;
+		for(uint8_t keyIdx = 0; keyIdx < memo->keyCount; keyIdx++){
+			known = known || memo->keyIndexes[keyIdx] == variant->asVariableIndex;
+		}
+		if(known){
+			continue;
+		}
+		if(memo->keyCount >= PIPELINE_MEMO_MAX_KEYS){
+			// too many inputs to key on
+			memo->bypass = true;
+			break;
+		}
+		memo->keyIndexes[memo->keyCount++] = variant->asVariableIndex;
+	}
+	if(!hasOperation && pipelineLength < PIPELINE_MEMO_MIN_STEPS){
+		memo->bypass = true;
+	}
+	clearPipelineMemo(memo);
+}
+
+void clearPipelineMemo(PipelineMemo* memo){
+	if(memo->bypass){
+		return;
+	}
+	uint16_t entryCount = (memo->setMask + 1) * PIPELINE_MEMO_WAYS;
+	for(uint16_t entryIdx = 0; entryIdx < entryCount; entryIdx++){
+		memo->entries[entryIdx].valid = false;
+	}
+}
+
+ValueType executePipelineMemo(PipelineMemo* memo, PipelineStack* stack, PipelineVariablesSlice variables){
+	if(memo->bypass){
+		memo->bypassed++;
+		return executePipeline(memo->pipeline, stack, variables);
+	}
+
+	ValueType keys[PIPELINE_MEMO_MAX_KEYS];
+	for(uint8_t keyIdx = 0; keyIdx < memo->keyCount; keyIdx++){
+		keys[keyIdx] = variables.vars[memo->keyIndexes[keyIdx]].value;
+	}
+	PipelineMemoEntry* set = &memo->entries[(hashKeys(keys, memo->keyCount) & memo->setMask) * PIPELINE_MEMO_WAYS];
+
+	// way 0 holds the most recently used entry of the set
+	if(isKeyEqual(&set[0], keys, memo->keyCount)){
+		memo->hits++;
+		return set[0].result;
+	}
+	for(uint8_t way = 1; way < PIPELINE_MEMO_WAYS; way++){
+		if(isKeyEqual(&set[way], keys, memo->keyCount)){
+			PipelineMemoEntry hit = set[way];
+			for(uint8_t moved = way; moved > 0; moved--){
+				set[moved] = set[moved - 1];
+			}
+			set[0] = hit;
+			memo->hits++;
+			return hit.result;
+		}
+	}
+
+	memo->misses++;
+	ValueType result = executePipeline(memo->pipeline, stack, variables);
+	for(uint8_t moved = PIPELINE_MEMO_WAYS - 1; moved > 0; moved--){
+		set[moved] = set[moved - 1];
+	}
+	memcpy(set[0].keys, keys, sizeof(ValueType) * memo->keyCount);
+	set[0].result = result;
+	set[0].valid = true;
+	return result;
+}
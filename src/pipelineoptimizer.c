@@ -0,0 +1,686 @@
+#include "../include/pipelineoptimizer.h"
+
+// helper static functions
+
+static bool isTombstone(const PipelineVariant* variant){
+	return variant->type == NONE;
+}
+
+static uint8_t log2OfPow2(uint32_t value){
+	if(value < 2 || (value & (value - 1)) != 0){
+		return 0;
+	}
+	uint8_t shift = 0;
+	while(value > 1){
+		value >>= 1;
+		shift++;
+	}
+	return shift;
+}
+
+static ConstantDivisor makeMagicDivisor(ValueType divisor, ValueType* magicNumber){
+	const uint32_t two31 = 0x80000000u;
+	uint32_t absDivisor = divisor < 0 ? (uint32_t)0 - (uint32_t)divisor : (uint32_t)divisor;
+	uint32_t t = two31 + ((uint32_t)divisor >> 31);
+	uint32_t absNc = t - 1 - t % absDivisor;
+	uint32_t q1 = two31 / absNc;
+	uint32_t r1 = two31 - q1 * absNc;
+	uint32_t q2 = two31 / absDivisor;
+	uint32_t r2 = two31 - q2 * absDivisor;
+	uint32_t delta;
+	int p = 31;
+	do {
+		p++;
+		q1 *= 2;
+		r1 *= 2;
+		if(r1 >= absNc){
+			q1++;
+			r1 -= absNc;
+		}
+		q2 *= 2;
+		r2 *= 2;
+		if(r2 >= absDivisor){
+			q2++;
+			r2 -= absDivisor;
+		}
+		delta = absDivisor - r2;
+	} while(q1 < delta || (q1 == delta && r1 == 0));
+
+	int32_t magic = (int32_t)(q2 + 1);
+	if(divisor < 0){
+		magic = -magic;
+	}
+
+	*magicNumber = magic;
+	ConstantDivisor result = {
+		.divisor = (divisor >= INT16_MIN && divisor <= INT16_MAX) ? (int16_t)divisor : 0,
+		.shift = (uint8_t)(p - 32),
+		.sign = 0
+	};
+	if(divisor > 0 && magic < 0){
+		result.sign = 1;
+	}
+	else if(divisor < 0 && magic > 0){
+		result.sign = -1;
+	}
+	return result;
+}
+
+typedef struct {
+	Index begin;
+	bool isConstant;
+} FoldOperand;
+
+// one bit per step, set when any jump lands on it
+typedef uint8_t JumpTargets[(NONE_INDEX + 1) / 8];
+
+static void markJumpTargets(const Pipeline* pipeline, JumpTargets targets){
+	memset(targets, 0, sizeof(JumpTargets));
+	uint8_t pipelineLength = pipeline->index + 1;
+	for(Index pipelineIdx = 0; pipelineIdx < pipelineLength; pipelineIdx++){
+		const PipelineVariant* variant = &pipeline->entries[pipelineIdx];
+		if(isJumpStep(variant)){
+			Index target = variant->asJumpTarget;
+			targets[target / 8] |= (uint8_t)(1u << (target % 8));
+		}
+	}
+}
+
+static bool isJumpTarget(const JumpTargets targets, Index pipelineIdx){
+	return (targets[pipelineIdx / 8] >> (pipelineIdx % 8)) & 1;
+}
+
+// deepest stack of the self contained steps [begin, end) whose jumps land within [begin, end], 0 when malformed
+static uint8_t getStepsMaxStackDepth(const PipelineVariant entries[], uint16_t begin, uint16_t end){
+	// stack depth on entry of every step, -1 until a path reaches it
+	int16_t depthAt[NONE_INDEX + 2];
+	for(uint16_t pipelineIdx = begin; pipelineIdx <= end; pipelineIdx++){
+		depthAt[pipelineIdx - begin] = -1;
+	}
+	depthAt[0] = 0;
+
+	int16_t maxDepth = 0;
+	for(uint16_t pipelineIdx = begin; pipelineIdx < end; pipelineIdx++){
+		const PipelineVariant* variant = &entries[pipelineIdx];
+		int16_t depth = depthAt[pipelineIdx - begin];
+		if(depth < 0){
+			continue;
+		}
+		int16_t fallthrough;
+		if(isJumpStep(variant)){
+			Index target = variant->asJumpTarget;
+			if(depth < 1 && variant->type != JUMP){
+				return 0;
+			}
+			int16_t jumped = variant->type == JUMP_IF_ZERO ? depth - 1 : depth;
+			if(target < begin || target > end){
+				return 0;
+			}
+			if(depthAt[target - begin] < jumped){
+				depthAt[target - begin] = jumped;
+			}
+			if(variant->type == JUMP){
+				continue;
+			}
+			fallthrough = depth - 1;
+		}
+		else {
+			int16_t argCount = getStepArgCount(variant);
+			if(argCount > depth){
+				return 0;
+			}
+			fallthrough = depth - argCount + 1;
+		}
+		if(fallthrough > maxDepth){
+			maxDepth = fallthrough;
+		}
+		if(depthAt[pipelineIdx + 1 - begin] < fallthrough){
+			depthAt[pipelineIdx + 1 - begin] = fallthrough;
+		}
+	}
+	return maxDepth > UINT8_MAX ? UINT8_MAX : (uint8_t)maxDepth;
+}
+
+typedef struct {
+	Index begin;
+	uint8_t need;
+} OrderOperand;
+
+// step computing the same value with its two operands swapped, NONE when there is none
+static PipelineVariantType getSwappedStepType(PipelineVariantType type){
+	switch (type)
+	{
+		case OPERATION_NATIVE_ADD:
+		case OPERATION_NATIVE_MUL:
+		case OPERATION_NATIVE_EQ:
+		case OPERATION_NATIVE_NE:
+			return type;
+		case OPERATION_NATIVE_SUB:
+			return OPERATION_NATIVE_RSUB;
+		case OPERATION_NATIVE_RSUB:
+			return OPERATION_NATIVE_SUB;
+		case OPERATION_NATIVE_DIV:
+			return OPERATION_NATIVE_RDIV;
+		case OPERATION_NATIVE_RDIV:
+			return OPERATION_NATIVE_DIV;
+		case OPERATION_NATIVE_MOD:
+			return OPERATION_NATIVE_RMOD;
+		case OPERATION_NATIVE_RMOD:
+			return OPERATION_NATIVE_MOD;
+		case OPERATION_NATIVE_LT:
+			return OPERATION_NATIVE_GT;
+		case OPERATION_NATIVE_GT:
+			return OPERATION_NATIVE_LT;
+		case OPERATION_NATIVE_LE:
+			return OPERATION_NATIVE_GE;
+		case OPERATION_NATIVE_GE:
+			return OPERATION_NATIVE_LE;
+		default:
+			return NONE;
+	}
+}
+
+static void reverseSteps(PipelineVariant entries[], uint16_t begin, uint16_t end){
+	while(begin + 1 < end){
+		PipelineVariant step = entries[begin];
+		entries[begin++] = entries[--end];
+		entries[end] = step;
+	}
+}
+
+// swaps the adjacent operands [begin, middle) and [middle, end), jumps inside them move along
+static void swapOperands(PipelineVariant entries[], uint16_t begin, uint16_t middle, uint16_t end){
+	for(uint16_t stepIdx = begin; stepIdx < end; stepIdx++){
+		PipelineVariant* step = &entries[stepIdx];
+		if(isJumpStep(step)){
+			step->asJumpTarget = stepIdx < middle ? (Index)(step->asJumpTarget + end - middle) : (Index)(step->asJumpTarget - (middle - begin));
+		}
+	}
+	reverseSteps(entries, begin, middle);
+	reverseSteps(entries, middle, end);
+	reverseSteps(entries, begin, end);
+}
+
+#ifndef PIPELINE_FOLD_MAX_ARGS
+#define PIPELINE_FOLD_MAX_ARGS 8
+#endif
+
+// marks [begin, end) dropped, returns the step before end so a pass loop resumes at end
+static Index dropSteps(Pipeline* pipeline, Index begin, Index end){
+	for(Index dropIdx = begin; dropIdx < end; dropIdx++){
+		pipeline->entries[dropIdx] = makeNone();
+	}
+	return end - 1;
+}
+
+// last step before end that is not dropped, where a folded operand ending before end has its constant
+static Index findLastKeptStep(const Pipeline* pipeline, Index end){
+	Index last = end - 1;
+	while(last > 0 && isTombstone(&pipeline->entries[last])){
+		last--;
+	}
+	return last;
+}
+
+static bool isFoldable(const PipelineVariant* variant, const ValueType args[], uint8_t argCount){
+	if(argCount > PIPELINE_FOLD_MAX_ARGS){
+		return false;
+	}
+	if(variant->type == OPERATION_NATIVE_DIV || variant->type == OPERATION_NATIVE_MOD || variant->type == OPERATION_NATIVE_DIV16 || variant->type == OPERATION_NATIVE_MOD16){
+		return args[1] != 0 && !(args[0] == INT32_MIN && args[1] == -1);
+	}
+	if(variant->type == OPERATION_NATIVE_RDIV || variant->type == OPERATION_NATIVE_RMOD){
+		return args[0] != 0 && !(args[1] == INT32_MIN && args[0] == -1);
+	}
+	if(variant->type == OPERATION && (variant->asOperation == opDiv || variant->asOperation == opMod)){
+		return args[1] != 0 && !(args[0] == INT32_MIN && args[1] == -1);
+	}
+	return true;
+}
+
+// extern functions
+
+void compactPipeline(Pipeline* pipeline){
+	if(pipeline->index == NONE_INDEX){
+		return;
+	}
+	uint8_t pipelineLength = pipeline->index + 1;
+	// steps surviving before each position, also the new position of the first survivor at or after it
+	Index keptBefore[NONE_INDEX + 1];
+	uint8_t kept = 0;
+	for(uint16_t pipelineIdx = 0; pipelineIdx < pipelineLength; pipelineIdx++){
+		keptBefore[pipelineIdx] = kept;
+		if(isTombstone(&pipeline->entries[pipelineIdx])){
+			continue;
+		}
+		pipeline->entries[kept++] = pipeline->entries[pipelineIdx];
+	}
+	keptBefore[pipelineLength] = kept;
+
+	for(Index pipelineIdx = 0; pipelineIdx < kept; pipelineIdx++){
+		PipelineVariant* variant = &pipeline->entries[pipelineIdx];
+		if(isJumpStep(variant)){
+			variant->asJumpTarget = keptBefore[variant->asJumpTarget];
+		}
+	}
+	pipeline->index = kept - 1;
+}
+
+bool isJumpStep(const PipelineVariant* variant){
+	switch (variant->type)
+	{
+		case JUMP:
+		case JUMP_IF_ZERO:
+		case JUMP_IF_ZERO_OR_POP:
+		case JUMP_IF_NONZERO_OR_POP:
+			return true;
+		default:
+			return false;
+	}
+}
+
+uint8_t getPipelineMaxStackDepth(const Pipeline* pipeline){
+	if(pipeline->index == NONE_INDEX){
+		return 0;
+	}
+	return getStepsMaxStackDepth(pipeline->entries, 0, pipeline->index + 1);
+}
+
+void initControlFlow(ControlFlowTracker* tracker){
+	tracker->count = 0;
+}
+
+void enterControlFlow(ControlFlowTracker* tracker, const PipelineVariant* jump, Index operandBegin){
+	if(jump->type == JUMP && tracker->count > 0){
+		// end of the true branch of ?:, the region now ends after the false branch
+		tracker->frames[tracker->count - 1].target = jump->asJumpTarget;
+		return;
+	}
+	if(tracker->count >= PIPELINE_STACK_SIZE){
+		return;
+	}
+	tracker->frames[tracker->count++] = (ControlFrame){.begin = operandBegin, .target = jump->asJumpTarget};
+}
+
+bool mergeControlFlow(ControlFlowTracker* tracker, Index pipelineIdx, Index* regionBegin){
+	if(tracker->count == 0 || tracker->frames[tracker->count - 1].target != pipelineIdx){
+		return false;
+	}
+	*regionBegin = tracker->frames[--tracker->count].begin;
+	return true;
+}
+
+uint8_t getStepArgCount(const PipelineVariant* variant){
+	switch (variant->type)
+	{
+		case OPERATION_NATIVE_ADD:
+			return OPERATION_NATIVE_ADD_ARGCOUNT;
+		case OPERATION_NATIVE_SUB:
+			return OPERATION_NATIVE_SUB_ARGCOUNT;
+		case OPERATION_NATIVE_MUL:
+			return OPERATION_NATIVE_MUL_ARGCOUNT;
+		case OPERATION_NATIVE_DIV:
+			return OPERATION_NATIVE_DIV_ARGCOUNT;
+		case OPERATION_NATIVE_MOD:
+			return OPERATION_NATIVE_MOD_ARGCOUNT;
+		case OPERATION_NATIVE_RSUB:
+			return OPERATION_NATIVE_RSUB_ARGCOUNT;
+		case OPERATION_NATIVE_RDIV:
+			return OPERATION_NATIVE_RDIV_ARGCOUNT;
+		case OPERATION_NATIVE_RMOD:
+			return OPERATION_NATIVE_RMOD_ARGCOUNT;
+		case OPERATION_NATIVE_ADD16:
+			return OPERATION_NATIVE_ADD16_ARGCOUNT;
+		case OPERATION_NATIVE_SUB16:
+			return OPERATION_NATIVE_SUB16_ARGCOUNT;
+		case OPERATION_NATIVE_MUL16:
+			return OPERATION_NATIVE_MUL16_ARGCOUNT;
+		case OPERATION_NATIVE_DIV16:
+			return OPERATION_NATIVE_DIV16_ARGCOUNT;
+		case OPERATION_NATIVE_MOD16:
+			return OPERATION_NATIVE_MOD16_ARGCOUNT;
+		case OPERATION_NATIVE_SHL:
+			return OPERATION_NATIVE_SHL_ARGCOUNT;
+		case OPERATION_NATIVE_DIV_POW2:
+			return OPERATION_NATIVE_DIV_POW2_ARGCOUNT;
+		case OPERATION_NATIVE_MOD_POW2:
+			return OPERATION_NATIVE_MOD_POW2_ARGCOUNT;
+		case OPERATION_NATIVE_DIV_MAGIC:
+			return OPERATION_NATIVE_DIV_MAGIC_ARGCOUNT;
+		case OPERATION_NATIVE_MOD_MAGIC:
+			return OPERATION_NATIVE_MOD_MAGIC_ARGCOUNT;
+		case OPERATION_NATIVE_LT:
+			return OPERATION_NATIVE_LT_ARGCOUNT;
+		case OPERATION_NATIVE_LE:
+			return OPERATION_NATIVE_LE_ARGCOUNT;
+		case OPERATION_NATIVE_GT:
+			return OPERATION_NATIVE_GT_ARGCOUNT;
+		case OPERATION_NATIVE_GE:
+			return OPERATION_NATIVE_GE_ARGCOUNT;
+		case OPERATION_NATIVE_EQ:
+			return OPERATION_NATIVE_EQ_ARGCOUNT;
+		case OPERATION_NATIVE_NE:
+			return OPERATION_NATIVE_NE_ARGCOUNT;
+		case OPERATION_NATIVE_BOOL:
+			return OPERATION_NATIVE_BOOL_ARGCOUNT;
+		case OPERATION:
+			return variant->asOperationArgCount;
+		case CONSTANT:
+		case VARIABLE_INDEX:
+		case JUMP:
+		case JUMP_IF_ZERO:
+		case JUMP_IF_ZERO_OR_POP:
+		case JUMP_IF_NONZERO_OR_POP:
+		case NONE:
+			return 0;
+	}
+	return 0;
+}
+
+uint8_t reduceStepByConstant(PipelineVariantType type, ValueType value, PipelineVariant reduced[2]){
+	// INT32_MIN has no positive counterpart, +-1 and 0 are left to the native ops
+	if(value == INT32_MIN || value == 0 || value == 1 || value == -1){
+		return 0;
+	}
+	uint32_t absValue = value < 0 ? (uint32_t)-value : (uint32_t)value;
+	uint8_t shift = log2OfPow2(absValue);
+	ConstantDivisor divisor = {.divisor = 0, .shift = shift, .sign = value < 0 ? -1 : 1};
+	ValueType magic;
+
+	switch (type)
+	{
+		case OPERATION_NATIVE_MUL:
+			if(shift == 0 || value < 0){
+				return 0;
+			}
+			reduced[0] = makeStepAsDivisor(OPERATION_NATIVE_SHL, divisor);
+			return 1;
+		case OPERATION_NATIVE_DIV:
+			if(shift != 0){
+				reduced[0] = makeStepAsDivisor(OPERATION_NATIVE_DIV_POW2, divisor);
+				return 1;
+			}
+			reduced[1] = makeStepAsDivisor(OPERATION_NATIVE_DIV_MAGIC, makeMagicDivisor(value, &magic));
+			reduced[0] = makeStepAsConstant(magic);
+			return 2;
+		case OPERATION_NATIVE_MOD:
+			if(shift != 0){
+				reduced[0] = makeStepAsDivisor(OPERATION_NATIVE_MOD_POW2, divisor);
+				return 1;
+			}
+			// the remainder needs the divisor itself which is stored in 16 bits
+			if(value < -INT16_MAX || value > INT16_MAX){
+				return 0;
+			}
+			reduced[1] = makeStepAsDivisor(OPERATION_NATIVE_MOD_MAGIC, makeMagicDivisor(value, &magic));
+			reduced[0] = makeStepAsConstant(magic);
+			return 2;
+		default:
+			return 0;
+	}
+}
+
+void strengthReducePipeline(Pipeline* pipeline){
+	if(pipeline->index == NONE_INDEX){
+		return;
+	}
+	JumpTargets targets;
+	markJumpTargets(pipeline, targets);
+
+	uint8_t pipelineLength = pipeline->index + 1;
+	for(Index pipelineIdx = 1; pipelineIdx < pipelineLength; pipelineIdx++){
+		PipelineVariant* variant = &pipeline->entries[pipelineIdx];
+		PipelineVariant* right = &pipeline->entries[pipelineIdx - 1];
+		PipelineVariant reduced[2];
+
+		// a jump landing here means the previous step is only the tail of a conditional operand
+		if(isJumpTarget(targets, pipelineIdx)){
+			continue;
+		}
+
+		// `x c OP` where the constant is the right operand, the magic forms put their magic number in its place
+		uint8_t reducedCount = right->type == CONSTANT ? reduceStepByConstant(variant->type, right->asConstant, reduced) : 0;
+		if(reducedCount != 0){
+			*right = reducedCount == 2 ? reduced[0] : makeNone();
+			*variant = reduced[reducedCount - 1];
+			continue;
+		}
+
+		// `c x MUL` where the constant is the left operand of a single step right operand
+		if(variant->type != OPERATION_NATIVE_MUL || pipelineIdx < 2){
+			continue;
+		}
+		PipelineVariant* left = &pipeline->entries[pipelineIdx - 2];
+		if(left->type != CONSTANT || isJumpTarget(targets, pipelineIdx - 1) || (right->type != CONSTANT && right->type != VARIABLE_INDEX)){
+			continue;
+		}
+		// multiplications only reduce to a shift
+		if(reduceStepByConstant(OPERATION_NATIVE_MUL, left->asConstant, reduced) != 0){
+			*left = makeNone();
+			*variant = reduced[0];
+		}
+	}
+	compactPipeline(pipeline);
+}
+
+void foldConstantsPipeline(Pipeline* pipeline){
+	if(pipeline->index == NONE_INDEX){
+		return;
+	}
+	FoldOperand operands[PIPELINE_STACK_SIZE];
+	uint8_t depth = 0;
+
+	PipelineVariant foldStorage[PIPELINE_FOLD_MAX_ARGS + 1];
+	Pipeline fold = CREATE_PIPELINE_FROM_CONST_STORAGE(foldStorage);
+	PipelineStack stack;
+	initStack(&stack);
+	ControlFlowTracker controlFlow;
+	initControlFlow(&controlFlow);
+	// JUMP ending the true branch of each ?: whose constant condition kept that branch
+	Index keptBranchEnds[PIPELINE_STACK_SIZE];
+	uint8_t keptBranchCount = 0;
+
+	uint8_t pipelineLength = pipeline->index + 1;
+	for(Index pipelineIdx = 0; pipelineIdx < pipelineLength; pipelineIdx++){
+		PipelineVariant* variant = &pipeline->entries[pipelineIdx];
+		Index regionBegin;
+		while(depth > 0 && mergeControlFlow(&controlFlow, pipelineIdx, &regionBegin)){
+			operands[depth - 1] = (FoldOperand){.begin = regionBegin, .isConstant = false};
+		}
+		if(variant->type == JUMP && keptBranchCount > 0 && keptBranchEnds[keptBranchCount - 1] == pipelineIdx){
+			// the false branch is dead, its value never replaces the true branch's
+			keptBranchCount--;
+			pipelineIdx = dropSteps(pipeline, pipelineIdx, variant->asJumpTarget);
+			continue;
+		}
+		if(isJumpStep(variant)){
+			if(depth == 0){
+				break;
+			}
+			const FoldOperand* tested = &operands[depth - 1];
+			const PipelineVariant* testedStep = &pipeline->entries[findLastKeptStep(pipeline, pipelineIdx)];
+			bool testsConstant = variant->type != JUMP && tested->isConstant && testedStep->type == CONSTANT;
+			if(!testsConstant || (variant->type == JUMP_IF_ZERO && keptBranchCount >= PIPELINE_STACK_SIZE)){
+				depth--;
+				enterControlFlow(&controlFlow, variant, tested->begin);
+				continue;
+			}
+			bool jumps = variant->type == JUMP_IF_NONZERO_OR_POP ? testedStep->asConstant != 0 : testedStep->asConstant == 0;
+			Index target = variant->asJumpTarget;
+			if(variant->type == JUMP_IF_ZERO){
+				// the condition is popped either way, one branch is left in place of the region
+				depth--;
+				dropSteps(pipeline, tested->begin, pipelineIdx + 1);
+				if(jumps){
+					pipelineIdx = dropSteps(pipeline, pipelineIdx, target);
+				}
+				else {
+					keptBranchEnds[keptBranchCount++] = target - 1;
+				}
+			}
+			else if(jumps){
+				// && and || keep the tested constant as their result
+				pipelineIdx = dropSteps(pipeline, pipelineIdx, target);
+			}
+			else {
+				// the right side alone decides
+				depth--;
+				dropSteps(pipeline, tested->begin, pipelineIdx + 1);
+			}
+			continue;
+		}
+
+		uint8_t argCount = getStepArgCount(variant);
+		if(argCount > depth || depth - argCount >= PIPELINE_STACK_SIZE){
+			// malformed pipeline, leave the rest untouched
+			break;
+		}
+		uint8_t firstArg = depth - argCount;
+		FoldOperand result = {
+			.begin = argCount > 0 ? operands[firstArg].begin : pipelineIdx,
+			.isConstant = variant->type != VARIABLE_INDEX
+		};
+
+		if(argCount > 0){
+			ValueType args[PIPELINE_FOLD_MAX_ARGS];
+			for(uint8_t arg = firstArg; arg < depth; arg++){
+				result.isConstant = result.isConstant && operands[arg].isConstant;
+			}
+			if(result.isConstant && argCount <= PIPELINE_FOLD_MAX_ARGS){
+				// folded operands end with a single constant step, dropped branches may follow it
+				clearPipeline(&fold);
+				for(uint8_t arg = firstArg; arg < depth; arg++){
+					Index argEnd = findLastKeptStep(pipeline, (arg + 1 < depth) ? operands[arg + 1].begin : pipelineIdx);
+					args[arg - firstArg] = pipeline->entries[argEnd].asConstant;
+					pushPipeline(&fold, pipeline->entries[argEnd]);
+				}
+			}
+			if(result.isConstant && isFoldable(variant, args, argCount)){
+				pushPipeline(&fold, *variant);
+				ValueType value = executePipeline(&fold, &stack, (PipelineVariablesSlice)EMPTY_SLICE);
+				for(Index dropIdx = result.begin; dropIdx < pipelineIdx; dropIdx++){
+					pipeline->entries[dropIdx] = makeNone();
+				}
+				*variant = makeStepAsConstant(value);
+			}
+			else {
+				result.isConstant = false;
+			}
+		}
+
+		depth = firstArg;
+		operands[depth++] = result;
+	}
+	compactPipeline(pipeline);
+}
+
+uint8_t reorderPipelineOperands(Pipeline* pipeline){
+	if(pipeline->index == NONE_INDEX){
+		return 0;
+	}
+	OrderOperand operands[PIPELINE_STACK_SIZE];
+	uint8_t depth = 0;
+	ControlFlowTracker controlFlow;
+	initControlFlow(&controlFlow);
+
+	PipelineVariant* entries = pipeline->entries;
+	uint8_t pipelineLength = pipeline->index + 1;
+	for(uint16_t pipelineIdx = 0; pipelineIdx <= pipelineLength; pipelineIdx++){
+		Index regionBegin;
+		while(depth > 0 && mergeControlFlow(&controlFlow, (Index)pipelineIdx, &regionBegin)){
+			// branches are reordered on their own, the region as a whole stays in place
+			operands[depth - 1] = (OrderOperand){.begin = regionBegin, .need = getStepsMaxStackDepth(entries, regionBegin, pipelineIdx)};
+		}
+		if(pipelineIdx == pipelineLength){
+			break;
+		}
+		PipelineVariant* variant = &entries[pipelineIdx];
+		if(isJumpStep(variant)){
+			if(depth == 0){
+				break;
+			}
+			depth--;
+			enterControlFlow(&controlFlow, variant, operands[depth].begin);
+			continue;
+		}
+
+		uint8_t argCount = getStepArgCount(variant);
+		if(argCount > depth || depth - argCount >= PIPELINE_STACK_SIZE){
+			// malformed pipeline, leave the rest untouched
+			break;
+		}
+		uint8_t firstArg = depth - argCount;
+		OrderOperand result = {.begin = argCount > 0 ? operands[firstArg].begin : (Index)pipelineIdx, .need = 1};
+
+		PipelineVariantType swapped = argCount == 2 ? getSwappedStepType(variant->type) : NONE;
+		if(swapped != NONE && operands[firstArg + 1].need > operands[firstArg].need){
+			// evaluating the deeper right operand first keeps one value less alive during it
+			swapOperands(entries, operands[firstArg].begin, operands[firstArg + 1].begin, pipelineIdx);
+			variant->type = swapped;
+			uint8_t leftNeed = operands[firstArg].need;
+			operands[firstArg].need = operands[firstArg + 1].need;
+			operands[firstArg + 1].need = leftNeed;
+		}
+		// every operand is evaluated on top of the values of the ones before it
+		for(uint8_t arg = 0; arg < argCount; arg++){
+			uint16_t need = operands[firstArg + arg].need + arg;
+			if(need > result.need){
+				result.need = need > UINT8_MAX ? UINT8_MAX : (uint8_t)need;
+			}
+		}
+
+		depth = firstArg;
+		operands[depth++] = result;
+	}
+	return getPipelineMaxStackDepth(pipeline);
+}
+
+int8_t specializePipeline(const Pipeline* source, Pipeline* target, PipelineVariablesSlice variables, const bool known[], PipelineVariable remaining[]){
+	clearPipeline(target);
+	if(source->index == NONE_INDEX){
+		return 0;
+	}
+
+	uint8_t pipelineLength = source->index + 1;
+	for(Index pipelineIdx = 0; pipelineIdx < pipelineLength; pipelineIdx++){
+		const PipelineVariant* variant = &source->entries[pipelineIdx];
+		if(variant->type == VARIABLE_INDEX && known[variant->asVariableIndex]){
+			pushPipeline(target, makeStepAsConstant(variables.vars[variant->asVariableIndex].value));
+		}
+		else {
+			pushPipeline(target, *variant);
+		}
+	}
+	if(target->errorMask != NO_ERROR){
+		return -1;
+	}
+	foldConstantsPipeline(target);
+
+	Index renumbered[INT8_MAX];
+	for(int8_t varIdx = 0; varIdx < variables.len; varIdx++){
+		renumbered[varIdx] = NONE_INDEX;
+	}
+	pipelineLength = target->index + 1;
+	for(Index pipelineIdx = 0; pipelineIdx < pipelineLength; pipelineIdx++){
+		const PipelineVariant* variant = &target->entries[pipelineIdx];
+		if(variant->type == VARIABLE_INDEX){
+			renumbered[variant->asVariableIndex] = 0;
+		}
+	}
+
+	int8_t remainingLen = 0;
+	for(int8_t varIdx = 0; varIdx < variables.len; varIdx++){
+		if(renumbered[varIdx] == NONE_INDEX){
+			continue;
+		}
+		renumbered[varIdx] = remainingLen;
+		remaining[remainingLen++] = variables.vars[varIdx];
+	}
+	for(Index pipelineIdx = 0; pipelineIdx < pipelineLength; pipelineIdx++){
+		PipelineVariant* variant = &target->entries[pipelineIdx];
+		if(variant->type == VARIABLE_INDEX){
+			variant->asVariableIndex = renumbered[variant->asVariableIndex];
+		}
+	}
+	return remainingLen;
+}
@@ -0,0 +1,149 @@
+#include "../include/pipelineprofile.h"
+
+#ifdef PIPELINE_PROFILING
+
+#include "../include/pipelinemath.h"
+
+#include <stdio.h>
+
+PipelineProfile pipelineProfile;
+
+static const char* const stepNames[PIPELINE_VARIANT_TYPE_COUNT] = {
+	[OPERATION_NATIVE_ADD] = "native add",
+	[OPERATION_NATIVE_SUB] = "native sub",
+	[OPERATION_NATIVE_MUL] = "native mul",
+	[OPERATION_NATIVE_DIV] = "native div",
+	[OPERATION_NATIVE_MOD] = "native mod",
+	[OPERATION_NATIVE_RSUB] = "native rsub",
+	[OPERATION_NATIVE_RDIV] = "native rdiv",
+	[OPERATION_NATIVE_RMOD] = "native rmod",
+	[OPERATION_NATIVE_ADD16] = "native add16",
+	[OPERATION_NATIVE_SUB16] = "native sub16",
+	[OPERATION_NATIVE_MUL16] = "native mul16",
+	[OPERATION_NATIVE_DIV16] = "native div16",
+	[OPERATION_NATIVE_MOD16] = "native mod16",
+	[OPERATION_NATIVE_SHL] = "native shl",
+	[OPERATION_NATIVE_DIV_POW2] = "div pow2",
+	[OPERATION_NATIVE_MOD_POW2] = "mod pow2",
+	[OPERATION_NATIVE_DIV_MAGIC] = "div magic",
+	[OPERATION_NATIVE_MOD_MAGIC] = "mod magic",
+	[OPERATION_NATIVE_LT] = "native lt",
+	[OPERATION_NATIVE_LE] = "native le",
+	[OPERATION_NATIVE_GT] = "native gt",
+	[OPERATION_NATIVE_GE] = "native ge",
+	[OPERATION_NATIVE_EQ] = "native eq",
+	[OPERATION_NATIVE_NE] = "native ne",
+	[OPERATION_NATIVE_BOOL] = "native bool",
+	[JUMP] = "jump",
+	[JUMP_IF_ZERO] = "jump if zero",
+	[JUMP_IF_ZERO_OR_POP] = "jump and",
+	[JUMP_IF_NONZERO_OR_POP] = "jump or",
+	[CONSTANT] = "constant",
+	[VARIABLE_INDEX] = "variable",
+	[OPERATION] = "operation",
+	[NONE] = "none"
+};
+
+static uint8_t histogramBucket(ProfileCycles cycles){
+	uint8_t bucket = 0;
+	while(cycles > 1 && bucket < PIPELINE_PROFILE_HISTOGRAM_BUCKETS - 1){
+		cycles >>= 1;
+		bucket++;
+	}
+	return bucket;
+}
+
+void resetPipelineProfile(void){
+	memset(&pipelineProfile, 0, sizeof(pipelineProfile));
+}
+
+void profileOperation(PipelineOperation op){
+	for(uint8_t idx = 0; idx < pipelineProfile.operationCount; idx++){
+		if(pipelineProfile.operations[idx].op == op){
+			pipelineProfile.operations[idx].calls++;
+			return;
+		}
+	}
+	if(pipelineProfile.operationCount >= PIPELINE_PROFILE_MAX_OPERATIONS){
+		pipelineProfile.droppedEvents++;
+		return;
+	}
+	OperationProfile* entry = &pipelineProfile.operations[pipelineProfile.operationCount++];
+	entry->op = op;
+	entry->calls = 1;
+}
+
+void profilePipeline(const Pipeline* pipeline, ProfileCycles cycles){
+	PipelineEvaluationProfile* entry = NULL;
+	for(uint8_t idx = 0; idx < pipelineProfile.pipelineCount; idx++){
+		if(pipelineProfile.pipelines[idx].pipeline == pipeline){
+			entry = &pipelineProfile.pipelines[idx];
+			break;
+		}
+	}
+	if(entry == NULL){
+		if(pipelineProfile.pipelineCount >= PIPELINE_PROFILE_MAX_PIPELINES){
+			pipelineProfile.droppedEvents++;
+			return;
+		}
+		entry = &pipelineProfile.pipelines[pipelineProfile.pipelineCount++];
+		entry->pipeline = pipeline;
+	}
+	entry->evaluations++;
+	entry->cycles += cycles;
+	entry->histogram[histogramBucket(cycles)]++;
+}
+
+void dumpPipelineProfile(ProfileWriter write){
+	char line[96];
+
+	write("steps:");
+	for(uint8_t type = 0; type < PIPELINE_VARIANT_TYPE_COUNT; type++){
+		const StepProfile* step = &pipelineProfile.steps[type];
+		if(step->count == 0){
+			continue;
+		}
+		snprintf(line, sizeof(line), "  %-12s count %10lu cycles %12llu avg %6llu",
+			stepNames[type] ? stepNames[type] : "?",
+			(unsigned long)step->count,
+			(unsigned long long)step->cycles,
+			(unsigned long long)(step->cycles / step->count)
+		);
+		write(line);
+	}
+
+	write("operations:");
+	for(uint8_t idx = 0; idx < pipelineProfile.operationCount; idx++){
+		const OperationProfile* operation = &pipelineProfile.operations[idx];
+		StringSlice name = getMetaByOperation(operation->op).name;
+		snprintf(line, sizeof(line), "  %-12.*s calls %10lu", (int)name.len, name.str ? name.str : "", (unsigned long)operation->calls);
+		write(line);
+	}
+
+	write("pipelines:");
+	for(uint8_t idx = 0; idx < pipelineProfile.pipelineCount; idx++){
+		const PipelineEvaluationProfile* entry = &pipelineProfile.pipelines[idx];
+		snprintf(line, sizeof(line), "  %p evaluations %10lu avg cycles %8llu",
+			(const void*)entry->pipeline,
+			(unsigned long)entry->evaluations,
+			(unsigned long long)(entry->cycles / entry->evaluations)
+		);
+		write(line);
+		for(uint8_t bucket = 0; bucket < PIPELINE_PROFILE_HISTOGRAM_BUCKETS; bucket++){
+			if(entry->histogram[bucket] == 0){
+				continue;
+			}
+			snprintf(line, sizeof(line), "    < %10lu cycles: %lu", 2ul << bucket, (unsigned long)entry->histogram[bucket]);
+			write(line);
+		}
+	}
+
+	snprintf(line, sizeof(line), "max stack depth: %u", pipelineProfile.maxStackDepth);
+	write(line);
+	if(pipelineProfile.droppedEvents != 0){
+		snprintf(line, sizeof(line), "dropped events (tables full): %lu", (unsigned long)pipelineProfile.droppedEvents);
+		write(line);
+	}
+}
+
+#endif
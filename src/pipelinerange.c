@@ -0,0 +1,314 @@
+#include "../include/pipelinerange.h"
+#include "../include/pipelineoptimizer.h"
+
+// helper static functions
+
+// ranges are computed 64 bit wide so an overflow shows up as a bound outside ValueType
+typedef struct {
+	int64_t low;
+	int64_t high;
+} WideRange;
+
+static WideRange widenRange(ValueRange range){
+	return (WideRange){.low = range.low, .high = range.high};
+}
+
+static WideRange joinRanges(WideRange left, WideRange right){
+	return (WideRange){
+		.low = left.low < right.low ? left.low : right.low,
+		.high = left.high > right.high ? left.high : right.high
+	};
+}
+
+static bool isWithin(WideRange range, int64_t low, int64_t high){
+	return range.low >= low && range.high <= high;
+}
+
+static bool containsValue(WideRange range, int64_t value){
+	return range.low <= value && value <= range.high;
+}
+
+static int64_t maxMagnitude(WideRange range){
+	int64_t low = range.low < 0 ? -range.low : range.low;
+	int64_t high = range.high < 0 ? -range.high : range.high;
+	return low > high ? low : high;
+}
+
+static WideRange hullOfCorners(int64_t a, int64_t b, int64_t c, int64_t d){
+	WideRange hull = joinRanges((WideRange){a, a}, (WideRange){b, b});
+	hull = joinRanges(hull, (WideRange){c, c});
+	return joinRanges(hull, (WideRange){d, d});
+}
+
+// truncating division is monotonic in both operands while the divisor keeps its sign,
+// the extremes are at the corners of each side of zero
+static WideRange divideRanges(WideRange dividend, WideRange divisor){
+	WideRange quotient = {.low = 0, .high = 0};
+	bool any = false;
+	WideRange sides[] = {
+		{.low = divisor.low, .high = divisor.high < -1 ? divisor.high : -1},
+		{.low = divisor.low > 1 ? divisor.low : 1, .high = divisor.high}
+	};
+	for(uint8_t side = 0; side < 2; side++){
+		if(sides[side].low > sides[side].high){
+			continue;
+		}
+		WideRange corners = hullOfCorners(
+			dividend.low / sides[side].low, dividend.low / sides[side].high,
+			dividend.high / sides[side].low, dividend.high / sides[side].high);
+		quotient = any ? joinRanges(quotient, corners) : corners;
+		any = true;
+	}
+	return quotient;
+}
+
+// the remainder takes the sign of the dividend and stays below both |dividend| and |divisor|
+static WideRange moduloByMagnitude(WideRange dividend, int64_t divisorMagnitude){
+	int64_t bound = divisorMagnitude > 0 ? divisorMagnitude - 1 : 0;
+	WideRange remainder = {
+		.low = dividend.low < 0 ? (-dividend.low < bound ? dividend.low : -bound) : 0,
+		.high = dividend.high > 0 ? (dividend.high < bound ? dividend.high : bound) : 0
+	};
+	return remainder;
+}
+
+static bool isDivisionFaultPossible(WideRange dividend, WideRange divisor){
+	return containsValue(divisor, 0) || (dividend.low == INT32_MIN && containsValue(divisor, -1));
+}
+
+// constant divisor of the strength reduced forms, 0 when it is not stored
+static int64_t getConstantDivisor(const PipelineVariant* variant){
+	const ConstantDivisor* divisor = &variant->asDivisor;
+	if(variant->type == OPERATION_NATIVE_DIV_POW2 || variant->type == OPERATION_NATIVE_MOD_POW2){
+		int64_t power = (int64_t)1 << divisor->shift;
+		return divisor->sign < 0 ? -power : power;
+	}
+	return divisor->divisor;
+}
+
+// range of the step result from the operand ranges, clears the flags the step cannot guarantee
+static WideRange getStepRange(const PipelineVariant* variant, const WideRange args[], uint8_t* flags, bool* quotientFits16){
+	*quotientFits16 = true;
+	switch (variant->type)
+	{
+		case OPERATION_NATIVE_ADD:
+		case OPERATION_NATIVE_ADD16:
+			return (WideRange){args[0].low + args[1].low, args[0].high + args[1].high};
+		case OPERATION_NATIVE_SUB:
+		case OPERATION_NATIVE_SUB16:
+			return (WideRange){args[0].low - args[1].high, args[0].high - args[1].low};
+		case OPERATION_NATIVE_RSUB:
+			return (WideRange){args[1].low - args[0].high, args[1].high - args[0].low};
+		case OPERATION_NATIVE_MUL:
+		case OPERATION_NATIVE_MUL16:
+			return hullOfCorners(args[0].low * args[1].low, args[0].low * args[1].high, args[0].high * args[1].low, args[0].high * args[1].high);
+		case OPERATION_NATIVE_DIV:
+		case OPERATION_NATIVE_DIV16:
+		case OPERATION_NATIVE_RDIV:
+		case OPERATION_NATIVE_MOD:
+		case OPERATION_NATIVE_MOD16:
+		case OPERATION_NATIVE_RMOD:
+			{
+				bool reversed = variant->type == OPERATION_NATIVE_RDIV || variant->type == OPERATION_NATIVE_RMOD;
+				WideRange dividend = reversed ? args[1] : args[0];
+				WideRange divisor = reversed ? args[0] : args[1];
+				if(isDivisionFaultPossible(dividend, divisor)){
+					*flags &= ~RANGE_NO_DIVISION_FAULT;
+				}
+				if(divisor.low == 0 && divisor.high == 0){
+					// always faults, nothing sensible to propagate
+					return widenRange(FULL_VALUE_RANGE);
+				}
+				WideRange quotient = divideRanges(dividend, divisor);
+				if(variant->type == OPERATION_NATIVE_DIV || variant->type == OPERATION_NATIVE_DIV16 || variant->type == OPERATION_NATIVE_RDIV){
+					return quotient;
+				}
+				// INT16_MIN % -1 traps like the division where int is 16 bits
+				*quotientFits16 = isWithin(quotient, INT16_MIN, INT16_MAX);
+				return moduloByMagnitude(dividend, maxMagnitude(divisor));
+			}
+		case OPERATION_NATIVE_SHL:
+			return (WideRange){args[0].low * ((int64_t)1 << variant->asDivisor.shift), args[0].high * ((int64_t)1 << variant->asDivisor.shift)};
+		case OPERATION_NATIVE_DIV_POW2:
+		case OPERATION_NATIVE_DIV_MAGIC:
+			{
+				int64_t divisor = getConstantDivisor(variant);
+				if(divisor == 0){
+					// divisor too large to be stored, |divisor| >= 2 still halves the magnitude
+					int64_t bound = maxMagnitude(args[0]) / 2;
+					return (WideRange){-bound, bound};
+				}
+				return divideRanges(args[0], (WideRange){divisor, divisor});
+			}
+		case OPERATION_NATIVE_MOD_POW2:
+		case OPERATION_NATIVE_MOD_MAGIC:
+			{
+				int64_t divisor = getConstantDivisor(variant);
+				return moduloByMagnitude(args[0], divisor < 0 ? -divisor : divisor);
+			}
+		case OPERATION_NATIVE_LT:
+		case OPERATION_NATIVE_LE:
+		case OPERATION_NATIVE_GT:
+		case OPERATION_NATIVE_GE:
+		case OPERATION_NATIVE_EQ:
+		case OPERATION_NATIVE_NE:
+		case OPERATION_NATIVE_BOOL:
+			return (WideRange){0, 1};
+		case CONSTANT:
+			return (WideRange){variant->asConstant, variant->asConstant};
+		default:
+			// registered operations
+			return widenRange(FULL_VALUE_RANGE);
+	}
+}
+
+// extern functions
+
+bool analyzePipelineRanges(const Pipeline* pipeline, const ValueRange variableRanges[], int8_t variableCount, StepRange steps[]){
+	if(pipeline->index == NONE_INDEX){
+		return true;
+	}
+	WideRange operands[PIPELINE_STACK_SIZE];
+	Index operandBegins[PIPELINE_STACK_SIZE];
+	uint8_t depth = 0;
+	ControlFlowTracker controlFlow;
+	initControlFlow(&controlFlow);
+	// values leaving each open region through a jump, joined with the fall through value at the merge
+	WideRange jumped[PIPELINE_STACK_SIZE];
+	bool hasJumped[PIPELINE_STACK_SIZE];
+
+	uint8_t pipelineLength = pipeline->index + 1;
+	for(uint16_t pipelineIdx = 0; pipelineIdx <= pipelineLength; pipelineIdx++){
+		Index regionBegin;
+		while(depth > 0 && mergeControlFlow(&controlFlow, (Index)pipelineIdx, &regionBegin)){
+			uint8_t frame = controlFlow.count;
+			if(hasJumped[frame]){
+				operands[depth - 1] = joinRanges(operands[depth - 1], jumped[frame]);
+			}
+			operandBegins[depth - 1] = regionBegin;
+		}
+		if(pipelineIdx == pipelineLength){
+			break;
+		}
+
+		const PipelineVariant* variant = &pipeline->entries[pipelineIdx];
+		StepRange* step = &steps[pipelineIdx];
+		step->flags = RANGE_NO_OVERFLOW | RANGE_NO_DIVISION_FAULT;
+		if(variant->type == NONE){
+			return false;
+		}
+		if(isJumpStep(variant)){
+			bool closesBranch = variant->type == JUMP;
+			if(depth == 0 || (closesBranch ? controlFlow.count == 0 : controlFlow.count >= PIPELINE_STACK_SIZE)){
+				return false;
+			}
+			depth--;
+			WideRange tested = operands[depth];
+			step->result = (ValueRange){(ValueType)tested.low, (ValueType)tested.high};
+			uint8_t frame = closesBranch ? controlFlow.count - 1 : controlFlow.count;
+			enterControlFlow(&controlFlow, variant, operandBegins[depth]);
+			switch (variant->type)
+			{
+				case JUMP_IF_ZERO:
+					// the condition is consumed on both paths
+					hasJumped[frame] = false;
+					break;
+				case JUMP_IF_ZERO_OR_POP:
+					// only a zero is kept when jumping
+					jumped[frame] = (WideRange){0, 0};
+					hasJumped[frame] = true;
+					break;
+				case JUMP_IF_NONZERO_OR_POP:
+					tested.low += tested.low == 0 && tested.high > 0;
+					tested.high -= tested.high == 0 && tested.low < 0;
+					jumped[frame] = tested;
+					hasJumped[frame] = true;
+					break;
+				default:
+					jumped[frame] = hasJumped[frame] ? joinRanges(jumped[frame], tested) : tested;
+					hasJumped[frame] = true;
+					break;
+			}
+			continue;
+		}
+
+		uint8_t argCount = getStepArgCount(variant);
+		if(argCount > depth || depth - argCount >= PIPELINE_STACK_SIZE){
+			return false;
+		}
+		uint8_t firstArg = depth - argCount;
+		WideRange result;
+		bool quotientFits16;
+		if(variant->type == VARIABLE_INDEX){
+			Index variableIndex = variant->asVariableIndex;
+			bool declared = variableRanges != NULL && variableIndex < variableCount;
+			result = widenRange(declared ? variableRanges[variableIndex] : FULL_VALUE_RANGE);
+			quotientFits16 = true;
+		}
+		else {
+			result = getStepRange(variant, &operands[firstArg], &step->flags, &quotientFits16);
+		}
+
+		bool fits16 = quotientFits16 && isWithin(result, INT16_MIN, INT16_MAX);
+		bool fits8 = isWithin(result, INT8_MIN, INT8_MAX);
+		for(uint8_t arg = firstArg; arg < depth; arg++){
+			fits16 = fits16 && isWithin(operands[arg], INT16_MIN, INT16_MAX);
+			fits8 = fits8 && isWithin(operands[arg], INT8_MIN, INT8_MAX);
+		}
+		if(!isWithin(result, INT32_MIN, INT32_MAX)){
+			// the step wraps around and may produce anything
+			step->flags &= ~RANGE_NO_OVERFLOW;
+			result = widenRange(FULL_VALUE_RANGE);
+		}
+		step->flags |= (fits16 ? RANGE_FITS_16 : 0) | (fits16 && fits8 ? RANGE_FITS_8 : 0);
+		step->result = (ValueRange){(ValueType)result.low, (ValueType)result.high};
+
+		Index begin = argCount > 0 ? operandBegins[firstArg] : (Index)pipelineIdx;
+		depth = firstArg;
+		operandBegins[depth] = begin;
+		operands[depth++] = result;
+	}
+	return true;
+}
+
+uint8_t narrowPipeline(Pipeline* pipeline, const StepRange steps[]){
+	if(pipeline->index == NONE_INDEX){
+		return 0;
+	}
+	uint8_t narrowed = 0;
+	uint8_t pipelineLength = pipeline->index + 1;
+	for(Index pipelineIdx = 0; pipelineIdx < pipelineLength; pipelineIdx++){
+		PipelineVariant* variant = &pipeline->entries[pipelineIdx];
+		if(!(steps[pipelineIdx].flags & RANGE_FITS_16)){
+			continue;
+		}
+		PipelineVariantType narrowType;
+		switch (variant->type)
+		{
+			case OPERATION_NATIVE_ADD:
+				narrowType = OPERATION_NATIVE_ADD16;
+				break;
+			case OPERATION_NATIVE_SUB:
+				narrowType = OPERATION_NATIVE_SUB16;
+				break;
+			case OPERATION_NATIVE_MUL:
+				narrowType = OPERATION_NATIVE_MUL16;
+				break;
+			case OPERATION_NATIVE_DIV:
+				narrowType = OPERATION_NATIVE_DIV16;
+				break;
+			case OPERATION_NATIVE_MOD:
+				narrowType = OPERATION_NATIVE_MOD16;
+				break;
+			default:
+				continue;
+		}
+		// divisions that may fault stay wide, a zero divisor must not hide behind a narrow opcode
+		if(!(steps[pipelineIdx].flags & RANGE_NO_DIVISION_FAULT)){
+			continue;
+		}
+		variant->type = narrowType;
+		narrowed++;
+	}
+	return narrowed;
+}
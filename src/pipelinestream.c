@@ -0,0 +1,148 @@
+#include "../include/pipelinestream.h"
+
+// helper static functions
+
+static ValueType readRing(const StreamRing* ring, uint16_t samplesAgo){
+	if(samplesAgo == 0 || samplesAgo > ring->length){
+		return 0;
+	}
+	uint16_t at = (uint16_t)((ring->head + ring->length - samplesAgo) % ring->length);
+	return ring->values[at];
+}
+
+static void writeRing(StreamRing* ring, ValueType value){
+	if(ring->length == 0){
+		return;
+	}
+	ring->values[ring->head] = value;
+	ring->head = (uint16_t)((ring->head + 1) % ring->length);
+}
+
+static void requireRing(PipelineStream* stream, Index ring, uint16_t length){
+	if(stream->rings[ring].length < length){
+		stream->rings[ring].length = length;
+	}
+}
+
+// extern functions
+
+void initPipelineStream(PipelineStream* stream, ValueType historyStorage[], uint16_t historyCapacity){
+	stream->pipeline = NULL;
+	stream->sampleLen = 0;
+	stream->slotCount = 0;
+	stream->historyStorage = historyStorage;
+	stream->historyCapacity = historyCapacity;
+	for(uint8_t ring = 0; ring < ARRAY_CONST_SIZE(stream->rings); ring++){
+		stream->rings[ring] = (StreamRing){.values = NULL, .length = 0, .head = 0};
+	}
+}
+
+Index addStreamSlot(PipelineStream* stream, StreamSlotKind kind, Index source, uint16_t param){
+	for(uint8_t slotIdx = 0; slotIdx < stream->slotCount; slotIdx++){
+		const StreamSlot* slot = &stream->slots[slotIdx];
+		if(slot->kind == kind && slot->source == source && slot->param == param){
+			return stream->sampleLen + slotIdx;
+		}
+	}
+	if(stream->slotCount >= PIPELINE_STREAM_MAX_SLOTS){
+		return NONE_INDEX;
+	}
+	stream->slots[stream->slotCount] = (StreamSlot){.kind = kind, .source = source, .param = param, .sum = 0};
+	return stream->sampleLen + stream->slotCount++;
+}
+
+ParsingError compileStreamExpression(PipelineStream* stream, Pipeline* pipeline, PeekableStringSlice* peekableSlice, PipelineVariablesSlice sampleVariables){
+	initPipelineStream(stream, stream->historyStorage, stream->historyCapacity);
+	if(sampleVariables.len > PIPELINE_STREAM_MAX_VARIABLES){
+		return PARSING_ERROR(HISTORY_FULL, 0, ' ');
+	}
+	stream->pipeline = pipeline;
+	stream->sampleLen = sampleVariables.len;
+	for(int8_t varIdx = 0; varIdx < sampleVariables.len; varIdx++){
+		stream->variables[varIdx] = sampleVariables.vars[varIdx];
+	}
+
+	ParsingContext* previousContext = peekableSlice->context;
+	ParsingContext context = previousContext != NULL ? *previousContext : (ParsingContext){.stream = NULL, .definitions = NULL, .spans = NULL};
+	context.stream = stream;
+	peekableSlice->context = &context;
+	ParsingError err = compileExpression(pipeline, peekableSlice, sampleVariables);
+	peekableSlice->context = previousContext;
+	if(err.type != NOERROR){
+		return err;
+	}
+
+	for(uint8_t slotIdx = 0; slotIdx < stream->slotCount; slotIdx++){
+		const StreamSlot* slot = &stream->slots[slotIdx];
+		Index ring = slot->kind == STREAM_OUT ? STREAM_OUTPUT_RING : slot->source;
+		requireRing(stream, ring, slot->kind == STREAM_DELTA ? 1 : slot->param);
+		stream->variables[stream->sampleLen + slotIdx] = (PipelineVariable){.name = '\0', .value = 0};
+	}
+
+	uint16_t used = 0;
+	for(uint8_t ring = 0; ring < ARRAY_CONST_SIZE(stream->rings); ring++){
+		uint16_t length = stream->rings[ring].length;
+		if(length == 0){
+			continue;
+		}
+		if(used + length > stream->historyCapacity){
+			return PARSING_ERROR(HISTORY_FULL, peekableSlice->cursor, ' ');
+		}
+		stream->rings[ring].values = &stream->historyStorage[used];
+		used += length;
+	}
+	resetPipelineStream(stream);
+	return NO_PARSING_ERROR;
+}
+
+void resetPipelineStream(PipelineStream* stream){
+	for(uint8_t ring = 0; ring < ARRAY_CONST_SIZE(stream->rings); ring++){
+		StreamRing* streamRing = &stream->rings[ring];
+		streamRing->head = 0;
+		for(uint16_t at = 0; at < streamRing->length; at++){
+			streamRing->values[at] = 0;
+		}
+	}
+	for(uint8_t slotIdx = 0; slotIdx < stream->slotCount; slotIdx++){
+		stream->slots[slotIdx].sum = 0;
+	}
+}
+
+ValueType stepPipelineStream(PipelineStream* stream, PipelineStack* stack, const ValueType sample[]){
+	for(int8_t varIdx = 0; varIdx < stream->sampleLen; varIdx++){
+		stream->variables[varIdx].value = sample[varIdx];
+	}
+
+	for(uint8_t slotIdx = 0; slotIdx < stream->slotCount; slotIdx++){
+		StreamSlot* slot = &stream->slots[slotIdx];
+		ValueType value = 0;
+		switch (slot->kind)
+		{
+			case STREAM_PREV:
+				value = readRing(&stream->rings[slot->source], slot->param);
+				break;
+			case STREAM_DELTA:
+				value = sample[slot->source] - readRing(&stream->rings[slot->source], 1);
+				break;
+			case STREAM_SUM:
+			case STREAM_AVG:
+				// the sample leaving the window is still in the ring until this step is recorded
+				slot->sum += sample[slot->source] - readRing(&stream->rings[slot->source], slot->param);
+				value = slot->kind == STREAM_SUM ? slot->sum : slot->sum / (ValueType)slot->param;
+				break;
+			case STREAM_OUT:
+				value = readRing(&stream->rings[STREAM_OUTPUT_RING], slot->param);
+				break;
+		}
+		stream->variables[stream->sampleLen + slotIdx].value = value;
+	}
+
+	PipelineVariablesSlice variables = {stream->variables, (int8_t)(stream->sampleLen + stream->slotCount)};
+	ValueType result = executePipeline(stream->pipeline, stack, variables);
+
+	for(int8_t varIdx = 0; varIdx < stream->sampleLen; varIdx++){
+		writeRing(&stream->rings[varIdx], sample[varIdx]);
+	}
+	writeRing(&stream->rings[STREAM_OUTPUT_RING], result);
+	return result;
+}
@@ -0,0 +1,522 @@
+#include "../include/pipelinefixed.h"
+#include "../include/pipelinecodegen.h"
+#include "../include/expressionparser.h"
+#include "../include/pipelineoptimizer.h"
+#include "../include/pipelinebatch.h"
+#include "../include/pipelinechecked.h"
+#include "../include/pipelineincremental.h"
+
+#include <math.h>
+#include <quadmath.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Micro benchmarks of the library against the alternatives a user would otherwise reach for.
+//   benchmark [section]   runs every section when none is given
+// fixed: the fixed point operations against libm (double and float) and against software floating
+// point. x86 has no single precision soft-float, __float128 from libquadmath stands in for it and is
+// an upper bound of what soft-float libm costs; the error column is measured against libm double.
+// codegen: executePipeline against the C generated for the same folded and strength reduced
+// pipeline, built with gcc -O2 into a separate program that times itself. Runs from tests/.
+// checked: executePipelineBatch against the checked batch in both modes, with every step checked and
+// with the steps range analysis proves fault free left unchecked.
+// incremental: one digit of a sum of terms edited back and forth with editIncrementalExpression against
+// compiling the edited text from scratch, for growing sums.
+
+#define BENCHMARK_INPUTS 4096
+#define BENCHMARK_ROUNDS 256
+#define BENCHMARK_SOFT_ROUNDS 8
+#define BENCHMARK_REPEATS 5
+
+static volatile ValueType sinkFixed;
+static volatile double sinkDouble;
+static volatile float sinkFloat;
+static volatile __float128 sinkQuad;
+
+static double now(void){
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static double toReal(ValueType value){
+	return (double)value / FIXED_ONE;
+}
+
+// FIXED POINT
+
+typedef enum {
+	FIXED_ISQRT,
+	FIXED_SQRT,
+	FIXED_EXP,
+	FIXED_LOG,
+	FIXED_SIN,
+	FIXED_COS
+} FixedFunction;
+
+typedef struct {
+	const char* name;
+	FixedFunction function;
+	// input range in Q16.16, the integer range for isqrt
+	ValueType low;
+	ValueType high;
+	// large results of exp are judged by their relative error
+	bool relative;
+} FixedCase;
+
+static const FixedCase fixedCases[] = {
+	{"isqrt", FIXED_ISQRT, 1, INT32_MAX, false},
+	{"sqrt", FIXED_SQRT, 1, INT32_MAX, false},
+	{"exp", FIXED_EXP, 0, 681000, true},
+	{"exp<0", FIXED_EXP, -12 * FIXED_ONE, 0, false},
+	{"log", FIXED_LOG, 1, INT32_MAX, false},
+	{"sin", FIXED_SIN, -32767 * FIXED_ONE, 32767 * FIXED_ONE, false},
+	{"cos", FIXED_COS, -32767 * FIXED_ONE, 32767 * FIXED_ONE, false}
+};
+
+static ValueType evaluateFixed(FixedFunction function, ValueType input){
+	ValueType sine, cosine;
+	switch (function)
+	{
+		case FIXED_ISQRT:
+			return fixedIntegerSqrt(input);
+		case FIXED_SQRT:
+			return fixedSqrt(input);
+		case FIXED_EXP:
+			return fixedExp(input);
+		case FIXED_LOG:
+			return fixedLog(input);
+		case FIXED_SIN:
+			fixedSinCos(input, &sine, &cosine);
+			return sine;
+		default:
+			fixedSinCos(input, &sine, &cosine);
+			return cosine;
+	}
+}
+
+static double evaluateDouble(FixedFunction function, double input){
+	switch (function)
+	{
+		case FIXED_ISQRT:
+		case FIXED_SQRT:
+			return sqrt(input);
+		case FIXED_EXP:
+			return exp(input);
+		case FIXED_LOG:
+			return log(input);
+		case FIXED_SIN:
+			return sin(input);
+		default:
+			return cos(input);
+	}
+}
+
+static float evaluateFloat(FixedFunction function, float input){
+	switch (function)
+	{
+		case FIXED_ISQRT:
+		case FIXED_SQRT:
+			return sqrtf(input);
+		case FIXED_EXP:
+			return expf(input);
+		case FIXED_LOG:
+			return logf(input);
+		case FIXED_SIN:
+			return sinf(input);
+		default:
+			return cosf(input);
+	}
+}
+
+static __float128 evaluateQuad(FixedFunction function, __float128 input){
+	switch (function)
+	{
+		case FIXED_ISQRT:
+		case FIXED_SQRT:
+			return sqrtq(input);
+		case FIXED_EXP:
+			return expq(input);
+		case FIXED_LOG:
+			return logq(input);
+		case FIXED_SIN:
+			return sinq(input);
+		default:
+			return cosq(input);
+	}
+}
+
+// largest deviation from the exact result, in units of the last place or relative
+static double measureFixedError(const FixedCase* fixedCase){
+	const uint32_t samples = 1u << 22;
+	double worst = 0;
+	double span = (double)fixedCase->high - (double)fixedCase->low;
+	for(uint32_t sample = 0; sample <= samples; sample++){
+		ValueType input = (ValueType)((double)fixedCase->low + span * sample / samples);
+		ValueType result = evaluateFixed(fixedCase->function, input);
+		double error;
+		if(fixedCase->function == FIXED_ISQRT){
+			error = fabs((double)result - floor(sqrt((double)input)));
+		}
+		else {
+			double exact = evaluateDouble(fixedCase->function, toReal(input));
+			error = fabs(toReal(result) - exact);
+			error = fixedCase->relative ? error / exact : error * FIXED_ONE;
+		}
+		if(error > worst){
+			worst = error;
+		}
+	}
+	return worst;
+}
+
+static void runFixedBenchmark(void){
+	printf("fixed point, ns per call\n");
+	printf("%-6s %14s %10s %10s %10s %12s\n", "op", "max error", "fixed", "double", "float", "soft quad");
+	for(size_t caseIdx = 0; caseIdx < ARRAY_CONST_SIZE(fixedCases); caseIdx++){
+		const FixedCase* fixedCase = &fixedCases[caseIdx];
+		ValueType inputs[BENCHMARK_INPUTS];
+		double span = (double)fixedCase->high - (double)fixedCase->low;
+		for(uint32_t inputIdx = 0; inputIdx < BENCHMARK_INPUTS; inputIdx++){
+			inputs[inputIdx] = (ValueType)((double)fixedCase->low + span * ((inputIdx * 2654435761u) % BENCHMARK_INPUTS) / BENCHMARK_INPUTS);
+		}
+		// isqrt works on plain integers, the others on Q16.16
+		double scale = fixedCase->function == FIXED_ISQRT ? 1.0 : 1.0 / FIXED_ONE;
+		double calls = (double)BENCHMARK_INPUTS * BENCHMARK_ROUNDS;
+
+		double start = now();
+		for(uint32_t round = 0; round < BENCHMARK_ROUNDS; round++){
+			for(uint32_t inputIdx = 0; inputIdx < BENCHMARK_INPUTS; inputIdx++){
+				sinkFixed = evaluateFixed(fixedCase->function, inputs[inputIdx]);
+			}
+		}
+		double fixedNs = (now() - start) * 1e9 / calls;
+
+		start = now();
+		for(uint32_t round = 0; round < BENCHMARK_ROUNDS; round++){
+			for(uint32_t inputIdx = 0; inputIdx < BENCHMARK_INPUTS; inputIdx++){
+				sinkDouble = evaluateDouble(fixedCase->function, inputs[inputIdx] * scale);
+			}
+		}
+		double doubleNs = (now() - start) * 1e9 / calls;
+
+		start = now();
+		for(uint32_t round = 0; round < BENCHMARK_ROUNDS; round++){
+			for(uint32_t inputIdx = 0; inputIdx < BENCHMARK_INPUTS; inputIdx++){
+				sinkFloat = evaluateFloat(fixedCase->function, (float)(inputs[inputIdx] * scale));
+			}
+		}
+		double floatNs = (now() - start) * 1e9 / calls;
+
+		start = now();
+		for(uint32_t round = 0; round < BENCHMARK_SOFT_ROUNDS; round++){
+			for(uint32_t inputIdx = 0; inputIdx < BENCHMARK_INPUTS; inputIdx++){
+				sinkQuad = evaluateQuad(fixedCase->function, (__float128)(inputs[inputIdx] * scale));
+			}
+		}
+		double quadNs = (now() - start) * 1e9 / ((double)BENCHMARK_INPUTS * BENCHMARK_SOFT_ROUNDS);
+
+		double error = measureFixedError(fixedCase);
+		char errorText[24];
+		if(fixedCase->relative){
+			snprintf(errorText, sizeof(errorText), "%.2e rel", error);
+		}
+		else {
+			snprintf(errorText, sizeof(errorText), "%.3f ulp", error);
+		}
+		printf("%-6s %14s %10.1f %10.1f %10.1f %12.1f\n", fixedCase->name, errorText, fixedNs, doubleNs, floatNs, quadNs);
+	}
+}
+
+// CODE GENERATION
+
+#define CODEGEN_SOURCE "benchmark_generated.c"
+#define CODEGEN_BINARY "./benchmark_generated"
+#define CODEGEN_COMPILE "gcc -O2 " CODEGEN_SOURCE " ../src/pipelinemath.c ../src/pipelinefixed.c -o " CODEGEN_BINARY
+
+static const char* codegenExpressions[] = {
+	"x*3 + y*5 - z",
+	"(x*x + y*y) / 16 + z % 7",
+	"((x+1)*(y+2)*(z+3) - x*y*z) % 1000",
+	"(x > 0 && y > 0) || z == 3",
+	"x < y ? lerp(x, y, z) : sqrt(x*x + y*y)"
+};
+
+static void writeGeneratedLine(void* context, const char* line){
+	fprintf((FILE*)context, "%s\n", line);
+}
+
+static bool compileBenchmarkPipeline(Pipeline* pipeline, const char* expression, PipelineVariablesSlice variables){
+	PeekableStringSlice input = {.slice = makeSliceFromString(expression), .cursor = 0, .context = NULL};
+	if(compileExpression(pipeline, &input, variables).type != NOERROR){
+		return false;
+	}
+	foldConstantsPipeline(pipeline);
+	strengthReducePipeline(pipeline);
+	return true;
+}
+
+static void runCodegenBenchmark(void){
+	static PipelineVariable inputs[BENCHMARK_INPUTS][3];
+	for(uint32_t inputIdx = 0; inputIdx < BENCHMARK_INPUTS; inputIdx++){
+		for(uint8_t variableIdx = 0; variableIdx < 3; variableIdx++){
+			ValueType value = (ValueType)((inputIdx * 2654435761u + variableIdx * 40503u) % 2001) - 1000;
+			inputs[inputIdx][variableIdx] = (PipelineVariable){.name = "xyz"[variableIdx], .value = value};
+		}
+	}
+
+	FILE* source = fopen(CODEGEN_SOURCE, "w");
+	if(source == NULL){
+		printf("cannot write %s\n", CODEGEN_SOURCE);
+		return;
+	}
+	fprintf(source, "#include \"../include/execpipeline.h\"\n#include <stdio.h>\n#include <time.h>\n\n");
+	double interpretedNs[ARRAY_CONST_SIZE(codegenExpressions)];
+	PipelineStack stack;
+	for(size_t expressionIdx = 0; expressionIdx < ARRAY_CONST_SIZE(codegenExpressions); expressionIdx++){
+		PipelineVariant storage[64];
+		Pipeline pipeline = CREATE_PIPELINE_FROM_CONST_STORAGE(storage);
+		char functionName[32];
+		snprintf(functionName, sizeof(functionName), "generated%zu", expressionIdx);
+		if(!compileBenchmarkPipeline(&pipeline, codegenExpressions[expressionIdx], (PipelineVariablesSlice){inputs[0], 3})
+			|| !generatePipelineFunction(&pipeline, functionName, writeGeneratedLine, source)){
+			printf("cannot generate %s\n", codegenExpressions[expressionIdx]);
+			fclose(source);
+			return;
+		}
+		fprintf(source, "\n");
+
+		double start = now();
+		for(uint32_t round = 0; round < BENCHMARK_ROUNDS; round++){
+			for(uint32_t inputIdx = 0; inputIdx < BENCHMARK_INPUTS; inputIdx++){
+				sinkFixed = executePipeline(&pipeline, &stack, (PipelineVariablesSlice){inputs[inputIdx], 3});
+			}
+		}
+		interpretedNs[expressionIdx] = (now() - start) * 1e9 / ((double)BENCHMARK_INPUTS * BENCHMARK_ROUNDS);
+	}
+
+	// the generated program times the same inputs with the same loop and prints ns per call
+	fprintf(source, "static const PipelineVariable inputs[%d][3] = {\n", BENCHMARK_INPUTS);
+	for(uint32_t inputIdx = 0; inputIdx < BENCHMARK_INPUTS; inputIdx++){
+		fprintf(source, "\t{{'x', %d}, {'y', %d}, {'z', %d}},\n", inputs[inputIdx][0].value, inputs[inputIdx][1].value, inputs[inputIdx][2].value);
+	}
+	fprintf(source, "};\n\nstatic volatile ValueType sink;\n\n"
+		"static double now(void){\n"
+		"\tstruct timespec ts;\n"
+		"\tclock_gettime(CLOCK_MONOTONIC, &ts);\n"
+		"\treturn (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;\n"
+		"}\n\n"
+		"int main(void){\n");
+	for(size_t expressionIdx = 0; expressionIdx < ARRAY_CONST_SIZE(codegenExpressions); expressionIdx++){
+		fprintf(source, "\t{\n"
+			"\t\tdouble start = now();\n"
+			"\t\tfor(unsigned round = 0; round < %d; round++){\n"
+			"\t\t\tfor(unsigned inputIdx = 0; inputIdx < %d; inputIdx++){\n"
+			"\t\t\t\tsink = generated%zu(inputs[inputIdx]);\n"
+			"\t\t\t}\n"
+			"\t\t}\n"
+			"\t\tprintf(\"%%f\\n\", (now() - start) * 1e9 / (%d.0 * %d));\n"
+			"\t}\n", BENCHMARK_ROUNDS, BENCHMARK_INPUTS, expressionIdx, BENCHMARK_INPUTS, BENCHMARK_ROUNDS);
+	}
+	fprintf(source, "\treturn 0;\n}\n");
+	fclose(source);
+
+	if(system(CODEGEN_COMPILE) != 0){
+		printf("generated source does not compile, kept in %s\n", CODEGEN_SOURCE);
+		return;
+	}
+	FILE* timings = popen(CODEGEN_BINARY, "r");
+	printf("generated C against the interpreter, ns per evaluation\n");
+	printf("%-40s %12s %10s %8s\n", "expression", "interpreted", "generated", "speedup");
+	for(size_t expressionIdx = 0; expressionIdx < ARRAY_CONST_SIZE(codegenExpressions); expressionIdx++){
+		double generatedNs = 0;
+		if(timings == NULL || fscanf(timings, "%lf", &generatedNs) != 1){
+			printf("no timing from %s\n", CODEGEN_BINARY);
+			break;
+		}
+		printf("%-40s %12.2f %10.2f %7.1fx\n", codegenExpressions[expressionIdx], interpretedNs[expressionIdx], generatedNs, interpretedNs[expressionIdx] / generatedNs);
+	}
+	if(timings != NULL){
+		pclose(timings);
+	}
+	remove(CODEGEN_SOURCE);
+	remove(CODEGEN_BINARY);
+}
+
+// CHECKED EXECUTION
+
+static const char* checkedExpressions[] = {
+	"x*3 + y*5 - z",
+	"(x*x + y*y) / 16 + z % 7",
+	"((x+1)*(y+2)*(z+3) - x*y*z) % 1000",
+	"x / (y*y + 1) + z % (x*x + 3)",
+	// too large for MOD_MAGIC, the constant divisor stays a native MOD
+	"x*y % 40009 - z",
+	"x < y ? x*y - z : (x + y) * (y - z)"
+};
+
+typedef enum {
+	CHECKED_OFF,
+	CHECKED_WRAPPING,
+	CHECKED_SATURATING,
+	CHECKED_WRAPPING_PROVEN
+} CheckedVariant;
+
+static double timeCheckedBatch(const Pipeline* pipeline, const CheckedPipeline* checked, CheckedVariant variant, const ValueType* const columns[], ValueType results[]){
+	PipelineVariable variables[] = {{'x', 0}, {'y', 0}, {'z', 0}};
+	PipelineStack stack;
+	uint8_t errors = ARITHMETIC_NO_ERROR;
+	// the differences are small, the best of a few repeats filters out the noise of other processes
+	double best = 0;
+	for(uint8_t repeat = 0; repeat < BENCHMARK_REPEATS; repeat++){
+		double start = now();
+		for(uint32_t round = 0; round < BENCHMARK_ROUNDS; round++){
+			if(variant == CHECKED_OFF){
+				executePipelineBatch(pipeline, &stack, variables, 3, columns, BENCHMARK_INPUTS, results);
+			}
+			else {
+				executeCheckedPipelineBatch(checked, &stack, variables, 3, columns, BENCHMARK_INPUTS, results, &errors);
+			}
+			sinkFixed = results[round % BENCHMARK_INPUTS] + errors;
+		}
+		double elapsed = now() - start;
+		if(repeat == 0 || elapsed < best){
+			best = elapsed;
+		}
+	}
+	return best * 1e9 / ((double)BENCHMARK_INPUTS * BENCHMARK_ROUNDS);
+}
+
+static void runCheckedBenchmark(void){
+	// inputs stay within the analyzed [-1000, 1000], no row faults and every variant does the same work
+	static ValueType columnStorage[3][BENCHMARK_INPUTS];
+	for(uint32_t inputIdx = 0; inputIdx < BENCHMARK_INPUTS; inputIdx++){
+		for(uint8_t variableIdx = 0; variableIdx < 3; variableIdx++){
+			columnStorage[variableIdx][inputIdx] = (ValueType)((inputIdx * 2654435761u + variableIdx * 40503u) % 2001) - 1000;
+		}
+	}
+	const ValueType* const columns[] = {columnStorage[0], columnStorage[1], columnStorage[2]};
+	static ValueType results[BENCHMARK_INPUTS];
+	ValueRange variableRanges[3] = {{-1000, 1000}, {-1000, 1000}, {-1000, 1000}};
+
+	printf("checked batch execution, ns per row (overhead against unchecked)\n");
+	printf("%-38s %10s %16s %16s %16s\n", "expression", "unchecked", "wrapping", "saturating", "proven");
+	for(size_t expressionIdx = 0; expressionIdx < ARRAY_CONST_SIZE(checkedExpressions); expressionIdx++){
+		PipelineVariant storage[64];
+		Pipeline pipeline = CREATE_PIPELINE_FROM_CONST_STORAGE(storage);
+		PipelineVariable variables[] = {{'x', 0}, {'y', 0}, {'z', 0}};
+		StepRange steps[ARRAY_CONST_SIZE(storage)];
+		if(!compileBenchmarkPipeline(&pipeline, checkedExpressions[expressionIdx], MAKE_SLICE_FROM_CONST_PIPELINE_VARIABLES(variables))
+			|| !analyzePipelineRanges(&pipeline, variableRanges, 3, steps)){
+			printf("cannot compile %s\n", checkedExpressions[expressionIdx]);
+			return;
+		}
+		CheckedPipeline wrapping, saturating, proven;
+		prepareCheckedPipeline(&wrapping, &pipeline, ARITHMETIC_WRAPPING, NULL);
+		prepareCheckedPipeline(&saturating, &pipeline, ARITHMETIC_SATURATING, NULL);
+		prepareCheckedPipeline(&proven, &pipeline, ARITHMETIC_WRAPPING, steps);
+
+		double uncheckedNs = timeCheckedBatch(&pipeline, NULL, CHECKED_OFF, columns, results);
+		double wrappingNs = timeCheckedBatch(&pipeline, &wrapping, CHECKED_WRAPPING, columns, results);
+		double saturatingNs = timeCheckedBatch(&pipeline, &saturating, CHECKED_SATURATING, columns, results);
+		double provenNs = timeCheckedBatch(&pipeline, &proven, CHECKED_WRAPPING_PROVEN, columns, results);
+		printf("%-38s %10.2f %8.2f (%+4.0f%%) %8.2f (%+4.0f%%) %8.2f (%+4.0f%%)\n", checkedExpressions[expressionIdx], uncheckedNs,
+			wrappingNs, (wrappingNs / uncheckedNs - 1) * 100, saturatingNs, (saturatingNs / uncheckedNs - 1) * 100, provenNs, (provenNs / uncheckedNs - 1) * 100);
+	}
+}
+
+// INCREMENTAL RECOMPILATION
+
+#define INCREMENTAL_EDITS 20000
+
+static void runIncrementalBenchmark(void){
+	printf("recompiling after a one character edit in the middle term, ns per edit\n");
+	printf("%-6s %8s %8s %14s %14s %8s\n", "terms", "chars", "steps", "full compile", "incremental", "speedup");
+	static const uint8_t termCounts[] = {4, 8, 16, 30};
+	for(size_t countIdx = 0; countIdx < ARRAY_CONST_SIZE(termCounts); countIdx++){
+		char source[1024];
+		size_t length = 0;
+		uint16_t digitOffset = 0;
+		for(uint8_t termIdx = 0; termIdx < termCounts[countIdx]; termIdx++){
+			size_t termBegin = length;
+			length += (size_t)snprintf(&source[length], sizeof(source) - length, termIdx == 0 ? "(x*3 + y) %% 7" : " + (x*3 + y) %% 7");
+			if(termIdx == termCounts[countIdx] / 2){
+				digitOffset = (uint16_t)(strchr(&source[termBegin], '3') - source);
+			}
+		}
+
+		PipelineVariable variables[] = {{'x', 0}, {'y', 0}, {'z', 0}};
+		PipelineVariablesSlice variablesSlice = MAKE_SLICE_FROM_CONST_PIPELINE_VARIABLES(variables);
+		PipelineVariant storage[NONE_INDEX];
+		Pipeline pipeline = CREATE_PIPELINE_FROM_CONST_STORAGE(storage);
+		PipelineSpan spanStorage[512];
+		char text[sizeof(source)];
+		IncrementalExpression expression;
+		initIncrementalExpression(&expression, text, sizeof(text), &pipeline, variablesSlice, spanStorage, ARRAY_CONST_SIZE(spanStorage));
+		if(compileIncrementalExpression(&expression, (StringSlice){source, length}).type != NOERROR){
+			printf("cannot compile %s\n", source);
+			return;
+		}
+
+		double bestFull = 0, bestIncremental = 0;
+		for(uint8_t repeat = 0; repeat < BENCHMARK_REPEATS; repeat++){
+			double start = now();
+			for(uint32_t edit = 0; edit < INCREMENTAL_EDITS; edit++){
+				source[digitOffset] = edit % 2 == 0 ? '4' : '3';
+				PipelineVariant fullStorage[NONE_INDEX];
+				Pipeline full = CREATE_PIPELINE_FROM_CONST_STORAGE(fullStorage);
+				PeekableStringSlice input = {.slice = {source, length}, .cursor = 0, .context = NULL};
+				sinkFixed = compileExpression(&full, &input, variablesSlice).type + full.index;
+			}
+			double fullElapsed = now() - start;
+
+			start = now();
+			for(uint32_t edit = 0; edit < INCREMENTAL_EDITS; edit++){
+				StringSlice digit = edit % 2 == 0 ? MAKE_SLICE_FROM_CONST_STRING("4") : MAKE_SLICE_FROM_CONST_STRING("3");
+				sinkFixed = editIncrementalExpression(&expression, digitOffset, 1, digit).type + pipeline.index;
+			}
+			double incrementalElapsed = now() - start;
+			if(repeat == 0 || fullElapsed < bestFull){
+				bestFull = fullElapsed;
+			}
+			if(repeat == 0 || incrementalElapsed < bestIncremental){
+				bestIncremental = incrementalElapsed;
+			}
+		}
+		double fullNs = bestFull * 1e9 / INCREMENTAL_EDITS;
+		double incrementalNs = bestIncremental * 1e9 / INCREMENTAL_EDITS;
+		printf("%-6u %8zu %8u %14.0f %14.0f %7.1fx\n", termCounts[countIdx], length, lengthOfPipeline(&pipeline), fullNs, incrementalNs, fullNs / incrementalNs);
+	}
+}
+
+// SECTIONS
+
+typedef struct {
+	const char* name;
+	void (*run)(void);
+} BenchmarkSection;
+
+static const BenchmarkSection sections[] = {
+	{"fixed", runFixedBenchmark},
+	{"codegen", runCodegenBenchmark},
+	{"checked", runCheckedBenchmark},
+	{"incremental", runIncrementalBenchmark}
+};
+
+int main(int argc, char** argv){
+	bool ran = false;
+	for(size_t sectionIdx = 0; sectionIdx < ARRAY_CONST_SIZE(sections); sectionIdx++){
+		if(argc > 1 && strcmp(argv[1], sections[sectionIdx].name) != 0){
+			continue;
+		}
+		sections[sectionIdx].run();
+		ran = true;
+	}
+	if(!ran){
+		printf("unknown section %s\n", argv[1]);
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,157 @@
+#include "../include/pipelinehandle.h"
+#include "../include/expressionparser.h"
+#include "../include/pipelineoptimizer.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// Readers evaluate through a PipelineHandle while writers keep compiling and publishing new versions
+// into a small version pool, so retired versions are reused as soon as reclamation allows.
+// A version evaluates x*K + K with K noted per slot before publishing, any torn or reclaimed-while-read
+// pipeline shows up as a wrong result or as a version going backwards.
+//   stresshandle [readers] [seconds] [writers]
+
+#define STRESS_VERSIONS 3
+#define STRESS_X 3
+#define STRESS_MAX_WRITERS 4
+
+static PipelineHandle handle;
+static PipelineVersion versions[STRESS_VERSIONS];
+static PipelineVariant storage[STRESS_VERSIONS][32];
+// K of the pipeline in each slot, written before the slot is published
+static ValueType scales[STRESS_VERSIONS];
+static _Atomic bool stopped;
+static double seconds;
+
+typedef struct {
+	uint8_t readerId;
+	uint64_t evaluations;
+	uint64_t failures;
+} StressReader;
+
+typedef struct {
+	uint8_t writerId;
+	uint8_t writerCount;
+	uint32_t published;
+	uint64_t stalls;
+	bool compileFailed;
+} StressWriter;
+
+static void* runReader(void* arg){
+	StressReader* reader = arg;
+	PipelineVariable vars[] = {{'x', STRESS_X}};
+	PipelineStack stack;
+	uint32_t lastVersion = 0;
+	while(!atomic_load(&stopped)){
+		const PipelineVersion* version = enterPipelineHandle(&handle, reader->readerId);
+		if(version == NULL){
+			leavePipelineHandle(&handle, reader->readerId);
+			continue;
+		}
+		ValueType result = executePipeline(&version->pipeline, &stack, MAKE_SLICE_FROM_CONST_PIPELINE_VARIABLES(vars));
+		uint32_t seen = version->version;
+		ValueType scale = scales[version - versions];
+		leavePipelineHandle(&handle, reader->readerId);
+
+		if(result != scale * (STRESS_X + 1) || seen < lastVersion){
+			if(reader->failures++ < 5){
+				printf("reader %u: version %u (last %u) evaluated to %d, expected %d\n", reader->readerId, seen, lastVersion, result, scale * (STRESS_X + 1));
+			}
+		}
+		lastVersion = seen;
+		reader->evaluations++;
+	}
+	return NULL;
+}
+
+// writers number their pipelines apart so every K is published once
+static void* runWriter(void* arg){
+	StressWriter* writer = arg;
+	PipelineVariable vars[] = {{'x', 0}};
+	struct timespec begin, now;
+	clock_gettime(CLOCK_MONOTONIC, &begin);
+	do {
+		PipelineVersion* version = acquirePipelineVersion(&handle);
+		if(version == NULL){
+			writer->stalls++;
+			sched_yield();
+		}
+		else {
+			// scribble over the reused storage first so a reader still inside it cannot go unnoticed
+			for(uint8_t stepIdx = 0; stepIdx < version->pipeline.capacity; stepIdx++){
+				version->pipeline.entries[stepIdx] = makeStepAsConstant(-1);
+			}
+			ValueType scale = (ValueType)(writer->published * writer->writerCount + writer->writerId + 1);
+			char expression[48];
+			snprintf(expression, sizeof(expression), "x*%d + %d", scale, scale);
+			PeekableStringSlice input = {.slice = makeSliceFromString(expression), .cursor = 0, .context = NULL};
+			if(compileExpression(&version->pipeline, &input, MAKE_SLICE_FROM_CONST_PIPELINE_VARIABLES(vars)).type != NOERROR){
+				abandonPipelineVersion(&handle, version);
+				writer->compileFailed = true;
+				break;
+			}
+			foldConstantsPipeline(&version->pipeline);
+			scales[version - versions] = scale;
+			publishPipelineVersion(&handle, version);
+			writer->published++;
+		}
+		clock_gettime(CLOCK_MONOTONIC, &now);
+	} while((double)(now.tv_sec - begin.tv_sec) + (double)(now.tv_nsec - begin.tv_nsec) / 1e9 < seconds);
+	return NULL;
+}
+
+int main(int argc, char** argv){
+	int readerCount = argc > 1 ? atoi(argv[1]) : 4;
+	seconds = argc > 2 ? atof(argv[2]) : 2.0;
+	int writerCount = argc > 3 ? atoi(argv[3]) : 1;
+	if(readerCount <= 0 || readerCount > PIPELINE_HANDLE_MAX_READERS){
+		readerCount = 4;
+	}
+	if(writerCount <= 0 || writerCount > STRESS_MAX_WRITERS){
+		writerCount = 1;
+	}
+
+	for(uint8_t versionIdx = 0; versionIdx < STRESS_VERSIONS; versionIdx++){
+		initPipelineVersion(&versions[versionIdx], storage[versionIdx], ARRAY_CONST_SIZE(storage[versionIdx]));
+	}
+	initPipelineHandle(&handle, versions, STRESS_VERSIONS);
+
+	StressReader readers[PIPELINE_HANDLE_MAX_READERS];
+	pthread_t threads[PIPELINE_HANDLE_MAX_READERS];
+	for(int readerIdx = 0; readerIdx < readerCount; readerIdx++){
+		readers[readerIdx] = (StressReader){.readerId = (uint8_t)readerIdx, .evaluations = 0, .failures = 0};
+		pthread_create(&threads[readerIdx], NULL, runReader, &readers[readerIdx]);
+	}
+
+	StressWriter writers[STRESS_MAX_WRITERS];
+	pthread_t writerThreads[STRESS_MAX_WRITERS];
+	for(int writerIdx = 0; writerIdx < writerCount; writerIdx++){
+		writers[writerIdx] = (StressWriter){.writerId = (uint8_t)writerIdx, .writerCount = (uint8_t)writerCount, .published = 0, .stalls = 0, .compileFailed = false};
+		pthread_create(&writerThreads[writerIdx], NULL, runWriter, &writers[writerIdx]);
+	}
+	uint32_t published = 0;
+	uint64_t stalls = 0;
+	bool compileFailed = false;
+	for(int writerIdx = 0; writerIdx < writerCount; writerIdx++){
+		pthread_join(writerThreads[writerIdx], NULL);
+		published += writers[writerIdx].published;
+		stalls += writers[writerIdx].stalls;
+		compileFailed = compileFailed || writers[writerIdx].compileFailed;
+	}
+
+	atomic_store(&stopped, true);
+	uint64_t evaluations = 0;
+	uint64_t failures = 0;
+	for(int readerIdx = 0; readerIdx < readerCount; readerIdx++){
+		pthread_join(threads[readerIdx], NULL);
+		evaluations += readers[readerIdx].evaluations;
+		failures += readers[readerIdx].failures;
+	}
+
+	printf("readers %d writers %d: %" PRIu64 " evaluations, %u versions published, %" PRIu64 " writer stalls, %" PRIu64 " failures\n",
+		readerCount, writerCount, evaluations, published, stalls, failures);
+	return failures != 0 || compileFailed ? 1 : 0;
+}
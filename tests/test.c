@@ -79,7 +79,19 @@ void printParsingError(ParsingError err){
 		case PIPELINE_FULL:
 			printf("Pipeline full, last visited: '%c' at column %d\n",err.unexpected, err.at);
 			break;
-		case NO_ERROR:
+		case HISTORY_FULL:
+			printf("Stream history full, last visited: '%c' at column %d\n",err.unexpected, err.at);
+			break;
+		case BUDGET_EXCEEDED:
+			printf("Cost budget exceeded\n");
+			break;
+		case DEFINITIONS_FULL:
+			printf("Definitions full, last visited: '%c' at column %d\n",err.unexpected, err.at);
+			break;
+		case TEXT_FULL:
+			printf("Expression text full\n");
+			break;
+		case NOERROR:
 			printf("No error\n");
 			break;
 	}
@@ -88,8 +100,8 @@ void printParsingError(ParsingError err){
 
 int main(){
 
-	Pipeline pipeline;
-	initPipeline(&pipeline);
+	PipelineVariant storage[32];
+	Pipeline pipeline = CREATE_PIPELINE_FROM_CONST_STORAGE(storage);
 	
 
 	//const char inputFormula[] = "1+-2*(-pow2(3*2))";
@@ -113,15 +125,15 @@ int main(){
 		&peekableSlice,
 		MAKE_SLICE_FROM_CONST_PIPELINE_VARIABLES(vars)
 	);
-	if(err.type != NO_ERROR){
+	if(err.type != NOERROR){
 		printParsingError(err);
 	}
 	
 	printPipeline(&pipeline);
 	printStack(&stack);
 
-	ValueType result = executePipeline(&pipeline, &stack, MAKE_SLICE_FROM_CONST_PIPELINE_VARIABLES(vars), true);
+	ValueType result = executePipeline(&pipeline, &stack, MAKE_SLICE_FROM_CONST_PIPELINE_VARIABLES(vars));
 	printf("Result %d\n", result);
 	
-	return 0;
+	return result != 30 * (15 + 20);
 }
\ No newline at end of file
@@ -0,0 +1,185 @@
+#include "../include/pipelinebatch.h"
+#include "../include/expressionparser.h"
+
+#include <stdio.h>
+
+// Checks batch and hoisted batch evaluation against executePipeline row by row, u is uniform and x
+// varies, and sweeps and grids against executePipeline point by point.
+//   testbatch
+
+#define BATCH_ROWS 5
+#define SWEEP_POINTS 40
+
+static int failures;
+
+static bool compileText(Pipeline* pipeline, const char* text, PipelineVariablesSlice variables){
+	PeekableStringSlice input = {.slice = makeSliceFromString(text), .cursor = 0};
+	if(compileExpression(pipeline, &input, variables).type != NOERROR || pipeline->errorMask != NO_ERROR){
+		printf("%s: does not compile\n", text);
+		failures++;
+		return false;
+	}
+	return true;
+}
+
+// BATCH
+
+static void checkBatch(const char* text){
+	PipelineVariable variables[] = {{'u', 6}, {'x', 0}};
+	PipelineVariablesSlice slice = MAKE_SLICE_FROM_CONST_PIPELINE_VARIABLES(variables);
+	PipelineVariant storage[64];
+	Pipeline pipeline = CREATE_PIPELINE_FROM_CONST_STORAGE(storage);
+	if(!compileText(&pipeline, text, slice)){
+		return;
+	}
+
+	static const ValueType column[BATCH_ROWS] = {5, -3, 0, 17, 100};
+	const ValueType* columns[] = {NULL, column};
+	PipelineStack stack;
+	initStack(&stack);
+	ValueType results[BATCH_ROWS];
+	executePipelineBatch(&pipeline, &stack, variables, slice.len, columns, BATCH_ROWS, results);
+
+	for(uint8_t row = 0; row < BATCH_ROWS; row++){
+		variables[1].value = column[row];
+		ValueType expected = executePipeline(&pipeline, &stack, slice);
+		if(results[row] != expected){
+			printf("%s with x=%d: batch %d, executePipeline %d\n", text, column[row], results[row], expected);
+			failures++;
+			return;
+		}
+	}
+}
+
+// HOISTING
+
+static void checkHoisted(const char* text, ValueType uniformValue){
+	PipelineVariable variables[] = {{'u', uniformValue}, {'x', 0}};
+	PipelineVariablesSlice slice = MAKE_SLICE_FROM_CONST_PIPELINE_VARIABLES(variables);
+	PipelineVariant storage[64];
+	Pipeline pipeline = CREATE_PIPELINE_FROM_CONST_STORAGE(storage);
+	if(!compileText(&pipeline, text, slice)){
+		return;
+	}
+
+	static const ValueType column[BATCH_ROWS] = {5, -3, 0, 17, 100};
+	const ValueType* columns[] = {NULL, column};
+	const bool uniform[] = {true, false};
+	PipelineVariant perRowStorage[64];
+	HoistedPipeline hoisted;
+	hoistUniformPipeline(&hoisted, &pipeline, perRowStorage, ARRAY_CONST_SIZE(perRowStorage), uniform);
+	PipelineStack stack;
+	initStack(&stack);
+	ValueType results[BATCH_ROWS];
+	executeHoistedPipelineBatch(&hoisted, &stack, variables, slice.len, columns, BATCH_ROWS, results);
+
+	for(uint8_t row = 0; row < BATCH_ROWS; row++){
+		variables[1].value = column[row];
+		ValueType expected = executePipeline(&pipeline, &stack, slice);
+		if(results[row] != expected){
+			printf("%s with u=%d x=%d: hoisted %d, executePipeline %d\n", text, uniformValue, column[row], results[row], expected);
+			failures++;
+			return;
+		}
+	}
+}
+
+// SWEEP
+
+static void checkSweep(const char* text, uint8_t degree, ValueType start, ValueType step){
+	PipelineVariable variables[] = {{'u', 3}, {'x', 0}};
+	PipelineVariablesSlice slice = MAKE_SLICE_FROM_CONST_PIPELINE_VARIABLES(variables);
+	PipelineVariant storage[64];
+	Pipeline pipeline = CREATE_PIPELINE_FROM_CONST_STORAGE(storage);
+	if(!compileText(&pipeline, text, slice)){
+		return;
+	}
+	if(getPipelinePolynomialDegree(&pipeline, 1) != degree){
+		printf("%s: degree %u in x, expected %u\n", text, getPipelinePolynomialDegree(&pipeline, 1), degree);
+		failures++;
+		return;
+	}
+
+	PipelineStack stack;
+	initStack(&stack);
+	ValueType results[SWEEP_POINTS];
+	PipelineSweep sweep = {.variable = 1, .start = start, .step = step, .count = SWEEP_POINTS};
+	executePipelineSweep(&pipeline, &stack, variables, slice.len, sweep, results);
+	for(uint8_t point = 0; point < SWEEP_POINTS; point++){
+		variables[1].value = (ValueType)((uint32_t)start + (uint32_t)step * point);
+		ValueType expected = executePipeline(&pipeline, &stack, slice);
+		if(results[point] != expected){
+			printf("%s at x=%d: swept %d, executePipeline %d\n", text, variables[1].value, results[point], expected);
+			failures++;
+			return;
+		}
+	}
+}
+
+static void checkGrid(const char* text){
+	PipelineVariable variables[] = {{'u', 0}, {'x', 0}};
+	PipelineVariablesSlice slice = MAKE_SLICE_FROM_CONST_PIPELINE_VARIABLES(variables);
+	PipelineVariant storage[64];
+	Pipeline pipeline = CREATE_PIPELINE_FROM_CONST_STORAGE(storage);
+	if(!compileText(&pipeline, text, slice)){
+		return;
+	}
+
+	PipelineStack stack;
+	initStack(&stack);
+	PipelineSweep outer = {.variable = 0, .start = -3, .step = 2, .count = 5};
+	PipelineSweep inner = {.variable = 1, .start = 10, .step = -3, .count = 9};
+	ValueType results[5 * 9];
+	executePipelineGrid(&pipeline, &stack, variables, slice.len, outer, inner, results);
+	for(uint8_t outerIdx = 0; outerIdx < outer.count; outerIdx++){
+		for(uint8_t innerIdx = 0; innerIdx < inner.count; innerIdx++){
+			variables[0].value = outer.start + outer.step * outerIdx;
+			variables[1].value = inner.start + inner.step * innerIdx;
+			ValueType expected = executePipeline(&pipeline, &stack, slice);
+			if(results[outerIdx * inner.count + innerIdx] != expected){
+				printf("%s at u=%d x=%d: grid %d, executePipeline %d\n", text, variables[0].value, variables[1].value, results[outerIdx * inner.count + innerIdx], expected);
+				failures++;
+				return;
+			}
+		}
+	}
+}
+
+int main(void){
+	checkBatch("u * x - x / 3");
+	checkBatch("mod(x, u) * 2 + div(u, 3)");
+	checkBatch("x > u ? x % u : x * u + 1");
+	checkBatch("x && u || x - 17");
+
+	checkHoisted("u * u + x * (u - 2)", 3);
+	checkHoisted("x / (u + 2) + (u * 4 + 1) / 3", 5);
+	// divisions by a zero uniform behind a guard must stay in their branch
+	checkHoisted("u != 0 ? 100 / u : x", 0);
+	checkHoisted("u && 100 / u > x", 0);
+	checkHoisted("u == 0 || x % u > 2", 0);
+	checkHoisted("u == 0 ? x : (x + 1000 % (u * 3)) / u", 0);
+	checkHoisted("u != 0 ? div(100, u) : x", 0);
+	checkHoisted("u != -1 ? x + (-2147483647 - 1) / u : 7", -1);
+	// and still get hoisted where they are taken
+	checkHoisted("u != 0 ? 100 / u : x", 4);
+	checkHoisted("u && 100 / u > x", 7);
+	// uniform parts that cannot trap are hoisted out of branches as before
+	checkHoisted("x > 3 ? u * u + 1 : x / (u + 2)", 5);
+	checkHoisted("x && (u * 4 + 1) / 3 < x", 2);
+
+	// forward differencing for polynomials in x, batch evaluation for the rest
+	checkSweep("u * 7 - 2", 0, -5, 1);
+	checkSweep("x * u + 4", 1, -20, 3);
+	checkSweep("x * x * x - u * x * x + 5 * x - 9", 3, -17, 1);
+	checkSweep("(x + u) * (x - 1) * (x * x + 2) * 8", 4, 100, -7);
+	// wraps around in 32 bits on the way
+	checkSweep("x * x * x * 1000 + x", 3, 1000, 997);
+	checkSweep("x / 3 + x * x", PIPELINE_NOT_POLYNOMIAL, -20, 1);
+	checkSweep("x > u ? x * 2 : u", PIPELINE_NOT_POLYNOMIAL, -20, 1);
+	checkSweep("mod(x, 7) + x", PIPELINE_NOT_POLYNOMIAL, 0, 5);
+	checkGrid("u * u * x - x * x + u");
+	checkGrid("x > u ? x % (u * u + 1) : u - x");
+
+	printf("testbatch: %s\n", failures == 0 ? "match" : "MISMATCH");
+	return failures != 0;
+}
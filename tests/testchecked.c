@@ -0,0 +1,233 @@
+#include "../include/pipelinechecked.h"
+#include "../include/pipelineoptimizer.h"
+#include "../include/expressionparser.h"
+
+#include <stdio.h>
+
+// Checks the checked executor against 64 bit C arithmetic at the int32_t edges in both modes, the
+// sticky error mask of single and batch evaluation, and steps running unchecked where they are proven.
+//   testchecked
+
+static int failures;
+
+static const ValueType edgeValues[] = {INT32_MIN, INT32_MIN + 1, -65536, -7, -1, 0, 1, 7, 46341, INT32_MAX - 1, INT32_MAX};
+
+static PipelineVariable variables[] = {{'x', 0}, {'y', 0}};
+
+static bool compileText(Pipeline* pipeline, const char* text){
+	PeekableStringSlice input = {.slice = makeSliceFromString(text), .cursor = 0, .context = NULL};
+	if(compileExpression(pipeline, &input, MAKE_SLICE_FROM_CONST_PIPELINE_VARIABLES(variables)).type != NOERROR || pipeline->errorMask != NO_ERROR){
+		printf("%s: does not compile\n", text);
+		failures++;
+		return false;
+	}
+	return true;
+}
+
+// REFERENCE
+
+static ValueType referenceResult(char operator, ValueType left, ValueType right, ArithmeticMode mode, uint8_t* errors){
+	int64_t wide;
+	switch (operator)
+	{
+		case '+':
+			wide = (int64_t)left + right;
+			break;
+		case '-':
+			wide = (int64_t)left - right;
+			break;
+		case '*':
+			wide = (int64_t)left * right;
+			break;
+		case '/':
+			if(right == 0){
+				*errors |= ARITHMETIC_DIVISION_BY_ZERO;
+				return mode == ARITHMETIC_WRAPPING || left == 0 ? 0 : left > 0 ? INT32_MAX : INT32_MIN;
+			}
+			wide = (int64_t)left / right;
+			break;
+		default:
+			if(right == 0){
+				*errors |= ARITHMETIC_DIVISION_BY_ZERO;
+				return 0;
+			}
+			return (ValueType)((int64_t)left % right);
+	}
+	if(wide >= INT32_MIN && wide <= INT32_MAX){
+		return (ValueType)wide;
+	}
+	*errors |= ARITHMETIC_OVERFLOW;
+	if(mode == ARITHMETIC_WRAPPING){
+		return (ValueType)(uint32_t)wide;
+	}
+	return wide > 0 ? INT32_MAX : INT32_MIN;
+}
+
+static void checkOperator(const char* text, char operator, ArithmeticMode mode){
+	PipelineVariant storage[8];
+	Pipeline pipeline = CREATE_PIPELINE_FROM_CONST_STORAGE(storage);
+	if(!compileText(&pipeline, text)){
+		return;
+	}
+	CheckedPipeline checked;
+	prepareCheckedPipeline(&checked, &pipeline, mode, NULL);
+	PipelineStack stack;
+	initStack(&stack);
+	PipelineVariablesSlice slice = MAKE_SLICE_FROM_CONST_PIPELINE_VARIABLES(variables);
+	for(uint8_t xIdx = 0; xIdx < ARRAY_CONST_SIZE(edgeValues); xIdx++){
+		for(uint8_t yIdx = 0; yIdx < ARRAY_CONST_SIZE(edgeValues); yIdx++){
+			variables[0].value = edgeValues[xIdx];
+			variables[1].value = edgeValues[yIdx];
+			uint8_t errors = ARITHMETIC_NO_ERROR;
+			uint8_t expectedErrors = ARITHMETIC_NO_ERROR;
+			ValueType result = executeCheckedPipeline(&checked, &stack, slice, &errors);
+			ValueType expected = referenceResult(operator, edgeValues[xIdx], edgeValues[yIdx], mode, &expectedErrors);
+			if(result != expected || errors != expectedErrors){
+				printf("%s in mode %u at x=%d y=%d: %d errors %x, expected %d errors %x\n", text, mode, edgeValues[xIdx], edgeValues[yIdx],
+					result, errors, expected, expectedErrors);
+				failures++;
+				return;
+			}
+		}
+	}
+}
+
+// strength reduced steps by a constant, divisions by a constant other than 0 and -1 run unchecked
+static void checkConstant(PipelineVariantType type, char operator, ValueType constant, ArithmeticMode mode){
+	PipelineVariant storage[8];
+	Pipeline pipeline = CREATE_PIPELINE_FROM_CONST_STORAGE(storage);
+	pushPipeline(&pipeline, makeStepAsVariableIndex(0));
+	pushPipeline(&pipeline, makeStepAsConstant(constant));
+	pushPipeline(&pipeline, (PipelineVariant){.type = type});
+	strengthReducePipeline(&pipeline);
+	CheckedPipeline checked;
+	prepareCheckedPipeline(&checked, &pipeline, mode, NULL);
+	PipelineStack stack;
+	initStack(&stack);
+	PipelineVariablesSlice slice = MAKE_SLICE_FROM_CONST_PIPELINE_VARIABLES(variables);
+	for(uint8_t xIdx = 0; xIdx < ARRAY_CONST_SIZE(edgeValues); xIdx++){
+		variables[0].value = edgeValues[xIdx];
+		uint8_t errors = ARITHMETIC_NO_ERROR;
+		uint8_t expectedErrors = ARITHMETIC_NO_ERROR;
+		ValueType result = executeCheckedPipeline(&checked, &stack, slice, &errors);
+		ValueType expected = referenceResult(operator, edgeValues[xIdx], constant, mode, &expectedErrors);
+		if(result != expected || errors != expectedErrors){
+			printf("x %c %d in mode %u at x=%d: %d errors %x, expected %d errors %x\n", operator, constant, mode, edgeValues[xIdx], result, errors, expected, expectedErrors);
+			failures++;
+			return;
+		}
+	}
+}
+
+// ERROR MASK
+
+static void checkBatchErrors(void){
+	PipelineVariant storage[16];
+	Pipeline pipeline = CREATE_PIPELINE_FROM_CONST_STORAGE(storage);
+	if(!compileText(&pipeline, "x * 3 / y")){
+		return;
+	}
+	CheckedPipeline checked;
+	prepareCheckedPipeline(&checked, &pipeline, ARITHMETIC_SATURATING, NULL);
+	static const ValueType xColumn[] = {10, INT32_MAX, 5, -9};
+	static const ValueType yColumn[] = {2, 1, 0, 3};
+	static const ValueType expected[] = {15, INT32_MAX, INT32_MAX, -9};
+	const ValueType* columns[] = {xColumn, yColumn};
+	PipelineStack stack;
+	initStack(&stack);
+	ValueType results[ARRAY_CONST_SIZE(xColumn)];
+	uint8_t errors = ARITHMETIC_NO_ERROR;
+	executeCheckedPipelineBatch(&checked, &stack, variables, ARRAY_CONST_SIZE(variables), columns, ARRAY_CONST_SIZE(xColumn), results, &errors);
+	for(uint8_t row = 0; row < ARRAY_CONST_SIZE(xColumn); row++){
+		if(results[row] != expected[row]){
+			printf("x * 3 / y batch row %u: %d, expected %d\n", row, results[row], expected[row]);
+			failures++;
+		}
+	}
+	if(errors != (ARITHMETIC_OVERFLOW | ARITHMETIC_DIVISION_BY_ZERO)){
+		printf("x * 3 / y batch errors %x, expected both faults\n", errors);
+		failures++;
+	}
+
+	// the mask stays set until the caller clears it
+	variables[0].value = 1;
+	variables[1].value = 1;
+	executeCheckedPipeline(&checked, &stack, MAKE_SLICE_FROM_CONST_PIPELINE_VARIABLES(variables), &errors);
+	if(errors != (ARITHMETIC_OVERFLOW | ARITHMETIC_DIVISION_BY_ZERO)){
+		printf("x * 3 / y errors %x after a clean evaluation, expected them kept\n", errors);
+		failures++;
+	}
+}
+
+// PROVEN STEPS
+
+static void checkProven(const char* text, ValueRange range, bool allProven){
+	PipelineVariant storage[32];
+	Pipeline pipeline = CREATE_PIPELINE_FROM_CONST_STORAGE(storage);
+	if(!compileText(&pipeline, text)){
+		return;
+	}
+	const ValueRange ranges[] = {range, range};
+	StepRange steps[32];
+	analyzePipelineRanges(&pipeline, ranges, ARRAY_CONST_SIZE(ranges), steps);
+	CheckedPipeline checked;
+	prepareCheckedPipeline(&checked, &pipeline, ARITHMETIC_SATURATING, steps);
+	bool proven = true;
+	for(Index pipelineIdx = 0; pipelineIdx <= pipeline.index; pipelineIdx++){
+		proven = proven && (checked.provenSteps[pipelineIdx / 32] >> (pipelineIdx % 32) & 1) != 0;
+	}
+	if(proven != allProven){
+		printf("%s: %s proven, expected %s\n", text, proven ? "all steps" : "not all steps", allProven ? "all" : "not all");
+		failures++;
+		return;
+	}
+	if(!proven){
+		return;
+	}
+
+	// inside the ranges the proven pipeline computes exactly what executePipeline does
+	PipelineStack stack;
+	initStack(&stack);
+	PipelineVariablesSlice slice = MAKE_SLICE_FROM_CONST_PIPELINE_VARIABLES(variables);
+	for(ValueType x = range.low; x <= range.high; x += (range.high - range.low) / 8){
+		for(ValueType y = range.low; y <= range.high; y += (range.high - range.low) / 8){
+			variables[0].value = x;
+			variables[1].value = y;
+			uint8_t errors = ARITHMETIC_NO_ERROR;
+			ValueType result = executeCheckedPipeline(&checked, &stack, slice, &errors);
+			ValueType expected = executePipeline(&pipeline, &stack, slice);
+			if(result != expected || errors != ARITHMETIC_NO_ERROR){
+				printf("%s at x=%d y=%d: %d errors %x, expected %d\n", text, x, y, result, errors, expected);
+				failures++;
+				return;
+			}
+		}
+	}
+}
+
+int main(void){
+	static const char operators[] = "+-*/%";
+	static const char* const texts[] = {"x + y", "x - y", "x * y", "x / y", "x % y"};
+	for(uint8_t mode = ARITHMETIC_WRAPPING; mode <= ARITHMETIC_SATURATING; mode++){
+		for(uint8_t idx = 0; idx < ARRAY_CONST_SIZE(texts); idx++){
+			checkOperator(texts[idx], operators[idx], (ArithmeticMode)mode);
+		}
+		checkConstant(OPERATION_NATIVE_MUL, '*', 8, (ArithmeticMode)mode);
+		checkConstant(OPERATION_NATIVE_DIV, '/', 7, (ArithmeticMode)mode);
+		checkConstant(OPERATION_NATIVE_MOD, '%', 7, (ArithmeticMode)mode);
+		checkConstant(OPERATION_NATIVE_DIV, '/', 16, (ArithmeticMode)mode);
+		checkConstant(OPERATION_NATIVE_MOD, '%', -16, (ArithmeticMode)mode);
+		checkConstant(OPERATION_NATIVE_DIV, '/', -1, (ArithmeticMode)mode);
+		checkConstant(OPERATION_NATIVE_MOD, '%', -1, (ArithmeticMode)mode);
+		checkConstant(OPERATION_NATIVE_DIV, '/', 0, (ArithmeticMode)mode);
+		checkConstant(OPERATION_NATIVE_MOD, '%', 0, (ArithmeticMode)mode);
+	}
+	checkBatchErrors();
+	checkProven("x * y + 3 - x / 5", (ValueRange){-1000, 1000}, true);
+	checkProven("x * y * y", (ValueRange){-1000, 1000}, true);
+	checkProven("x * y * y * y", (ValueRange){-1000, 1000}, false);
+	checkProven("x / y", (ValueRange){-8, 8}, false);
+
+	printf("testchecked: %s\n", failures == 0 ? "match" : "MISMATCH");
+	return failures != 0;
+}
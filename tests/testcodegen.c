@@ -0,0 +1,235 @@
+#include "../include/pipelinecodegen.h"
+#include "../include/expressionparser.h"
+#include "../include/pipelineoptimizer.h"
+#include "../include/pipelinerange.h"
+#include "testexpressions.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// Generates C for random expressions compiled with random pass combinations, builds the generated
+// source with the host compiler and checks every function against executePipeline results recorded
+// for the same inputs. Runs from tests/, the generated program includes ../include/execpipeline.h.
+//   testcodegen [expressions] [seed]
+
+#define CODEGEN_INPUTS 8
+#define CODEGEN_VARIABLE_LIMIT 1000
+#define CODEGEN_SOURCE "testcodegen_generated.c"
+#define CODEGEN_BINARY "./testcodegen_generated"
+#define CODEGEN_COMPILE "gcc -O2 -Wall -Werror -Wno-unused-label " CODEGEN_SOURCE " ../src/pipelinemath.c ../src/pipelinefixed.c -o " CODEGEN_BINARY
+
+// EXPRESSIONS
+
+// Own kinds instead of an ExpressionShape: calls to sqrt, sin and lerp and variable divisors are what the
+// generated code has to get right. Divisors are never 0 or -1, so neither the interpreter nor the
+// generated code can trap.
+static void generateCodegenExpression(ExpressionText* expression, uint8_t depth){
+	uint32_t kind = depth == 0 ? nextRandom() % 2 : nextRandom() % 18;
+	switch (kind)
+	{
+		case 0:
+			appendExpression(expression, "%d", (ValueType)(nextRandom() % 200));
+			return;
+		case 1:
+			appendExpression(expression, "%c", "xyz"[nextRandom() % 3]);
+			return;
+		case 8:
+			appendExpression(expression, "(", 0);
+			generateCodegenExpression(expression, depth - 1);
+			appendExpression(expression, "/%d)", (ValueType)(nextRandom() % 70) + 2);
+			return;
+		case 9:
+			appendExpression(expression, "(", 0);
+			generateCodegenExpression(expression, depth - 1);
+			appendExpression(expression, "%%%d)", (ValueType)(nextRandom() % 70) + 2);
+			return;
+		case 10:
+			appendExpression(expression, "(", 0);
+			generateCodegenExpression(expression, depth - 1);
+			appendExpression(expression, "/(", 0);
+			generateCodegenExpression(expression, depth - 1);
+			appendExpression(expression, "%%7+8))", 0);
+			return;
+		case 14:
+			appendExpression(expression, "(", 0);
+			generateCodegenExpression(expression, depth - 1);
+			appendExpression(expression, "?", 0);
+			generateCodegenExpression(expression, depth - 1);
+			appendExpression(expression, ":", 0);
+			generateCodegenExpression(expression, depth - 1);
+			appendExpression(expression, ")", 0);
+			return;
+		case 15:
+			appendExpression(expression, "sqrt(", 0);
+			generateCodegenExpression(expression, depth - 1);
+			appendExpression(expression, ")", 0);
+			return;
+		case 16:
+			appendExpression(expression, "sin(", 0);
+			generateCodegenExpression(expression, depth - 1);
+			appendExpression(expression, ")", 0);
+			return;
+		case 17:
+			appendExpression(expression, "lerp(", 0);
+			generateCodegenExpression(expression, depth - 1);
+			appendExpression(expression, ",", 0);
+			generateCodegenExpression(expression, depth - 1);
+			appendExpression(expression, ",", 0);
+			generateCodegenExpression(expression, depth - 1);
+			appendExpression(expression, ")", 0);
+			return;
+	}
+	static const char* binaryOperators[] = {
+		[2] = "+", [3] = "-", [4] = "*", [5] = "<", [6] = ">=", [7] = "==", [11] = "&&", [12] = "||", [13] = "*"
+	};
+	appendExpression(expression, "(", 0);
+	generateCodegenExpression(expression, depth - 1);
+	appendExpression(expression, binaryOperators[kind], 0);
+	generateCodegenExpression(expression, depth - 1);
+	appendExpression(expression, ")", 0);
+}
+
+// PASSES
+
+typedef enum {
+	PASS_FOLD = 0x01,
+	PASS_STRENGTH_REDUCE = 0x02,
+	PASS_REORDER = 0x04,
+	PASS_NARROW = 0x08
+} CodegenPasses;
+
+static void runPasses(Pipeline* pipeline, uint8_t passes, int8_t variableCount){
+	if(passes & PASS_FOLD){
+		foldConstantsPipeline(pipeline);
+	}
+	if(passes & PASS_REORDER){
+		reorderPipelineOperands(pipeline);
+	}
+	if(passes & PASS_STRENGTH_REDUCE){
+		strengthReducePipeline(pipeline);
+	}
+	if(passes & PASS_NARROW){
+		ValueRange variableRanges[3];
+		for(int8_t variableIdx = 0; variableIdx < variableCount; variableIdx++){
+			variableRanges[variableIdx] = (ValueRange){.low = -CODEGEN_VARIABLE_LIMIT, .high = CODEGEN_VARIABLE_LIMIT};
+		}
+		StepRange steps[NONE_INDEX];
+		if(analyzePipelineRanges(pipeline, variableRanges, variableCount, steps)){
+			narrowPipeline(pipeline, steps);
+		}
+	}
+}
+
+static void writeLine(void* context, const char* line){
+	fprintf((FILE*)context, "%s\n", line);
+}
+
+int main(int argc, char** argv){
+	int expressionCount = argc > 1 ? atoi(argv[1]) : 500;
+	randomState = argc > 2 ? (uint32_t)strtoul(argv[2], NULL, 10) : 20261019u;
+	if(expressionCount <= 0 || randomState == 0){
+		printf("usage: testcodegen [expressions] [seed]\n");
+		return 1;
+	}
+
+	FILE* source = fopen(CODEGEN_SOURCE, "w");
+	if(source == NULL){
+		printf("cannot write %s\n", CODEGEN_SOURCE);
+		return 1;
+	}
+	fprintf(source, "#include \"../include/execpipeline.h\"\n#include <stdio.h>\n\n");
+
+	PipelineVariable inputs[CODEGEN_INPUTS][3];
+	for(uint8_t inputIdx = 0; inputIdx < CODEGEN_INPUTS; inputIdx++){
+		for(uint8_t variableIdx = 0; variableIdx < 3; variableIdx++){
+			ValueType value = (ValueType)(nextRandom() % (2 * CODEGEN_VARIABLE_LIMIT + 1)) - CODEGEN_VARIABLE_LIMIT;
+			inputs[inputIdx][variableIdx] = (PipelineVariable){.name = "xyz"[variableIdx], .value = value};
+		}
+	}
+
+	// expected results and expressions go into the generated program after the functions
+	ValueType (*expected)[CODEGEN_INPUTS] = calloc((size_t)expressionCount, sizeof(*expected));
+	ExpressionText* expressions = calloc((size_t)expressionCount, sizeof(ExpressionText));
+	uint8_t* passes = calloc((size_t)expressionCount, 1);
+	int generated = 0;
+	PipelineStack stack;
+	while(generated < expressionCount){
+		ExpressionText* expression = &expressions[generated];
+		expression->length = 0;
+		expression->text[0] = '\0';
+		generateCodegenExpression(expression, (uint8_t)(1 + nextRandom() % 6));
+
+		PipelineVariant storage[NONE_INDEX];
+		Pipeline pipeline = CREATE_PIPELINE_FROM_CONST_STORAGE(storage);
+		if(!compileText(&pipeline, expression->text, (PipelineVariablesSlice){inputs[0], 3})){
+			continue;
+		}
+		passes[generated] = (uint8_t)(nextRandom() % 16);
+		runPasses(&pipeline, passes[generated], 3);
+		for(uint8_t inputIdx = 0; inputIdx < CODEGEN_INPUTS; inputIdx++){
+			expected[generated][inputIdx] = executePipeline(&pipeline, &stack, (PipelineVariablesSlice){inputs[inputIdx], 3});
+		}
+
+		char functionName[32];
+		snprintf(functionName, sizeof(functionName), "generated%d", generated);
+		// every pipeline the parser and passes produce has to be accepted
+		if(!generatePipelineFunction(&pipeline, functionName, writeLine, source)){
+			printf("no code generated for %s (passes %u)\n", expression->text, passes[generated]);
+			fclose(source);
+			return 1;
+		}
+		fprintf(source, "\n");
+		generated++;
+	}
+
+	fprintf(source, "static ValueType (*const functions[])(const PipelineVariable variables[]) = {\n");
+	for(int expressionIdx = 0; expressionIdx < expressionCount; expressionIdx++){
+		fprintf(source, "\tgenerated%d,\n", expressionIdx);
+	}
+	fprintf(source, "};\n\nstatic const char* const expressions[] = {\n");
+	for(int expressionIdx = 0; expressionIdx < expressionCount; expressionIdx++){
+		fprintf(source, "\t\"%s\", // passes %u\n", expressions[expressionIdx].text, passes[expressionIdx]);
+	}
+	fprintf(source, "};\n\nstatic const PipelineVariable inputs[%d][3] = {\n", CODEGEN_INPUTS);
+	for(uint8_t inputIdx = 0; inputIdx < CODEGEN_INPUTS; inputIdx++){
+		fprintf(source, "\t{{'x', %d}, {'y', %d}, {'z', %d}},\n", inputs[inputIdx][0].value, inputs[inputIdx][1].value, inputs[inputIdx][2].value);
+	}
+	fprintf(source, "};\n\nstatic const ValueType expected[][%d] = {\n", CODEGEN_INPUTS);
+	for(int expressionIdx = 0; expressionIdx < expressionCount; expressionIdx++){
+		fprintf(source, "\t{");
+		for(uint8_t inputIdx = 0; inputIdx < CODEGEN_INPUTS; inputIdx++){
+			fprintf(source, inputIdx + 1 < CODEGEN_INPUTS ? "%d, " : "%d", expected[expressionIdx][inputIdx]);
+		}
+		fprintf(source, "},\n");
+	}
+	fprintf(source, "};\n\n"
+		"int main(void){\n"
+		"\tint failures = 0;\n"
+		"\tfor(size_t expressionIdx = 0; expressionIdx < ARRAY_CONST_SIZE(functions); expressionIdx++){\n"
+		"\t\tfor(size_t inputIdx = 0; inputIdx < ARRAY_CONST_SIZE(inputs); inputIdx++){\n"
+		"\t\t\tValueType result = functions[expressionIdx](inputs[inputIdx]);\n"
+		"\t\t\tif(result != expected[expressionIdx][inputIdx] && failures++ < 10){\n"
+		"\t\t\t\tprintf(\"%%s with input %%zu: generated %%d, interpreted %%d\\n\", expressions[expressionIdx], inputIdx, result, expected[expressionIdx][inputIdx]);\n"
+		"\t\t\t}\n"
+		"\t\t}\n"
+		"\t}\n"
+		"\treturn failures != 0;\n"
+		"}\n");
+	fclose(source);
+	free(expected);
+	free(expressions);
+	free(passes);
+
+	if(system(CODEGEN_COMPILE) != 0){
+		printf("generated source does not compile, kept in %s\n", CODEGEN_SOURCE);
+		return 1;
+	}
+	int failed = system(CODEGEN_BINARY);
+	printf("%d generated functions: %s\n", generated, failed == 0 ? "match" : "MISMATCH");
+	if(failed != 0){
+		return 1;
+	}
+	remove(CODEGEN_SOURCE);
+	remove(CODEGEN_BINARY);
+	return 0;
+}
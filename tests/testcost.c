@@ -0,0 +1,127 @@
+#include "../include/pipelinecost.h"
+
+#include <stdio.h>
+
+// Checks estimatePipelineCost on fixed pipelines under a test table with known step costs, the worst
+// side of conditionals and the budget check of compileExpressionWithBudget.
+//   testcost
+
+static int failures;
+
+static const uint16_t testOperations[] = {
+	[OPERATION_MAP_DIV] = 100,
+	// no estimate, charged as unknownOperation
+	[OPERATION_MAP_MOD] = 0
+};
+
+static PipelineCostTable makeTestTable(void){
+	PipelineCostTable table = {
+		.dispatch = 1,
+		.steps = {0},
+		.operations = testOperations,
+		.operationCount = ARRAY_CONST_SIZE(testOperations),
+		.unknownOperation = 50
+	};
+	for(uint8_t type = 0; type < PIPELINE_VARIANT_TYPE_COUNT; type++){
+		table.steps[type] = 10;
+	}
+	table.steps[CONSTANT] = 2;
+	table.steps[VARIABLE_INDEX] = 3;
+	table.steps[OPERATION_NATIVE_MUL] = 7;
+	table.steps[OPERATION] = 20;
+	return table;
+}
+
+static void checkCost(const char* what, const Pipeline* pipeline, uint32_t cycles, uint8_t maxStackDepth){
+	PipelineCostTable table = makeTestTable();
+	PipelineCost cost = estimatePipelineCost(pipeline, &table);
+	if(cost.cycles != cycles || cost.maxStackDepth != maxStackDepth || cost.stackBytes != maxStackDepth * sizeof(ValueType)){
+		printf("%s: %u cycles depth %u bytes %u, expected %u cycles depth %u\n", what, cost.cycles, cost.maxStackDepth, cost.stackBytes, cycles, maxStackDepth);
+		failures++;
+	}
+}
+
+static void checkFixedPipelines(void){
+	PipelineVariant storage[16];
+	Pipeline pipeline = CREATE_PIPELINE_FROM_CONST_STORAGE(storage);
+	checkCost("empty", &pipeline, 0, 0);
+
+	// x 3 MUL: (1 + 3) + (1 + 2) + (1 + 7)
+	pushPipeline(&pipeline, makeStepAsVariableIndex(0));
+	pushPipeline(&pipeline, makeStepAsConstant(3));
+	pushPipeline(&pipeline, (PipelineVariant){.type = OPERATION_NATIVE_MUL});
+	checkCost("x * 3", &pipeline, 15, 2);
+
+	// x y mod(): 4 + 4 + (1 + 20 + 50)
+	clearPipeline(&pipeline);
+	pushPipeline(&pipeline, makeStepAsVariableIndex(0));
+	pushPipeline(&pipeline, makeStepAsVariableIndex(1));
+	pushPipeline(&pipeline, makeStepAsOperation(getOperationByName(MAKE_SLICE_FROM_CONST_STRING("mod")), 2));
+	checkCost("mod(x, y)", &pipeline, 79, 2);
+
+	// x ? div(y, 2) : 0 where the division is the worst path: 4 + 11 + (4 + 3 + 121 + 11)
+	clearPipeline(&pipeline);
+	pushPipeline(&pipeline, makeStepAsVariableIndex(0));
+	pushPipeline(&pipeline, makeStepAsJump(JUMP_IF_ZERO, 6));
+	pushPipeline(&pipeline, makeStepAsVariableIndex(1));
+	pushPipeline(&pipeline, makeStepAsConstant(2));
+	pushPipeline(&pipeline, makeStepAsOperation(getOperationByName(MAKE_SLICE_FROM_CONST_STRING("div")), 2));
+	pushPipeline(&pipeline, makeStepAsJump(JUMP, 7));
+	pushPipeline(&pipeline, makeStepAsConstant(0));
+	checkCost("x ? div(y, 2) : 0", &pipeline, 154, 2);
+
+	// x ? 0 : div(y, 2), the division is now behind the jump: 4 + 11 + (4 + 3 + 121)
+	clearPipeline(&pipeline);
+	pushPipeline(&pipeline, makeStepAsVariableIndex(0));
+	pushPipeline(&pipeline, makeStepAsJump(JUMP_IF_ZERO, 4));
+	pushPipeline(&pipeline, makeStepAsConstant(0));
+	pushPipeline(&pipeline, makeStepAsJump(JUMP, 7));
+	pushPipeline(&pipeline, makeStepAsVariableIndex(1));
+	pushPipeline(&pipeline, makeStepAsConstant(2));
+	pushPipeline(&pipeline, makeStepAsOperation(getOperationByName(MAKE_SLICE_FROM_CONST_STRING("div")), 2));
+	checkCost("x ? 0 : div(y, 2)", &pipeline, 143, 2);
+}
+
+// BUDGET
+
+static void checkBudget(const char* text){
+	PipelineVariable variables[] = {{'x', 0}, {'y', 0}};
+	PipelineVariablesSlice slice = MAKE_SLICE_FROM_CONST_PIPELINE_VARIABLES(variables);
+	PipelineCostTable table = makeTestTable();
+	PipelineVariant storage[32];
+	Pipeline pipeline = CREATE_PIPELINE_FROM_CONST_STORAGE(storage);
+	PeekableStringSlice input = {.slice = makeSliceFromString(text), .cursor = 0, .context = NULL};
+	PipelineCost unlimited = {.cycles = 0, .stackBytes = 0, .maxStackDepth = 0};
+	if(compileExpressionWithBudget(&pipeline, &input, slice, &table, unlimited).type != NOERROR){
+		printf("%s: does not compile without a budget\n", text);
+		failures++;
+		return;
+	}
+	PipelineCost cost = estimatePipelineCost(&pipeline, &table);
+
+	PipelineCost budgets[] = {
+		{.cycles = cost.cycles, .stackBytes = 0, .maxStackDepth = 0},
+		{.cycles = 0, .stackBytes = cost.stackBytes, .maxStackDepth = cost.maxStackDepth},
+		{.cycles = cost.cycles - 1, .stackBytes = 0, .maxStackDepth = 0},
+		{.cycles = 0, .stackBytes = cost.stackBytes - 1, .maxStackDepth = 0},
+		{.cycles = 0, .stackBytes = 0, .maxStackDepth = cost.maxStackDepth - 1}
+	};
+	for(uint8_t idx = 0; idx < ARRAY_CONST_SIZE(budgets); idx++){
+		clearPipeline(&pipeline);
+		input.cursor = 0;
+		ParsingErrorType expected = idx < 2 ? NOERROR : BUDGET_EXCEEDED;
+		if(compileExpressionWithBudget(&pipeline, &input, slice, &table, budgets[idx]).type != expected){
+			printf("%s with budget %u: expected error %u\n", text, idx, expected);
+			failures++;
+		}
+	}
+}
+
+int main(void){
+	checkFixedPipelines();
+	checkBudget("x * (y + 3) - div(x, y + 1)");
+	checkBudget("x > y ? (x - 1) * (y - 2) * (x + y) : 4");
+
+	printf("testcost: %s\n", failures == 0 ? "match" : "MISMATCH");
+	return failures != 0;
+}
@@ -0,0 +1,116 @@
+#include "../include/pipelinedefinition.h"
+
+#include <stdio.h>
+
+// Checks expressions calling definitions against the same expressions written out by hand, including
+// nested and conditional bodies, redefinition, and the errors of bad calls and bad definitions.
+//   testdefinition
+
+#define DEFINITION_INPUT_LIMIT 4
+
+static int failures;
+
+static PipelineVariable variables[] = {{'x', 0}, {'y', 0}};
+
+static ParsingError define(PipelineDefinitions* definitions, const char* text){
+	PeekableStringSlice input = {.slice = makeSliceFromString(text), .cursor = 0, .context = NULL};
+	return definePipelineExpression(definitions, &input);
+}
+
+static void checkDefine(PipelineDefinitions* definitions, const char* text, ParsingErrorType expected){
+	ParsingError err = define(definitions, text);
+	if(err.type != expected){
+		printf("%s: defined with error %u, expected %u\n", text, err.type, expected);
+		failures++;
+	}
+}
+
+static void checkExpanded(PipelineDefinitions* definitions, const char* text, const char* expanded){
+	PipelineVariablesSlice slice = MAKE_SLICE_FROM_CONST_PIPELINE_VARIABLES(variables);
+	PipelineVariant storage[NONE_INDEX];
+	Pipeline pipeline = CREATE_PIPELINE_FROM_CONST_STORAGE(storage);
+	PeekableStringSlice input = {.slice = makeSliceFromString(text), .cursor = 0, .context = NULL};
+	if(compileExpressionWithDefinitions(&pipeline, &input, slice, definitions).type != NOERROR || pipeline.errorMask != NO_ERROR){
+		printf("%s: does not compile\n", text);
+		failures++;
+		return;
+	}
+	PipelineVariant expandedStorage[NONE_INDEX];
+	Pipeline expandedPipeline = CREATE_PIPELINE_FROM_CONST_STORAGE(expandedStorage);
+	PeekableStringSlice expandedInput = {.slice = makeSliceFromString(expanded), .cursor = 0, .context = NULL};
+	if(compileExpression(&expandedPipeline, &expandedInput, slice).type != NOERROR){
+		printf("%s: does not compile\n", expanded);
+		failures++;
+		return;
+	}
+
+	PipelineStack stack;
+	initStack(&stack);
+	for(ValueType x = -DEFINITION_INPUT_LIMIT; x <= DEFINITION_INPUT_LIMIT; x++){
+		for(ValueType y = -DEFINITION_INPUT_LIMIT; y <= DEFINITION_INPUT_LIMIT; y++){
+			variables[0].value = x;
+			variables[1].value = y;
+			ValueType result = executePipeline(&pipeline, &stack, slice);
+			ValueType expected = executePipeline(&expandedPipeline, &stack, slice);
+			if(result != expected){
+				printf("%s at x=%d y=%d: %d, written out %d\n", text, x, y, result, expected);
+				failures++;
+				return;
+			}
+		}
+	}
+}
+
+static void checkCallError(PipelineDefinitions* definitions, const char* text, ParsingErrorType expected){
+	PipelineVariant storage[64];
+	Pipeline pipeline = CREATE_PIPELINE_FROM_CONST_STORAGE(storage);
+	PeekableStringSlice input = {.slice = makeSliceFromString(text), .cursor = 0, .context = NULL};
+	ParsingError err = compileExpressionWithDefinitions(&pipeline, &input, MAKE_SLICE_FROM_CONST_PIPELINE_VARIABLES(variables), definitions);
+	if(err.type != expected){
+		printf("%s: compiled with error %u, expected %u\n", text, err.type, expected);
+		failures++;
+	}
+}
+
+int main(void){
+	PipelineVariant fragmentStorage[128];
+	PipelineDefinitions definitions;
+	initPipelineDefinitions(&definitions, fragmentStorage, ARRAY_CONST_SIZE(fragmentStorage));
+
+	checkDefine(&definitions, "scale(a) := a*9/5+32", NOERROR);
+	checkDefine(&definitions, "twice(a) := scale(a) + scale(a)", NOERROR);
+	checkDefine(&definitions, "clamp(a, b, c) := a < b ? b : a > c ? c : a", NOERROR);
+	checkDefine(&definitions, "both(a, b) := a && b", NOERROR);
+	checkDefine(&definitions, "mix(a, b) := div(a + b, 2) - clamp(b, a, 3)", NOERROR);
+
+	checkExpanded(&definitions, "scale(x) - 1", "x*9/5+32 - 1");
+	checkExpanded(&definitions, "twice(x + y)", "((x+y)*9/5+32) + ((x+y)*9/5+32)");
+	checkExpanded(&definitions, "clamp(x * y, 0 - 3, 4) + 1", "(x*y < 0-3 ? 0-3 : x*y > 4 ? 4 : x*y) + 1");
+	checkExpanded(&definitions, "both(x, y) + both(y > 1, x) * 2", "(x && y) + ((y > 1) && x) * 2");
+	checkExpanded(&definitions, "x ? both(y, x - 1) : clamp(y, x, 2)", "x ? (y && x - 1) : (y < x ? x : y > 2 ? 2 : y)");
+	checkExpanded(&definitions, "mix(x, twice(y))", "div(x + ((y*9/5+32)+(y*9/5+32)), 2) - (((y*9/5+32)+(y*9/5+32)) < x ? x : ((y*9/5+32)+(y*9/5+32)) > 3 ? 3 : ((y*9/5+32)+(y*9/5+32)))");
+
+	// a call with the wrong number of arguments
+	checkCallError(&definitions, "scale(x, y)", TOO_MANY_ARGUMENTS);
+	checkCallError(&definitions, "clamp(x, y)", TOO_LITTLE_ARGUMENTS);
+	checkCallError(&definitions, "nothing(x)", UNKNOWN_OPERATION);
+
+	// a body may only use its parameters and earlier definitions, so no recursion
+	checkDefine(&definitions, "loop(a) := loop(a) + 1", UNKNOWN_OPERATION);
+	checkDefine(&definitions, "free(a) := a + x", UNKNOWN_VARIABLE);
+	checkCallError(&definitions, "loop(x)", UNKNOWN_OPERATION);
+
+	// redefinition only affects later expressions
+	checkDefine(&definitions, "scale(a) := a * 2", NOERROR);
+	checkExpanded(&definitions, "scale(x) + y", "x * 2 + y");
+
+	while(definitions.definitionCount < PIPELINE_MAX_DEFINITIONS){
+		char text[32];
+		snprintf(text, sizeof(text), "fill%u(a) := a", definitions.definitionCount);
+		checkDefine(&definitions, text, NOERROR);
+	}
+	checkDefine(&definitions, "extra(a) := a", DEFINITIONS_FULL);
+
+	printf("testdefinition: %s\n", failures == 0 ? "match" : "MISMATCH");
+	return failures != 0;
+}
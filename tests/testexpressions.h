@@ -0,0 +1,125 @@
+#ifndef TESTEXPRESSIONS_H
+#define TESTEXPRESSIONS_H
+
+#include "../include/expressionparser.h"
+
+#include <stdio.h>
+#include <string.h>
+
+// Random expression texts for the randomized tests, each test seeds randomState from its arguments.
+
+#ifndef EXPRESSION_TEXT_CAPACITY
+#define EXPRESSION_TEXT_CAPACITY 2048
+#endif
+
+static uint32_t randomState;
+
+static inline uint32_t nextRandom(void){
+	randomState ^= randomState << 13;
+	randomState ^= randomState >> 17;
+	randomState ^= randomState << 5;
+	return randomState;
+}
+
+typedef struct {
+	char text[EXPRESSION_TEXT_CAPACITY];
+	size_t length;
+} ExpressionText;
+
+// text that does not fit is left out
+static inline void appendExpression(ExpressionText* expression, const char* format, ValueType value){
+	int written = snprintf(expression->text + expression->length, sizeof(expression->text) - expression->length, format, value);
+	if(written > 0 && expression->length + (size_t)written < sizeof(expression->text)){
+		expression->length += (size_t)written;
+	}
+}
+
+typedef struct {
+	// letters of the variables a leaf picks from
+	const char* variables;
+	// constants are constantLow plus a draw below constantSpread, half of them below wideSpread when it is not 0
+	ValueType constantLow;
+	uint32_t constantSpread;
+	uint32_t wideSpread;
+	// without conditionals there is no ?:, && or || and every prefix of the pipeline is a pipeline
+	bool conditionals;
+	// lerp and isqrt
+	bool operations;
+} ExpressionShape;
+
+// divisors are never 0 or -1
+static inline void generateExpression(ExpressionText* expression, const ExpressionShape* shape, uint8_t depth){
+	static const char* binaryOperators[] = {"+", "-", "*", "&&", "||", "<", "<=", ">", "==", "!="};
+	uint32_t kind = depth == 0 ? nextRandom() % 2 : nextRandom() % 16;
+	if((!shape->conditionals && (kind == 2 || kind == 3 || kind == 13 || kind == 14)) || (!shape->operations && (kind == 6 || kind == 7))){
+		kind = 10;
+	}
+	switch (kind)
+	{
+		case 0:
+			{
+				uint32_t spread = shape->wideSpread != 0 && nextRandom() % 2 == 0 ? shape->wideSpread : shape->constantSpread;
+				appendExpression(expression, "%d", shape->constantLow + (ValueType)(nextRandom() % spread));
+			}
+			return;
+		case 1:
+			appendExpression(expression, "%c", shape->variables[nextRandom() % strlen(shape->variables)]);
+			return;
+		case 2:
+		case 3:
+			appendExpression(expression, "(", 0);
+			generateExpression(expression, shape, depth - 1);
+			appendExpression(expression, "?", 0);
+			generateExpression(expression, shape, depth - 1);
+			appendExpression(expression, ":", 0);
+			generateExpression(expression, shape, depth - 1);
+			appendExpression(expression, ")", 0);
+			return;
+		case 4:
+			appendExpression(expression, "(", 0);
+			generateExpression(expression, shape, depth - 1);
+			appendExpression(expression, "/%d)", (ValueType)(nextRandom() % 9) + 2);
+			return;
+		case 5:
+			appendExpression(expression, "(", 0);
+			generateExpression(expression, shape, depth - 1);
+			appendExpression(expression, "%%(", 0);
+			generateExpression(expression, shape, depth - 1);
+			appendExpression(expression, "%%5+6))", 0);
+			return;
+		case 6:
+			appendExpression(expression, "lerp(", 0);
+			generateExpression(expression, shape, depth - 1);
+			appendExpression(expression, ",", 0);
+			generateExpression(expression, shape, depth - 1);
+			appendExpression(expression, ",", 0);
+			generateExpression(expression, shape, depth - 1);
+			appendExpression(expression, "*16384)", 0);
+			return;
+		case 7:
+			appendExpression(expression, "isqrt(", 0);
+			generateExpression(expression, shape, depth - 1);
+			appendExpression(expression, ")", 0);
+			return;
+	}
+	appendExpression(expression, "(", 0);
+	generateExpression(expression, shape, depth - 1);
+	appendExpression(expression, binaryOperators[kind % ARRAY_CONST_SIZE(binaryOperators)], 0);
+	generateExpression(expression, shape, depth - 1);
+	appendExpression(expression, ")", 0);
+}
+
+// false on a parsing error or a pipeline error
+static inline bool compileText(Pipeline* pipeline, const char* text, PipelineVariablesSlice variables){
+	PeekableStringSlice input = {.slice = makeSliceFromString(text), .cursor = 0, .context = NULL};
+	return compileExpression(pipeline, &input, variables).type == NOERROR && pipeline->errorMask == NO_ERROR;
+}
+
+static inline void copyPipeline(const Pipeline* source, Pipeline* target){
+	clearPipeline(target);
+	for(uint16_t pipelineIdx = 0; pipelineIdx < lengthOfPipeline(source); pipelineIdx++){
+		pushPipeline(target, source->entries[pipelineIdx]);
+	}
+}
+
+#endif
@@ -0,0 +1,101 @@
+#include "../include/pipelinefixed.h"
+
+#include <math.h>
+#include <stdio.h>
+
+// Checks the fixed point functions against libm within the error bounds documented in pipelinefixed.h,
+// on a strided sweep of each input range and at its edges.
+//   testfixed
+
+#define FIXED_SAMPLES 200000
+
+static int failures;
+
+static double toDouble(ValueType value){
+	return (double)value / FIXED_ONE;
+}
+
+static void checkBound(const char* name, ValueType input, double error, double bound){
+	if(!(error < bound)){
+		printf("%s(%d): error %g above %g\n", name, input, error, bound);
+		failures++;
+	}
+}
+
+// samples from low to high inclusive with the edges
+static ValueType sampleInput(ValueType low, ValueType high, uint32_t sample){
+	return (ValueType)(low + (int64_t)((double)((int64_t)high - low) * sample / FIXED_SAMPLES));
+}
+
+int main(void){
+	for(uint32_t sample = 0; sample <= FIXED_SAMPLES && failures == 0; sample++){
+		ValueType value = sampleInput(INT32_MIN, INT32_MAX, sample);
+		ValueType expectedRoot = value <= 0 ? 0 : (ValueType)floor(sqrt((double)value));
+		if(fixedIntegerSqrt(value) != expectedRoot){
+			printf("isqrt(%d): %d, expected %d\n", value, fixedIntegerSqrt(value), expectedRoot);
+			failures++;
+		}
+		double root = value <= 0 ? 0 : sqrt(toDouble(value)) * FIXED_ONE;
+		checkBound("sqrt", value, fabs(fixedSqrt(value) - root), 1.0);
+
+		double logarithm = log(toDouble(value)) * FIXED_ONE;
+		if(value <= 0){
+			checkBound("log", value, fixedLog(value) == INT32_MIN ? 0 : 1, 1);
+		}
+		else {
+			checkBound("log", value, fabs(fixedLog(value) - logarithm), 2.5);
+		}
+	}
+
+	// exp saturates outside about [-11.1, 10.39]
+	for(uint32_t sample = 0; sample <= FIXED_SAMPLES && failures == 0; sample++){
+		ValueType value = sampleInput(-12 * FIXED_ONE, 11 * FIXED_ONE, sample);
+		double exact = exp(toDouble(value)) * FIXED_ONE;
+		ValueType result = fixedExp(value);
+		if(exact >= INT32_MAX){
+			checkBound("exp", value, result == INT32_MAX ? 0 : 1, 1);
+		}
+		else if(exact >= FIXED_ONE){
+			checkBound("exp", value, fabs(result - exact) / exact, 2.5e-5);
+		}
+		else {
+			checkBound("exp", value, fabs(result - exact), 1.5);
+		}
+	}
+
+	for(uint32_t sample = 0; sample <= FIXED_SAMPLES && failures == 0; sample++){
+		ValueType angle = sampleInput(-100 * FIXED_ONE, 100 * FIXED_ONE, sample);
+		ValueType sine;
+		ValueType cosine;
+		fixedSinCos(angle, &sine, &cosine);
+		checkBound("sin", angle, fabs(sine - sin(toDouble(angle)) * FIXED_ONE), 0.6);
+		checkBound("cos", angle, fabs(cosine - cos(toDouble(angle)) * FIXED_ONE), 0.6);
+	}
+
+	// exact products are truncated towards minus infinity
+	static const ValueType operands[] = {INT32_MIN / 2, -3 * FIXED_ONE - 7, -FIXED_ONE, -1, 0, 1, FIXED_ONE / 3, FIXED_ONE, 5 * FIXED_ONE + 12345};
+	for(uint8_t leftIdx = 0; leftIdx < sizeof(operands) / sizeof(operands[0]); leftIdx++){
+		for(uint8_t rightIdx = 0; rightIdx < sizeof(operands) / sizeof(operands[0]); rightIdx++){
+			ValueType left = operands[leftIdx];
+			ValueType right = operands[rightIdx];
+			int64_t product = (int64_t)floor((double)left * right / FIXED_ONE);
+			if(product >= INT32_MIN && product <= INT32_MAX && fixedMul(left, right) != product){
+				printf("qmul(%d, %d): %d, expected %lld\n", left, right, fixedMul(left, right), (long long)product);
+				failures++;
+			}
+			ValueType interpolated = fixedLerp(left / 2, right / 2, FIXED_ONE / 4);
+			int64_t expected = left / 2 + (int64_t)floor(((double)(right / 2) - left / 2) / 4);
+			if(interpolated != expected){
+				printf("lerp(%d, %d, 0.25): %d, expected %lld\n", left / 2, right / 2, interpolated, (long long)expected);
+				failures++;
+			}
+		}
+	}
+	if(fixedDiv(FIXED_ONE, 0) != 0 || fixedDiv(3 * FIXED_ONE, 2 * FIXED_ONE) != 3 * FIXED_ONE / 2){
+		printf("qdiv: %d for 1 / 0 and %d for 3 / 2\n", fixedDiv(FIXED_ONE, 0), fixedDiv(3 * FIXED_ONE, 2 * FIXED_ONE));
+		failures++;
+	}
+
+	printf("testfixed: %s\n", failures == 0 ? "match" : "MISMATCH");
+	return failures != 0;
+}
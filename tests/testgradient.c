@@ -0,0 +1,103 @@
+#include "../include/pipelinegradient.h"
+#include "../include/pipelineoptimizer.h"
+#include "../include/expressionparser.h"
+
+#include <stdio.h>
+
+// Checks executePipelineGradient on polynomials with known partial derivatives over a grid of inputs,
+// before and after strength reduction, and its value against executePipeline.
+//   testgradient
+
+#define GRADIENT_INPUT_LIMIT 6
+
+typedef ValueType (*KnownDerivative)(ValueType x, ValueType y);
+
+static int failures;
+
+static ValueType cubicDx(ValueType x, ValueType y){ return 2 * x * y + 3; }
+static ValueType cubicDy(ValueType x, ValueType y){ return x * x - 2 * y; }
+static ValueType shiftedDx(ValueType x, ValueType y){ (void)x; (void)y; return 8; }
+static ValueType shiftedDy(ValueType x, ValueType y){ return 4 * y * y * y - 1; }
+static ValueType branchDx(ValueType x, ValueType y){ return x > y ? 2 * x : -5; }
+static ValueType branchDy(ValueType x, ValueType y){ return x > y ? 0 : 2 * y; }
+
+static void checkGradient(const char* text, KnownDerivative dx, KnownDerivative dy, bool reduce){
+	PipelineVariable variables[] = {{'x', 0}, {'y', 0}};
+	PipelineVariablesSlice slice = MAKE_SLICE_FROM_CONST_PIPELINE_VARIABLES(variables);
+	PipelineVariant storage[64];
+	Pipeline pipeline = CREATE_PIPELINE_FROM_CONST_STORAGE(storage);
+	PeekableStringSlice input = {.slice = makeSliceFromString(text), .cursor = 0};
+	if(compileExpression(&pipeline, &input, slice).type != NOERROR || pipeline.errorMask != NO_ERROR){
+		printf("%s: does not compile\n", text);
+		failures++;
+		return;
+	}
+	if(reduce){
+		strengthReducePipeline(&pipeline);
+	}
+
+	PipelineStack stack;
+	initStack(&stack);
+	GradientStack gradientStack;
+	for(ValueType x = -GRADIENT_INPUT_LIMIT; x <= GRADIENT_INPUT_LIMIT; x++){
+		for(ValueType y = -GRADIENT_INPUT_LIMIT; y <= GRADIENT_INPUT_LIMIT; y++){
+			variables[0].value = x;
+			variables[1].value = y;
+			ValueType gradient[2];
+			ValueType value = executePipelineGradient(&pipeline, &gradientStack, slice, NULL, 2, gradient);
+			ValueType expected = executePipeline(&pipeline, &stack, slice);
+			if(value != expected || gradient[0] != dx(x, y) || gradient[1] != dy(x, y)){
+				printf("%s%s at x=%d y=%d: value %d d/dx %d d/dy %d, expected %d %d %d\n", text, reduce ? " reduced" : "",
+					x, y, value, gradient[0], gradient[1], expected, dx(x, y), dy(x, y));
+				failures++;
+				return;
+			}
+		}
+	}
+}
+
+// QUOTIENT
+
+// a single point far outside the grid, flagged when the quotient rule has no int32_t result
+static void checkQuotient(const char* text, ValueType x, ValueType y, ValueType dx, ValueType dy, bool derivable){
+	PipelineVariable variables[] = {{'x', x}, {'y', y}};
+	PipelineVariablesSlice slice = MAKE_SLICE_FROM_CONST_PIPELINE_VARIABLES(variables);
+	PipelineVariant storage[16];
+	Pipeline pipeline = CREATE_PIPELINE_FROM_CONST_STORAGE(storage);
+	PeekableStringSlice input = {.slice = makeSliceFromString(text), .cursor = 0};
+	if(compileExpression(&pipeline, &input, slice).type != NOERROR || pipeline.errorMask != NO_ERROR){
+		printf("%s: does not compile\n", text);
+		failures++;
+		return;
+	}
+
+	GradientStack gradientStack;
+	ValueType gradient[2];
+	ValueType value = executePipelineGradient(&pipeline, &gradientStack, slice, NULL, 2, gradient);
+	bool flagged = (gradientStack.values.errorMask & NO_DERIVATIVE) != 0;
+	if(value != x / y || gradient[0] != dx || gradient[1] != dy || flagged == derivable){
+		printf("%s at x=%d y=%d: value %d d/dx %d d/dy %d%s, expected %d %d %d%s\n", text, x, y, value, gradient[0], gradient[1],
+			flagged ? " flagged" : "", x / y, dx, dy, derivable ? "" : " flagged");
+		failures++;
+	}
+}
+
+int main(void){
+	checkGradient("x * x * y + 3 * x - y * y", cubicDx, cubicDy, false);
+	checkGradient("x * 8 + y * y * y * y - y", shiftedDx, shiftedDy, false);
+	checkGradient("x * 8 + y * y * y * y - y", shiftedDx, shiftedDy, true);
+	// only the taken branch contributes
+	checkGradient("x > y ? x * x + 1 : y * y - 5 * x", branchDx, branchDy, false);
+	checkGradient("x > y ? x * x + 1 : y * y - 5 * x", branchDx, branchDy, true);
+
+	// the squared divisor does not fit in 32 bits
+	checkQuotient("x / y", 100000, 65536, 0, 0, true);
+	checkQuotient("x / y", 100000, 46341, 0, 0, true);
+	checkQuotient("x / y", -7, -65536, 0, 0, true);
+	checkQuotient("div(x, y)", 100000, 65536, 0, 0, true);
+	// d/dy = -x is 2^31
+	checkQuotient("x / y", INT32_MIN, 1, 1, 0, false);
+
+	printf("testgradient: %s\n", failures == 0 ? "match" : "MISMATCH");
+	return failures != 0;
+}
@@ -0,0 +1,252 @@
+#include "../include/pipelineincremental.h"
+#include "../include/pipelinedefinition.h"
+
+// generated sources have to fit the text of an IncrementalExpression
+#define EXPRESSION_TEXT_CAPACITY 1024
+#include "testexpressions.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Applies random edits to random expressions with editIncrementalExpression and checks every result
+// against a full compile of the edited text: same error, and for a text that compiles the same steps
+// and the same span table.
+//   testincremental [expressions] [seed]
+
+#define INCREMENTAL_EDITS_PER_EXPRESSION 30
+#define INCREMENTAL_TEXT_CAPACITY EXPRESSION_TEXT_CAPACITY
+#define INCREMENTAL_SPAN_CAPACITY 512
+
+// EXPRESSIONS
+
+static void appendSpace(ExpressionText* expression){
+	if(nextRandom() % 4 == 0){
+		appendExpression(expression, " ", 0);
+	}
+}
+
+static void generateIncrementalExpression(ExpressionText* expression, uint8_t depth){
+	static const char* binaryOperators[] = {"+", "-", "*", "/", "%%", "<", ">=", "==", "!=", "&&", "||", "<="};
+	uint32_t kind = depth == 0 ? nextRandom() % 2 : nextRandom() % 17;
+	switch (kind)
+	{
+		case 0:
+			appendExpression(expression, "%d", (ValueType)(nextRandom() % 50));
+			return;
+		case 1:
+			appendExpression(expression, "%c", "xyz"[nextRandom() % 3]);
+			return;
+		case 2:
+			appendExpression(expression, "(", 0);
+			generateIncrementalExpression(expression, depth - 1);
+			appendSpace(expression);
+			appendExpression(expression, "?", 0);
+			generateIncrementalExpression(expression, depth - 1);
+			appendExpression(expression, ":", 0);
+			appendSpace(expression);
+			generateIncrementalExpression(expression, depth - 1);
+			appendExpression(expression, ")", 0);
+			return;
+		case 3:
+			appendExpression(expression, "sqrt(", 0);
+			generateIncrementalExpression(expression, depth - 1);
+			appendExpression(expression, ")", 0);
+			return;
+		case 4:
+			appendExpression(expression, "lerp(", 0);
+			generateIncrementalExpression(expression, depth - 1);
+			appendExpression(expression, ",", 0);
+			generateIncrementalExpression(expression, depth - 1);
+			appendExpression(expression, ", ", 0);
+			generateIncrementalExpression(expression, depth - 1);
+			appendExpression(expression, ")", 0);
+			return;
+		case 5:
+			appendExpression(expression, "sq(", 0);
+			generateIncrementalExpression(expression, depth - 1);
+			appendExpression(expression, ")", 0);
+			return;
+	}
+	bool parenthesized = nextRandom() % 3 != 0;
+	if(parenthesized){
+		appendExpression(expression, "(", 0);
+	}
+	generateIncrementalExpression(expression, depth - 1);
+	appendSpace(expression);
+	appendExpression(expression, binaryOperators[kind % ARRAY_CONST_SIZE(binaryOperators)], 0);
+	appendSpace(expression);
+	generateIncrementalExpression(expression, depth - 1);
+	if(parenthesized){
+		appendExpression(expression, ")", 0);
+	}
+}
+
+// EDITS
+
+typedef struct {
+	uint16_t offset;
+	uint16_t removed;
+	const char* inserted;
+} ExpressionEdit;
+
+static bool isStandaloneOperand(const IncrementalExpression* expression, uint16_t offset){
+	const char* text = expression->text;
+	bool operand = isdigit(text[offset]) || text[offset] == 'x' || text[offset] == 'y' || text[offset] == 'z';
+	return operand && (offset == 0 || !isalnum(text[offset - 1])) && (offset + 1 >= expression->length || !isalnum(text[offset + 1]));
+}
+
+// half of the edits replace an operand by another expression, the text keeps compiling and the edit
+// is spliced in, the other half insert and delete random fragments and mostly break the text
+static ExpressionEdit generateEdit(const IncrementalExpression* expression){
+	static const char* replacements[] = {"y", "(y+1)", "x<2", "(z?1:2)", "y&&x", "x||0", "sq(x)", "sqrt(y*y)", "(x>1&&y<3||z)", "7", "lerp(x,y,z)", " z "};
+	static const char* fragments[] = {"x", "1", "23", "+", "-", "*", "(", ")", "&&", "||", "?", ":", "<", " ", "sqrt(", "sq(", ",", "==", "z+1"};
+	if(expression->length > 0 && nextRandom() % 2 == 0){
+		for(uint8_t attempt = 0; attempt < 20; attempt++){
+			uint16_t offset = (uint16_t)(nextRandom() % expression->length);
+			if(isStandaloneOperand(expression, offset)){
+				return (ExpressionEdit){.offset = offset, .removed = 1, .inserted = replacements[nextRandom() % ARRAY_CONST_SIZE(replacements)]};
+			}
+		}
+	}
+	uint16_t offset = (uint16_t)(nextRandom() % (expression->length + 1u));
+	uint16_t removed = (uint16_t)(nextRandom() % 4);
+	if(removed > expression->length - offset){
+		removed = expression->length - offset;
+	}
+	return (ExpressionEdit){.offset = offset, .removed = removed, .inserted = nextRandom() % 4 == 0 ? "" : fragments[nextRandom() % ARRAY_CONST_SIZE(fragments)]};
+}
+
+// the parser reads digits separated by whitespace as one constant that does not convert
+static bool hasSplitConstant(const char* text, uint16_t length){
+	for(uint16_t charIdx = 0; charIdx + 1 < length; charIdx++){
+		uint16_t nextIdx = charIdx + 1;
+		while(nextIdx < length && isspace(text[nextIdx])) nextIdx++;
+		if(nextIdx > charIdx + 1 && nextIdx < length && isdigit(text[charIdx]) && isdigit(text[nextIdx])){
+			return true;
+		}
+	}
+	return false;
+}
+
+static bool isSameSteps(const Pipeline* left, const Pipeline* right){
+	if(left->index != right->index || left->errorMask != right->errorMask){
+		return false;
+	}
+	for(uint16_t pipelineIdx = 0; pipelineIdx < lengthOfPipeline(left); pipelineIdx++){
+		const PipelineVariant* leftStep = &left->entries[pipelineIdx];
+		const PipelineVariant* rightStep = &right->entries[pipelineIdx];
+		if(leftStep->type != rightStep->type){
+			return false;
+		}
+		switch (leftStep->type)
+		{
+			case CONSTANT:
+				if(leftStep->asConstant != rightStep->asConstant) return false;
+				break;
+			case VARIABLE_INDEX:
+				if(leftStep->asVariableIndex != rightStep->asVariableIndex) return false;
+				break;
+			case OPERATION:
+				if(leftStep->asOperation != rightStep->asOperation || leftStep->asOperationArgCount != rightStep->asOperationArgCount) return false;
+				break;
+			case JUMP:
+			case JUMP_IF_ZERO:
+			case JUMP_IF_ZERO_OR_POP:
+			case JUMP_IF_NONZERO_OR_POP:
+				if(leftStep->asJumpTarget != rightStep->asJumpTarget) return false;
+				break;
+			default:
+				break;
+		}
+	}
+	return true;
+}
+
+static bool isSameSpans(const PipelineSpans* left, const PipelineSpans* right){
+	if(left->count != right->count){
+		return false;
+	}
+	for(uint16_t spanIdx = 0; spanIdx < left->count; spanIdx++){
+		const PipelineSpan* leftSpan = &left->entries[spanIdx];
+		const PipelineSpan* rightSpan = &right->entries[spanIdx];
+		if(leftSpan->sourceBegin != rightSpan->sourceBegin || leftSpan->sourceEnd != rightSpan->sourceEnd || leftSpan->stepBegin != rightSpan->stepBegin
+			|| leftSpan->stepEnd != rightSpan->stepEnd || leftSpan->level != rightSpan->level || leftSpan->reserve != rightSpan->reserve){
+			return false;
+		}
+	}
+	return true;
+}
+
+int main(int argc, char** argv){
+	int expressionCount = argc > 1 ? atoi(argv[1]) : 1000;
+	randomState = argc > 2 ? (uint32_t)strtoul(argv[2], NULL, 10) : 20261019u;
+	if(expressionCount <= 0 || randomState == 0){
+		printf("usage: testincremental [expressions] [seed]\n");
+		return 1;
+	}
+
+	static PipelineDefinitions definitions;
+	static PipelineVariant fragmentStorage[64];
+	initPipelineDefinitions(&definitions, fragmentStorage, ARRAY_CONST_SIZE(fragmentStorage));
+	PeekableStringSlice definition = {.slice = MAKE_SLICE_FROM_CONST_STRING("sq(a) := a*a"), .cursor = 0, .context = NULL};
+	if(definePipelineExpression(&definitions, &definition).type != NOERROR){
+		printf("cannot define sq\n");
+		return 1;
+	}
+	PipelineVariable variables[] = {{'x', 1}, {'y', 2}, {'z', 3}};
+	PipelineVariablesSlice variablesSlice = MAKE_SLICE_FROM_CONST_PIPELINE_VARIABLES(variables);
+
+	int failures = 0;
+	uint32_t edits = 0;
+	uint32_t spliced = 0;
+	for(int expressionIdx = 0; expressionIdx < expressionCount && failures < 10; expressionIdx++){
+		ExpressionText source = {.length = 0};
+		source.text[0] = '\0';
+		generateIncrementalExpression(&source, (uint8_t)(1 + nextRandom() % 6));
+
+		static char text[INCREMENTAL_TEXT_CAPACITY];
+		static PipelineVariant storage[NONE_INDEX];
+		static PipelineSpan spanStorage[INCREMENTAL_SPAN_CAPACITY];
+		Pipeline pipeline = CREATE_PIPELINE_FROM_CONST_STORAGE(storage);
+		IncrementalExpression expression;
+		initIncrementalExpression(&expression, text, sizeof(text), &pipeline, variablesSlice, spanStorage, ARRAY_CONST_SIZE(spanStorage));
+		expression.definitions = &definitions;
+		compileIncrementalExpression(&expression, (StringSlice){source.text, source.length});
+
+		for(uint8_t editIdx = 0; editIdx < INCREMENTAL_EDITS_PER_EXPRESSION; editIdx++){
+			char before[INCREMENTAL_TEXT_CAPACITY + 1];
+			snprintf(before, sizeof(before), "%.*s", expression.length, expression.text);
+			ExpressionEdit edit = generateEdit(&expression);
+			ParsingError err = editIncrementalExpression(&expression, edit.offset, edit.removed, makeSliceFromString(edit.inserted));
+			if(err.type == TEXT_FULL || hasSplitConstant(expression.text, expression.length)){
+				compileIncrementalExpression(&expression, (StringSlice){source.text, source.length});
+				continue;
+			}
+			edits++;
+			spliced += expression.reparsedLength < expression.length;
+
+			static PipelineVariant fullStorage[NONE_INDEX];
+			static PipelineSpan fullSpanStorage[INCREMENTAL_SPAN_CAPACITY];
+			Pipeline full = CREATE_PIPELINE_FROM_CONST_STORAGE(fullStorage);
+			PipelineSpans fullSpans = {.entries = fullSpanStorage, .count = 0, .capacity = ARRAY_CONST_SIZE(fullSpanStorage), .overflowed = false, .pendingReserve = 0};
+			ParsingContext context = {.stream = NULL, .definitions = &definitions, .spans = &fullSpans};
+			PeekableStringSlice input = {.slice = {expression.text, expression.length}, .cursor = 0, .context = &context};
+			ParsingError fullErr = compileExpression(&full, &input, variablesSlice);
+
+			bool compiles = fullErr.type == NOERROR && full.errorMask == NO_ERROR;
+			if(err.type != fullErr.type || (compiles && (!isSameSteps(&pipeline, &full) || !isSameSpans(&expression.spans, &fullSpans)))){
+				printf("[%s] edit at %u removing %u inserting \"%s\" gives [%.*s]: error %d, full compile error %d\n",
+					before, edit.offset, edit.removed, edit.inserted, expression.length, expression.text, err.type, fullErr.type);
+				failures++;
+				break;
+			}
+			// broken texts mostly stay broken, start over from the generated one
+			if(!expression.compiled){
+				compileIncrementalExpression(&expression, (StringSlice){source.text, source.length});
+			}
+		}
+	}
+	printf("%u edits, %u spliced: %s\n", edits, spliced, failures == 0 ? "match" : "MISMATCH");
+	return failures != 0;
+}
@@ -0,0 +1,135 @@
+#include "../include/pipelinememo.h"
+#include "../include/expressionparser.h"
+
+#include <stdio.h>
+
+// Checks memoized results against executePipeline and the hit, miss and bypass counters on a single
+// set where the LRU order is known, on a larger cache and on pipelines not worth caching.
+//   testmemo
+
+static int failures;
+
+static PipelineVariable variables[] = {{'x', 0}, {'y', 0}, {'z', 0}, {'w', 0}, {'v', 0}};
+
+static bool compileText(Pipeline* pipeline, const char* text){
+	PeekableStringSlice input = {.slice = makeSliceFromString(text), .cursor = 0};
+	if(compileExpression(pipeline, &input, MAKE_SLICE_FROM_CONST_PIPELINE_VARIABLES(variables)).type != NOERROR || pipeline->errorMask != NO_ERROR){
+		printf("%s: does not compile\n", text);
+		failures++;
+		return false;
+	}
+	return true;
+}
+
+static void checkCounter(const char* what, uint32_t actual, uint32_t expected){
+	if(actual != expected){
+		printf("%s: %u, expected %u\n", what, actual, expected);
+		failures++;
+	}
+}
+
+static void evaluateMemo(PipelineMemo* memo, PipelineStack* stack, ValueType x, ValueType y, ValueType z){
+	variables[0].value = x;
+	variables[1].value = y;
+	variables[2].value = z;
+	PipelineVariablesSlice slice = MAKE_SLICE_FROM_CONST_PIPELINE_VARIABLES(variables);
+	ValueType result = executePipelineMemo(memo, stack, slice);
+	ValueType expected = executePipeline(memo->pipeline, stack, slice);
+	if(result != expected){
+		printf("memo at x=%d y=%d z=%d: %d, expected %d\n", x, y, z, result, expected);
+		failures++;
+	}
+}
+
+// REPLACEMENT
+
+static void checkSingleSet(void){
+	PipelineVariant storage[32];
+	Pipeline pipeline = CREATE_PIPELINE_FROM_CONST_STORAGE(storage);
+	if(!compileText(&pipeline, "(x * x + y * 3 - 7) * (x - y) + x / (y * y + 1)")){
+		return;
+	}
+	// room for exactly one set of PIPELINE_MEMO_WAYS entries
+	PipelineMemoEntry entries[PIPELINE_MEMO_WAYS];
+	PipelineMemo memo;
+	initPipelineMemo(&memo, &pipeline, entries, ARRAY_CONST_SIZE(entries));
+	PipelineStack stack;
+	initStack(&stack);
+
+	evaluateMemo(&memo, &stack, 1, 2, 0);
+	evaluateMemo(&memo, &stack, 3, 4, 0);
+	evaluateMemo(&memo, &stack, 1, 2, 0);
+	// z is not referenced and not part of the key
+	evaluateMemo(&memo, &stack, 1, 2, 99);
+	// evicts 3, 4 as the least recently used entry
+	evaluateMemo(&memo, &stack, 5, 6, 0);
+	evaluateMemo(&memo, &stack, 1, 2, 0);
+	evaluateMemo(&memo, &stack, 3, 4, 0);
+	checkCounter("single set hits", memo.hits, 3);
+	checkCounter("single set misses", memo.misses, 4);
+
+	clearPipelineMemo(&memo);
+	evaluateMemo(&memo, &stack, 3, 4, 0);
+	checkCounter("misses after clear", memo.misses, 5);
+	checkCounter("bypassed", memo.bypassed, 0);
+}
+
+static void checkLargeCache(void){
+	PipelineVariant storage[32];
+	Pipeline pipeline = CREATE_PIPELINE_FROM_CONST_STORAGE(storage);
+	if(!compileText(&pipeline, "x > y ? mod(x * 65536, 7) + y : (y - x) * (y + x) % 1000")){
+		return;
+	}
+	PipelineMemoEntry entries[256];
+	PipelineMemo memo;
+	initPipelineMemo(&memo, &pipeline, entries, ARRAY_CONST_SIZE(entries));
+	PipelineStack stack;
+	initStack(&stack);
+
+	for(uint8_t pass = 0; pass < 3; pass++){
+		for(ValueType x = -4; x <= 4; x++){
+			for(ValueType y = -4; y <= 4; y++){
+				evaluateMemo(&memo, &stack, x, y, pass);
+			}
+		}
+	}
+	checkCounter("large cache lookups", memo.hits + memo.misses, 3 * 81);
+	// 81 keys in 128 sets of two ways, collisions only cost a few repeated misses
+	if(memo.misses < 81 || memo.hits < 81){
+		printf("large cache: %u hits %u misses\n", memo.hits, memo.misses);
+		failures++;
+	}
+}
+
+// BYPASS
+
+static void checkBypass(const char* text){
+	PipelineVariant storage[32];
+	Pipeline pipeline = CREATE_PIPELINE_FROM_CONST_STORAGE(storage);
+	if(!compileText(&pipeline, text)){
+		return;
+	}
+	PipelineMemoEntry entries[16];
+	PipelineMemo memo;
+	initPipelineMemo(&memo, &pipeline, entries, ARRAY_CONST_SIZE(entries));
+	PipelineStack stack;
+	initStack(&stack);
+	evaluateMemo(&memo, &stack, 1, 2, 3);
+	evaluateMemo(&memo, &stack, 1, 2, 3);
+	if(!memo.bypass || memo.bypassed != 2 || memo.hits != 0 || memo.misses != 0){
+		printf("%s: not bypassed\n", text);
+		failures++;
+	}
+}
+
+int main(void){
+	checkSingleSet();
+	checkLargeCache();
+	// shorter than PIPELINE_MEMO_MIN_STEPS
+	checkBypass("x + y * 2");
+	// more inputs than PIPELINE_MEMO_MAX_KEYS
+	checkBypass("(x + y + z + w + v) % 9");
+
+	printf("testmemo: %s\n", failures == 0 ? "match" : "MISMATCH");
+	return failures != 0;
+}
@@ -0,0 +1,229 @@
+#include "../include/pipelineoptimizer.h"
+#include "../include/expressionparser.h"
+#include "testexpressions.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// Checks comparisons, &&, || and ?: against C. Fixed expressions are compiled from the same text C
+// evaluates so precedence and associativity have to agree, random parenthesized trees are evaluated
+// by a tree walker, both with and without jump folding.
+//   testoperators [expressions] [seed]
+
+#define OPERATORS_INPUT_LIMIT 4
+// a tree of depth 4 has at most 1 + 3 + 9 + 27 + 81 nodes
+#define OPERATORS_MAX_DEPTH 4
+#define OPERATORS_MAX_NODES 121
+
+static int failures;
+
+static PipelineVariable variables[] = {{'x', 0}, {'y', 0}};
+
+typedef ValueType (*OperatorReference)(ValueType x, ValueType y);
+
+static void checkOperators(const char* text, const Pipeline* pipeline, OperatorReference reference, const ValueType expectedGrid[]){
+	PipelineVariablesSlice slice = MAKE_SLICE_FROM_CONST_PIPELINE_VARIABLES(variables);
+	PipelineStack stack;
+	initStack(&stack);
+	uint16_t point = 0;
+	for(ValueType x = -OPERATORS_INPUT_LIMIT; x <= OPERATORS_INPUT_LIMIT; x++){
+		for(ValueType y = -OPERATORS_INPUT_LIMIT; y <= OPERATORS_INPUT_LIMIT; y++){
+			variables[0].value = x;
+			variables[1].value = y;
+			ValueType result = executePipeline(pipeline, &stack, slice);
+			ValueType expected = reference != NULL ? reference(x, y) : expectedGrid[point++];
+			if(result != expected){
+				printf("%s at x=%d y=%d: %d, C gives %d\n", text, x, y, result, expected);
+				failures++;
+				return;
+			}
+		}
+	}
+}
+
+static void checkCompiled(const char* text, OperatorReference reference, const ValueType expectedGrid[]){
+	PipelineVariant storage[NONE_INDEX];
+	Pipeline pipeline = CREATE_PIPELINE_FROM_CONST_STORAGE(storage);
+	if(!compileText(&pipeline, text, MAKE_SLICE_FROM_CONST_PIPELINE_VARIABLES(variables))){
+		printf("%s: does not compile\n", text);
+		failures++;
+		return;
+	}
+	checkOperators(text, &pipeline, reference, expectedGrid);
+	foldConstantsPipeline(&pipeline);
+	checkOperators(text, &pipeline, reference, expectedGrid);
+}
+
+// PRECEDENCE
+
+#define OPERATORS_CASE(name, expression) static ValueType name(ValueType x, ValueType y){ (void)x; (void)y; return (expression); }
+#define OPERATORS_CHECK(name, expression) checkCompiled(#expression, name, NULL)
+
+OPERATORS_CASE(relationalOverEquality, x < y == y > x)
+OPERATORS_CASE(equalityOverAnd, x == 1 && y != 2)
+OPERATORS_CASE(andOverOr, x || y && 0)
+OPERATORS_CASE(orOverConditional, x || y ? x - y : 7)
+OPERATORS_CASE(rightAssociativeConditional, x > 0 ? y : x < 0 ? -1 : y * 3)
+OPERATORS_CASE(nestedConditional, x ? y ? 1 : 2 : 3)
+OPERATORS_CASE(arithmeticOverRelational, x + 2 * y <= y - x % 3)
+OPERATORS_CASE(leftAssociative, x - y - 3 < 100 / 7 / 3 - y)
+OPERATORS_CASE(chainedAnd, x && y && x - y && 5)
+OPERATORS_CASE(chainedOr, x || y || x - y || 0)
+OPERATORS_CASE(mixedLogical, x > 1 && y < 2 || x == y && y || 0 && x)
+OPERATORS_CASE(logicalOperands, (x && y) + (x || y) * 4 - (x ? 0 : 5))
+OPERATORS_CASE(constantConditions, 1 ? x : y + (0 && x) + (3 || y) + (0 ? 9 : 2))
+
+static void checkPrecedence(void){
+	OPERATORS_CHECK(relationalOverEquality, x < y == y > x);
+	OPERATORS_CHECK(equalityOverAnd, x == 1 && y != 2);
+	OPERATORS_CHECK(andOverOr, x || y && 0);
+	OPERATORS_CHECK(orOverConditional, x || y ? x - y : 7);
+	OPERATORS_CHECK(rightAssociativeConditional, x > 0 ? y : x < 0 ? -1 : y * 3);
+	OPERATORS_CHECK(nestedConditional, x ? y ? 1 : 2 : 3);
+	OPERATORS_CHECK(arithmeticOverRelational, x + 2 * y <= y - x % 3);
+	OPERATORS_CHECK(leftAssociative, x - y - 3 < 100 / 7 / 3 - y);
+	OPERATORS_CHECK(chainedAnd, x && y && x - y && 5);
+	OPERATORS_CHECK(chainedOr, x || y || x - y || 0);
+	OPERATORS_CHECK(mixedLogical, x > 1 && y < 2 || x == y && y || 0 && x);
+	OPERATORS_CHECK(logicalOperands, (x && y) + (x || y) * 4 - (x ? 0 : 5));
+	OPERATORS_CHECK(constantConditions, 1 ? x : y + (0 && x) + (3 || y) + (0 ? 9 : 2));
+}
+
+// RANDOM TREES
+
+typedef struct {
+	char operator;
+	ValueType value;
+	uint8_t children[3];
+} OperatorNode;
+
+typedef struct {
+	OperatorNode nodes[OPERATORS_MAX_NODES];
+	uint8_t count;
+	char text[2048];
+	size_t length;
+} OperatorTree;
+
+static void appendText(OperatorTree* tree, const char* format, ValueType value){
+	int written = snprintf(tree->text + tree->length, sizeof(tree->text) - tree->length, format, value);
+	if(written > 0 && tree->length + (size_t)written < sizeof(tree->text)){
+		tree->length += (size_t)written;
+	}
+}
+
+// '0' is a constant, 'x' and 'y' variables, '?' the conditional, 'A' && and 'O' ||, 'l' <=, 'g' >=,
+// 'e' ==, 'n' != and the rest their C operator, divisors are constants from 2 to 10
+static uint8_t generateTree(OperatorTree* tree, uint8_t depth){
+	static const char operators[] = "+-*/%<>lgenAOAO??";
+	uint8_t nodeIdx = tree->count++;
+	OperatorNode* node = &tree->nodes[nodeIdx];
+	if(depth == 0){
+		uint32_t leaf = nextRandom() % 3;
+		node->operator = "0xy"[leaf];
+		node->value = (ValueType)(nextRandom() % 7) - 3;
+		return nodeIdx;
+	}
+	node->operator = operators[nextRandom() % (sizeof(operators) - 1)];
+	node->value = (ValueType)(nextRandom() % 9) + 2;
+	for(uint8_t child = 0; child < (node->operator == '?' ? 3 : 2); child++){
+		uint8_t childIdx = generateTree(tree, depth - 1);
+		tree->nodes[nodeIdx].children[child] = childIdx;
+	}
+	return nodeIdx;
+}
+
+static void printTree(OperatorTree* tree, uint8_t nodeIdx){
+	static const char* const spelled[] = {"l<=", "g>=", "e==", "n!=", "A&&", "O||"};
+	const OperatorNode* node = &tree->nodes[nodeIdx];
+	switch (node->operator)
+	{
+		case '0':
+			appendText(tree, node->value < 0 ? "(%d)" : "%d", node->value);
+			return;
+		case 'x':
+		case 'y':
+			appendText(tree, node->operator == 'x' ? "x" : "y", 0);
+			return;
+		case '?':
+			appendText(tree, "(", 0);
+			printTree(tree, node->children[0]);
+			appendText(tree, "?", 0);
+			printTree(tree, node->children[1]);
+			appendText(tree, ":", 0);
+			printTree(tree, node->children[2]);
+			appendText(tree, ")", 0);
+			return;
+		case '/':
+		case '%':
+			appendText(tree, "(", 0);
+			printTree(tree, node->children[0]);
+			appendText(tree, node->operator == '/' ? "/%d)" : "%%%d)", node->value);
+			return;
+	}
+	appendText(tree, "(", 0);
+	printTree(tree, node->children[0]);
+	const char* text = NULL;
+	for(uint8_t idx = 0; idx < ARRAY_CONST_SIZE(spelled); idx++){
+		if(spelled[idx][0] == node->operator){
+			text = &spelled[idx][1];
+		}
+	}
+	char single[2] = {node->operator, '\0'};
+	appendText(tree, text != NULL ? text : single, 0);
+	printTree(tree, node->children[1]);
+	appendText(tree, ")", 0);
+}
+
+// + - * wrap around like the executor does on the targets
+static ValueType evaluateTree(const OperatorTree* tree, uint8_t nodeIdx, ValueType x, ValueType y){
+	const OperatorNode* node = &tree->nodes[nodeIdx];
+	switch (node->operator)
+	{
+		case '0': return node->value;
+		case 'x': return x;
+		case 'y': return y;
+		case '?': return evaluateTree(tree, node->children[0], x, y) ? evaluateTree(tree, node->children[1], x, y) : evaluateTree(tree, node->children[2], x, y);
+		case 'A': return evaluateTree(tree, node->children[0], x, y) && evaluateTree(tree, node->children[1], x, y);
+		case 'O': return evaluateTree(tree, node->children[0], x, y) || evaluateTree(tree, node->children[1], x, y);
+		case '/': return evaluateTree(tree, node->children[0], x, y) / node->value;
+		case '%': return evaluateTree(tree, node->children[0], x, y) % node->value;
+	}
+	ValueType left = evaluateTree(tree, node->children[0], x, y);
+	ValueType right = evaluateTree(tree, node->children[1], x, y);
+	switch (node->operator)
+	{
+		case '+': return (ValueType)((uint32_t)left + (uint32_t)right);
+		case '-': return (ValueType)((uint32_t)left - (uint32_t)right);
+		case '*': return (ValueType)((uint32_t)left * (uint32_t)right);
+		case '<': return left < right;
+		case '>': return left > right;
+		case 'l': return left <= right;
+		case 'g': return left >= right;
+		case 'e': return left == right;
+		default: return left != right;
+	}
+}
+
+int main(int argc, char** argv){
+	uint32_t expressionCount = argc > 1 ? (uint32_t)atoi(argv[1]) : 5000;
+	randomState = argc > 2 ? (uint32_t)atoi(argv[2]) : 0x13579BD;
+
+	checkPrecedence();
+
+	for(uint32_t expressionIdx = 0; expressionIdx < expressionCount && failures == 0; expressionIdx++){
+		OperatorTree tree = {.count = 0, .length = 0};
+		generateTree(&tree, (uint8_t)(nextRandom() % OPERATORS_MAX_DEPTH) + 1);
+		printTree(&tree, 0);
+		ValueType expectedGrid[(2 * OPERATORS_INPUT_LIMIT + 1) * (2 * OPERATORS_INPUT_LIMIT + 1)];
+		uint16_t point = 0;
+		for(ValueType x = -OPERATORS_INPUT_LIMIT; x <= OPERATORS_INPUT_LIMIT; x++){
+			for(ValueType y = -OPERATORS_INPUT_LIMIT; y <= OPERATORS_INPUT_LIMIT; y++){
+				expectedGrid[point++] = evaluateTree(&tree, 0, x, y);
+			}
+		}
+		checkCompiled(tree.text, NULL, expectedGrid);
+	}
+
+	printf("testoperators: %s\n", failures == 0 ? "match" : "MISMATCH");
+	return failures != 0;
+}
@@ -0,0 +1,192 @@
+#include "../include/pipelineoptimizer.h"
+#include "../include/expressionparser.h"
+#include "testexpressions.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// Checks folding and specialization against the unoptimized pipeline on random expressions and a grid
+// of inputs, and the shape of their output on fixed expressions.
+//   testoptimizer [expressions] [seed]
+
+#define OPTIMIZER_INPUT_LIMIT 3
+
+static int failures;
+
+// k is the variable the checks make constant
+static const ExpressionShape shape = {.variables = "xyk", .constantLow = -1, .constantSpread = 5, .wideSpread = 0, .conditionals = true, .operations = false};
+
+static bool hasJumps(const Pipeline* pipeline){
+	for(uint16_t pipelineIdx = 0; pipelineIdx < lengthOfPipeline(pipeline); pipelineIdx++){
+		if(isJumpStep(&pipeline->entries[pipelineIdx])){
+			return true;
+		}
+	}
+	return false;
+}
+
+// FOLDING
+
+// folding with every variable unknown, and with k substituted as a constant, keeps every result
+static void checkFolding(const char* text, const Pipeline* pipeline){
+	PipelineVariable variables[] = {{'x', 0}, {'y', 0}, {'k', 0}};
+	PipelineVariablesSlice slice = MAKE_SLICE_FROM_CONST_PIPELINE_VARIABLES(variables);
+	PipelineStack stack;
+	initStack(&stack);
+	PipelineVariant foldedStorage[NONE_INDEX];
+	Pipeline folded = CREATE_PIPELINE_FROM_CONST_STORAGE(foldedStorage);
+	copyPipeline(pipeline, &folded);
+	foldConstantsPipeline(&folded);
+
+	for(ValueType k = -1; k < OPTIMIZER_INPUT_LIMIT; k++){
+		PipelineVariant substitutedStorage[NONE_INDEX];
+		Pipeline substituted = CREATE_PIPELINE_FROM_CONST_STORAGE(substitutedStorage);
+		for(uint16_t pipelineIdx = 0; pipelineIdx < lengthOfPipeline(pipeline); pipelineIdx++){
+			const PipelineVariant* variant = &pipeline->entries[pipelineIdx];
+			pushPipeline(&substituted, variant->type == VARIABLE_INDEX && variant->asVariableIndex == 2 ? makeStepAsConstant(k) : *variant);
+		}
+		foldConstantsPipeline(&substituted);
+
+		variables[2].value = k;
+		for(ValueType x = -1; x < OPTIMIZER_INPUT_LIMIT; x++){
+			for(ValueType y = -1; y < OPTIMIZER_INPUT_LIMIT; y++){
+				variables[0].value = x;
+				variables[1].value = y;
+				ValueType expected = executePipeline(pipeline, &stack, slice);
+				ValueType foldedResult = executePipeline(&folded, &stack, slice);
+				ValueType substitutedResult = executePipeline(&substituted, &stack, slice);
+				if((foldedResult != expected || substitutedResult != expected) && failures++ < 10){
+					printf("%s with x=%d y=%d k=%d: %d, folded %d, folded with constant k %d\n", text, x, y, k, expected, foldedResult, substitutedResult);
+					return;
+				}
+			}
+		}
+	}
+}
+
+// SPECIALIZATION
+
+// k known, the specialized pipeline over the remaining variables gives the results of the source
+static void checkSpecialized(const char* text, const Pipeline* pipeline){
+	PipelineVariable variables[] = {{'x', 0}, {'y', 0}, {'k', 0}};
+	PipelineVariablesSlice slice = MAKE_SLICE_FROM_CONST_PIPELINE_VARIABLES(variables);
+	const bool known[] = {false, false, true};
+	PipelineStack stack;
+	initStack(&stack);
+	for(ValueType k = -1; k < OPTIMIZER_INPUT_LIMIT; k++){
+		variables[2].value = k;
+		PipelineVariant specializedStorage[NONE_INDEX];
+		Pipeline specialized = CREATE_PIPELINE_FROM_CONST_STORAGE(specializedStorage);
+		PipelineVariable remaining[ARRAY_CONST_SIZE(variables)];
+		int8_t remainingLen = specializePipeline(pipeline, &specialized, slice, known, remaining);
+		for(int8_t varIdx = 0; varIdx < remainingLen; varIdx++){
+			if(remaining[varIdx].name == 'k' && failures++ < 10){
+				printf("%s with k=%d: k remains\n", text, k);
+				return;
+			}
+		}
+		for(ValueType x = -1; x < OPTIMIZER_INPUT_LIMIT; x++){
+			for(ValueType y = -1; y < OPTIMIZER_INPUT_LIMIT; y++){
+				variables[0].value = x;
+				variables[1].value = y;
+				for(int8_t varIdx = 0; varIdx < remainingLen; varIdx++){
+					remaining[varIdx].value = remaining[varIdx].name == 'x' ? x : y;
+				}
+				ValueType expected = executePipeline(pipeline, &stack, slice);
+				ValueType result = executePipeline(&specialized, &stack, (PipelineVariablesSlice){remaining, remainingLen});
+				if(result != expected && failures++ < 10){
+					printf("%s with x=%d y=%d k=%d: %d, specialized %d\n", text, x, y, k, expected, result);
+					return;
+				}
+			}
+		}
+	}
+}
+
+// a target too small for the copy is reported apart from a result without variables
+static void checkSpecializedTarget(void){
+	PipelineVariable variables[] = {{'x', 2}, {'y', 3}, {'k', 4}};
+	PipelineVariablesSlice slice = MAKE_SLICE_FROM_CONST_PIPELINE_VARIABLES(variables);
+	const bool known[] = {true, false, true};
+	PipelineVariant storage[16];
+	Pipeline pipeline = CREATE_PIPELINE_FROM_CONST_STORAGE(storage);
+	PipelineVariable remaining[ARRAY_CONST_SIZE(variables)];
+	if(!compileText(&pipeline, "x * k + 1", slice)){
+		failures++;
+		return;
+	}
+	PipelineVariant targetStorage[16];
+	Pipeline target = CREATE_PIPELINE_FROM_CONST_STORAGE(targetStorage);
+	PipelineVariant smallStorage[2];
+	Pipeline small = CREATE_PIPELINE_FROM_CONST_STORAGE(smallStorage);
+	int8_t constantLen = specializePipeline(&pipeline, &target, slice, known, remaining);
+	int8_t smallLen = specializePipeline(&pipeline, &small, slice, known, remaining);
+	if(constantLen != 0 || lengthOfPipeline(&target) != 1 || target.entries[0].asConstant != 9 || smallLen != -1){
+		printf("x * k + 1 specialized: %d remaining, into 2 steps: %d\n", constantLen, smallLen);
+		failures++;
+	}
+}
+
+// a constant condition leaves only the taken branch, steps and jumps of the other one are gone
+static void checkConstantCondition(const char* text, ValueType k, const char* reducedText){
+	PipelineVariable variables[] = {{'x', 0}, {'y', 0}, {'k', k}};
+	PipelineVariablesSlice slice = MAKE_SLICE_FROM_CONST_PIPELINE_VARIABLES(variables);
+	PipelineVariant storage[NONE_INDEX];
+	PipelineVariant reducedStorage[NONE_INDEX];
+	Pipeline pipeline = CREATE_PIPELINE_FROM_CONST_STORAGE(storage);
+	Pipeline reduced = CREATE_PIPELINE_FROM_CONST_STORAGE(reducedStorage);
+	if(!compileText(&pipeline, text, slice) || !compileText(&reduced, reducedText, slice)){
+		printf("%s: does not compile\n", text);
+		failures++;
+		return;
+	}
+	for(uint16_t pipelineIdx = 0; pipelineIdx < lengthOfPipeline(&pipeline); pipelineIdx++){
+		PipelineVariant* variant = &pipeline.entries[pipelineIdx];
+		if(variant->type == VARIABLE_INDEX && variant->asVariableIndex == 2){
+			*variant = makeStepAsConstant(k);
+		}
+	}
+	foldConstantsPipeline(&pipeline);
+	foldConstantsPipeline(&reduced);
+	if(hasJumps(&pipeline) || lengthOfPipeline(&pipeline) != lengthOfPipeline(&reduced)){
+		printf("%s with k=%d: %u steps%s, expected the %u of %s\n", text, k, lengthOfPipeline(&pipeline), hasJumps(&pipeline) ? " with jumps" : "", lengthOfPipeline(&reduced), reducedText);
+		failures++;
+	}
+}
+
+int main(int argc, char** argv){
+	int expressionCount = argc > 1 ? atoi(argv[1]) : 20000;
+	randomState = argc > 2 ? (uint32_t)strtoul(argv[2], NULL, 10) : 20261019u;
+	if(expressionCount <= 0 || randomState == 0){
+		printf("usage: testoptimizer [expressions] [seed]\n");
+		return 1;
+	}
+
+	checkConstantCondition("k > 0 ? x*3 : x/2", 1, "x*3");
+	checkConstantCondition("k > 0 ? x*3 : x/2", 0, "x/2");
+	checkConstantCondition("k && x > y", 1, "x > y");
+	checkConstantCondition("k && x > y", 0, "0");
+	checkConstantCondition("k || x > y", 5, "1");
+	checkConstantCondition("k || x > y", 0, "x > y");
+	checkConstantCondition("(k ? x : y) + (k - 1 ? y : 7)", 1, "x + 7");
+	checkConstantCondition("x + (k < 2 ? (k ? y : 3) * 2 : k)", 0, "x + 6");
+	checkSpecializedTarget();
+
+	PipelineVariable variables[] = {{'x', 0}, {'y', 0}, {'k', 0}};
+	int checked = 0;
+	for(int expressionIdx = 0; expressionIdx < expressionCount && failures < 10; expressionIdx++){
+		ExpressionText expression = {.length = 0};
+		expression.text[0] = '\0';
+		generateExpression(&expression, &shape, (uint8_t)(1 + nextRandom() % 5));
+		PipelineVariant storage[NONE_INDEX];
+		Pipeline pipeline = CREATE_PIPELINE_FROM_CONST_STORAGE(storage);
+		if(!compileText(&pipeline, expression.text, MAKE_SLICE_FROM_CONST_PIPELINE_VARIABLES(variables))){
+			continue;
+		}
+		checkFolding(expression.text, &pipeline);
+		checkSpecialized(expression.text, &pipeline);
+		checked++;
+	}
+	printf("testoptimizer: %d expressions: %s\n", checked, failures == 0 ? "match" : "MISMATCH");
+	return failures != 0;
+}
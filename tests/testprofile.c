@@ -0,0 +1,80 @@
+#include "../include/pipelineprofile.h"
+#include "../include/expressionparser.h"
+
+#include <stdio.h>
+#include <string.h>
+
+// Checks the profiling counters and dump of a straight line pipeline evaluated a known number of times.
+//   testprofile, built with -DPIPELINE_PROFILING
+
+#define EVALUATIONS 10
+
+static int failures;
+static bool dumpedOperation;
+static bool dumpedEvaluations;
+
+static void checkCount(const char* what, uint32_t actual, uint32_t expected){
+	if(actual != expected){
+		printf("%s: %u, expected %u\n", what, actual, expected);
+		failures++;
+	}
+}
+
+static void captureLine(const char* line){
+	char expected[96];
+	snprintf(expected, sizeof(expected), "  %-12s calls %10lu", "mod", (unsigned long)EVALUATIONS);
+	dumpedOperation |= strcmp(line, expected) == 0;
+	snprintf(expected, sizeof(expected), " evaluations %10lu ", (unsigned long)EVALUATIONS);
+	dumpedEvaluations |= strstr(line, expected) != NULL;
+}
+
+int main(void){
+	const char* text = "mod(x * x + y, 5) / 3 + x";
+	PipelineVariable variables[] = {{'x', 0}, {'y', 7}};
+	PipelineVariablesSlice slice = MAKE_SLICE_FROM_CONST_PIPELINE_VARIABLES(variables);
+	PipelineVariant storage[32];
+	Pipeline pipeline = CREATE_PIPELINE_FROM_CONST_STORAGE(storage);
+	PeekableStringSlice input = {.slice = makeSliceFromString(text), .cursor = 0};
+	if(compileExpression(&pipeline, &input, slice).type != NOERROR || pipeline.errorMask != NO_ERROR){
+		printf("%s: does not compile\n", text);
+		return 1;
+	}
+
+	PipelineStack stack;
+	initStack(&stack);
+	resetPipelineProfile();
+	for(ValueType x = 0; x < EVALUATIONS; x++){
+		variables[0].value = x;
+		executePipeline(&pipeline, &stack, slice);
+	}
+
+	// without jumps every step runs once per evaluation
+	uint32_t stepsPerEvaluation[PIPELINE_VARIANT_TYPE_COUNT] = {0};
+	for(Index idx = 0; idx <= pipeline.index; idx++){
+		stepsPerEvaluation[pipeline.entries[idx].type]++;
+	}
+	for(uint8_t type = 0; type < PIPELINE_VARIANT_TYPE_COUNT; type++){
+		char what[32];
+		snprintf(what, sizeof(what), "step type %u count", type);
+		checkCount(what, pipelineProfile.steps[type].count, stepsPerEvaluation[type] * EVALUATIONS);
+	}
+	checkCount("operations", pipelineProfile.operationCount, 1);
+	checkCount("mod calls", pipelineProfile.operations[0].calls, EVALUATIONS);
+	checkCount("pipelines", pipelineProfile.pipelineCount, 1);
+	checkCount("evaluations", pipelineProfile.pipelines[0].evaluations, EVALUATIONS);
+	// x x and x*x+y 5 are the deepest points, above the dummy slot of the empty stack
+	checkCount("max stack depth", pipelineProfile.maxStackDepth, 2);
+	checkCount("dropped events", pipelineProfile.droppedEvents, 0);
+
+	dumpPipelineProfile(captureLine);
+	if(!dumpedOperation || !dumpedEvaluations){
+		printf("dump misses the mod calls or the evaluation count\n");
+		failures++;
+	}
+
+	resetPipelineProfile();
+	checkCount("evaluations after reset", pipelineProfile.pipelineCount, 0);
+
+	printf("testprofile: %s\n", failures == 0 ? "match" : "MISMATCH");
+	return failures != 0;
+}
@@ -0,0 +1,125 @@
+#include "../include/pipelinerange.h"
+#include "../include/expressionparser.h"
+#include "testexpressions.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// Checks that analyzePipelineRanges bounds every value a step pushes on random expressions over a grid
+// inside the declared ranges, that narrowed pipelines compute the 32 bit results, and the fault flags
+// of fixed divisions.
+//   testrange [expressions] [seed]
+
+#define RANGE_INPUT_LIMIT 4
+
+static int failures;
+
+static PipelineVariable variables[] = {{'x', 0}, {'y', 0}, {'k', 0}};
+static const ValueRange variableRanges[] = {{-RANGE_INPUT_LIMIT, RANGE_INPUT_LIMIT}, {-RANGE_INPUT_LIMIT, RANGE_INPUT_LIMIT}, {-40000, 40000}};
+static const ValueType kValues[] = {-40000, -1000, -1, 0, 3, 999, 40000};
+
+// straight line expressions have no ?:, && or ||
+static const ExpressionShape straightShape = {.variables = "xyk", .constantLow = -3, .constantSpread = 7, .wideSpread = 700, .conditionals = false, .operations = true};
+static const ExpressionShape conditionalShape = {.variables = "xyk", .constantLow = -3, .constantSpread = 7, .wideSpread = 700, .conditionals = true, .operations = true};
+
+static bool isInRange(ValueRange range, ValueType value){
+	return range.low <= value && value <= range.high;
+}
+
+// straight line pipelines are checked at every prefix, each one leaves the value its last step pushed
+static void checkRanges(const char* text, const Pipeline* pipeline, bool straight){
+	PipelineVariablesSlice slice = MAKE_SLICE_FROM_CONST_PIPELINE_VARIABLES(variables);
+	StepRange steps[NONE_INDEX];
+	if(!analyzePipelineRanges(pipeline, variableRanges, ARRAY_CONST_SIZE(variableRanges), steps)){
+		printf("%s: not analyzed\n", text);
+		failures++;
+		return;
+	}
+	PipelineVariant narrowedStorage[NONE_INDEX];
+	Pipeline narrowed = CREATE_PIPELINE_FROM_CONST_STORAGE(narrowedStorage);
+	for(uint16_t pipelineIdx = 0; pipelineIdx < lengthOfPipeline(pipeline); pipelineIdx++){
+		pushPipeline(&narrowed, pipeline->entries[pipelineIdx]);
+	}
+	narrowPipeline(&narrowed, steps);
+
+	PipelineStack stack;
+	initStack(&stack);
+	for(ValueType x = -RANGE_INPUT_LIMIT; x <= RANGE_INPUT_LIMIT; x++){
+		for(ValueType y = -RANGE_INPUT_LIMIT; y <= RANGE_INPUT_LIMIT; y++){
+			for(uint8_t kIdx = 0; kIdx < ARRAY_CONST_SIZE(kValues); kIdx++){
+				variables[0].value = x;
+				variables[1].value = y;
+				variables[2].value = kValues[kIdx];
+				ValueType expected = executePipeline(pipeline, &stack, slice);
+				ValueType result = executePipeline(&narrowed, &stack, slice);
+				if(result != expected || !isInRange(steps[pipeline->index].result, expected)){
+					printf("%s at x=%d y=%d k=%d: %d narrowed %d, range [%d, %d]\n", text, x, y, kValues[kIdx], expected, result,
+						steps[pipeline->index].result.low, steps[pipeline->index].result.high);
+					failures++;
+					return;
+				}
+				for(Index prefixIdx = 0; straight && prefixIdx < pipeline->index; prefixIdx++){
+					Pipeline prefix = *pipeline;
+					prefix.index = prefixIdx;
+					ValueType value = executePipeline(&prefix, &stack, slice);
+					if(!isInRange(steps[prefixIdx].result, value)){
+						printf("%s at x=%d y=%d k=%d: step %u pushed %d outside [%d, %d]\n", text, x, y, kValues[kIdx], prefixIdx, value,
+							steps[prefixIdx].result.low, steps[prefixIdx].result.high);
+						failures++;
+						return;
+					}
+				}
+			}
+		}
+	}
+}
+
+static void checkDivisionFault(const char* text, bool faultFree, bool narrow){
+	PipelineVariant storage[32];
+	Pipeline pipeline = CREATE_PIPELINE_FROM_CONST_STORAGE(storage);
+	StepRange steps[32];
+	if(!compileText(&pipeline, text, MAKE_SLICE_FROM_CONST_PIPELINE_VARIABLES(variables)) || !analyzePipelineRanges(&pipeline, variableRanges, ARRAY_CONST_SIZE(variableRanges), steps)){
+		printf("%s: not analyzed\n", text);
+		failures++;
+		return;
+	}
+	const StepRange* division = &steps[pipeline.index];
+	narrowPipeline(&pipeline, steps);
+	PipelineVariantType narrowedType = pipeline.entries[pipeline.index].type;
+	bool narrowed = narrowedType == OPERATION_NATIVE_DIV16 || narrowedType == OPERATION_NATIVE_MOD16;
+	if(((division->flags & RANGE_NO_DIVISION_FAULT) != 0) != faultFree || narrowed != narrow){
+		printf("%s: flags %x, expected %s and a %s division\n", text, division->flags, faultFree ? "fault free" : "a possible fault", narrow ? "16 bit" : "32 bit");
+		failures++;
+	}
+}
+
+int main(int argc, char** argv){
+	uint32_t expressionCount = argc > 1 ? (uint32_t)atoi(argv[1]) : 3000;
+	randomState = argc > 2 ? (uint32_t)atoi(argv[2]) : 0x2468ACE;
+
+	checkDivisionFault("k / (y + 5)", true, false);
+	// interval arithmetic does not know that x * x is never negative
+	checkDivisionFault("k / (x * x + 1)", false, false);
+	checkDivisionFault("k / y", false, false);
+	checkDivisionFault("x * 100 / (y + 5)", true, true);
+	checkDivisionFault("(k * 60000) % 7", true, false);
+	checkDivisionFault("(y + 4) % (x - 5)", true, true);
+
+	for(uint32_t expressionIdx = 0; expressionIdx < expressionCount && failures == 0; expressionIdx++){
+		bool straight = expressionIdx % 2 == 0;
+		ExpressionText expression = {.length = 0};
+		generateExpression(&expression, straight ? &straightShape : &conditionalShape, (uint8_t)(nextRandom() % 4) + 1);
+		// a step only reports its own value, the join of the branches shows in the step after the merge
+		if(!straight){
+			appendExpression(&expression, "+0", 0);
+		}
+		PipelineVariant storage[NONE_INDEX];
+		Pipeline pipeline = CREATE_PIPELINE_FROM_CONST_STORAGE(storage);
+		if(compileText(&pipeline, expression.text, MAKE_SLICE_FROM_CONST_PIPELINE_VARIABLES(variables))){
+			checkRanges(expression.text, &pipeline, straight);
+		}
+	}
+
+	printf("testrange: %s\n", failures == 0 ? "match" : "MISMATCH");
+	return failures != 0;
+}
@@ -0,0 +1,91 @@
+#include "../include/pipelineoptimizer.h"
+#include "../include/expressionparser.h"
+#include "testexpressions.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// Checks reorderPipelineOperands on fixed expressions with a known stack depth before and after, and on
+// random expressions that it keeps every result and never deepens the stack.
+//   testreorder [expressions] [seed]
+
+#define REORDER_INPUT_LIMIT 4
+
+static int failures;
+
+static PipelineVariable variables[] = {{'x', 0}, {'y', 0}, {'z', 0}, {'w', 0}, {'v', 0}};
+
+static const ExpressionShape shape = {.variables = "xyz", .constantLow = -3, .constantSpread = 7, .wideSpread = 0, .conditionals = true, .operations = true};
+
+static void checkReordered(const char* text, const Pipeline* pipeline){
+	PipelineVariablesSlice slice = MAKE_SLICE_FROM_CONST_PIPELINE_VARIABLES(variables);
+	PipelineVariant reorderedStorage[NONE_INDEX];
+	Pipeline reordered = CREATE_PIPELINE_FROM_CONST_STORAGE(reorderedStorage);
+	copyPipeline(pipeline, &reordered);
+	uint8_t depth = reorderPipelineOperands(&reordered);
+	if(depth != getPipelineMaxStackDepth(&reordered) || depth > getPipelineMaxStackDepth(pipeline)){
+		printf("%s: reordered to depth %u from %u\n", text, depth, getPipelineMaxStackDepth(pipeline));
+		failures++;
+		return;
+	}
+
+	PipelineStack stack;
+	initStack(&stack);
+	for(ValueType x = -REORDER_INPUT_LIMIT; x <= REORDER_INPUT_LIMIT; x++){
+		for(ValueType y = -REORDER_INPUT_LIMIT; y <= REORDER_INPUT_LIMIT; y++){
+			variables[0].value = x;
+			variables[1].value = y;
+			variables[2].value = x - y;
+			ValueType expected = executePipeline(pipeline, &stack, slice);
+			ValueType result = executePipeline(&reordered, &stack, slice);
+			if(result != expected){
+				printf("%s at x=%d y=%d: reordered %d, original %d\n", text, x, y, result, expected);
+				failures++;
+				return;
+			}
+		}
+	}
+}
+
+static void checkDepth(const char* text, uint8_t before, uint8_t after){
+	PipelineVariant storage[NONE_INDEX];
+	Pipeline pipeline = CREATE_PIPELINE_FROM_CONST_STORAGE(storage);
+	if(!compileText(&pipeline, text, MAKE_SLICE_FROM_CONST_PIPELINE_VARIABLES(variables))){
+		printf("%s: does not compile\n", text);
+		failures++;
+		return;
+	}
+	checkReordered(text, &pipeline);
+	uint8_t original = getPipelineMaxStackDepth(&pipeline);
+	uint8_t reordered = reorderPipelineOperands(&pipeline);
+	if(original != before || reordered != after){
+		printf("%s: depth %u to %u, expected %u to %u\n", text, original, reordered, before, after);
+		failures++;
+	}
+}
+
+int main(int argc, char** argv){
+	uint32_t expressionCount = argc > 1 ? (uint32_t)atoi(argv[1]) : 5000;
+	randomState = argc > 2 ? (uint32_t)atoi(argv[2]) : 0x7654321;
+
+	checkDepth("x+(y*(z+(w*v)))", 5, 2);
+	checkDepth("x-(y-(z-(w-v)))", 5, 2);
+	checkDepth("x/(y*y+1)-(z<(w+v))", 4, 3);
+	checkDepth("(x+y)*(z+w)", 3, 3);
+	checkDepth("x*2+y*3", 3, 3);
+	// each branch is reordered on its own
+	checkDepth("x>0?y+(z*(w+v)):v", 4, 2);
+
+	for(uint32_t expressionIdx = 0; expressionIdx < expressionCount && failures == 0; expressionIdx++){
+		ExpressionText expression = {.length = 0};
+		generateExpression(&expression, &shape, (uint8_t)(nextRandom() % 5) + 1);
+		PipelineVariant storage[NONE_INDEX];
+		Pipeline pipeline = CREATE_PIPELINE_FROM_CONST_STORAGE(storage);
+		if(compileText(&pipeline, expression.text, MAKE_SLICE_FROM_CONST_PIPELINE_VARIABLES(variables))){
+			checkReordered(expression.text, &pipeline);
+		}
+	}
+
+	printf("testreorder: %s\n", failures == 0 ? "match" : "MISMATCH");
+	return failures != 0;
+}
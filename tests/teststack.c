@@ -0,0 +1,154 @@
+#include "../include/pipelineoptimizer.h"
+#include "../include/expressionparser.h"
+#include "testexpressions.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// Checks the top of stack cached executePipeline against a reference interpreter that keeps every
+// value on a PipelineStack, on random expressions with jumps and multi argument operations, before and
+// after strength reduction, and that every evaluation leaves the stack balanced.
+//   teststack [expressions] [seed]
+
+#define STACK_INPUT_LIMIT 4
+
+static int failures;
+
+static const ExpressionShape shape = {.variables = "xy", .constantLow = -3, .constantSpread = 7, .wideSpread = 0, .conditionals = true, .operations = true};
+
+// REFERENCE
+
+static ValueType applyBinary(PipelineVariantType type, ValueType left, ValueType right, const ConstantDivisor* divisor){
+	switch (type)
+	{
+		case OPERATION_NATIVE_ADD: return left + right;
+		case OPERATION_NATIVE_SUB: return left - right;
+		case OPERATION_NATIVE_MUL: return left * right;
+		case OPERATION_NATIVE_DIV: return left / right;
+		case OPERATION_NATIVE_MOD: return left % right;
+		case OPERATION_NATIVE_RSUB: return right - left;
+		case OPERATION_NATIVE_RDIV: return right / left;
+		case OPERATION_NATIVE_RMOD: return right % left;
+		case OPERATION_NATIVE_ADD16: return (int16_t)left + (int16_t)right;
+		case OPERATION_NATIVE_SUB16: return (int16_t)left - (int16_t)right;
+		case OPERATION_NATIVE_MUL16: return (int16_t)left * (int16_t)right;
+		case OPERATION_NATIVE_DIV16: return (int16_t)left / (int16_t)right;
+		case OPERATION_NATIVE_MOD16: return (int16_t)left % (int16_t)right;
+		case OPERATION_NATIVE_DIV_MAGIC: return divideByMagicConstant(left, right, divisor);
+		case OPERATION_NATIVE_MOD_MAGIC: return moduloByMagicConstant(left, right, divisor);
+		case OPERATION_NATIVE_LT: return left < right;
+		case OPERATION_NATIVE_LE: return left <= right;
+		case OPERATION_NATIVE_GT: return left > right;
+		case OPERATION_NATIVE_GE: return left >= right;
+		case OPERATION_NATIVE_EQ: return left == right;
+		default: return left != right;
+	}
+}
+
+// every step pops its operands and pushes its result, nothing is kept outside the stack
+static ValueType executeReference(const Pipeline* pipeline, PipelineVariablesSlice variables){
+	PipelineStack stack;
+	initStack(&stack);
+	ValueType args[PIPELINE_STACK_SIZE];
+	for(uint16_t pipelineIdx = 0; pipelineIdx < lengthOfPipeline(pipeline); pipelineIdx++){
+		const PipelineVariant* variant = &pipeline->entries[pipelineIdx];
+		switch (variant->type)
+		{
+			case CONSTANT:
+				pushStack(&stack, variant->asConstant);
+				break;
+			case VARIABLE_INDEX:
+				pushStack(&stack, variables.vars[variant->asVariableIndex].value);
+				break;
+			case OPERATION:
+				for(uint8_t argIdx = variant->asOperationArgCount; argIdx > 0; argIdx--){
+					args[argIdx - 1] = popStack(&stack);
+				}
+				pushStack(&stack, variant->asOperation(args, variant->asOperationArgCount != 0 ? args[variant->asOperationArgCount - 1] : 0));
+				break;
+			case OPERATION_NATIVE_SHL:
+				pushStack(&stack, shiftLeftByConstant(popStack(&stack), &variant->asDivisor));
+				break;
+			case OPERATION_NATIVE_DIV_POW2:
+				pushStack(&stack, divideByPow2Constant(popStack(&stack), &variant->asDivisor));
+				break;
+			case OPERATION_NATIVE_MOD_POW2:
+				pushStack(&stack, moduloByPow2Constant(popStack(&stack), &variant->asDivisor));
+				break;
+			case OPERATION_NATIVE_BOOL:
+				pushStack(&stack, popStack(&stack) != 0);
+				break;
+			case JUMP:
+				pipelineIdx = variant->asJumpTarget - 1;
+				break;
+			case JUMP_IF_ZERO:
+				if(popStack(&stack) == 0){
+					pipelineIdx = variant->asJumpTarget - 1;
+				}
+				break;
+			case JUMP_IF_ZERO_OR_POP:
+			case JUMP_IF_NONZERO_OR_POP:
+				{
+					ValueType condition = popStack(&stack);
+					if((condition != 0) == (variant->type == JUMP_IF_NONZERO_OR_POP)){
+						pushStack(&stack, condition);
+						pipelineIdx = variant->asJumpTarget - 1;
+					}
+				}
+				break;
+			case NONE:
+				return MISSING_VALUE;
+			default:
+				{
+					ValueType right = popStack(&stack);
+					ValueType left = popStack(&stack);
+					pushStack(&stack, applyBinary(variant->type, left, right, &variant->asDivisor));
+				}
+				break;
+		}
+	}
+	return lengthOfStack(&stack) != 0 ? popStack(&stack) : 0;
+}
+
+static void checkCached(const char* text, const Pipeline* pipeline){
+	PipelineVariable variables[] = {{'x', 0}, {'y', 0}};
+	PipelineVariablesSlice slice = MAKE_SLICE_FROM_CONST_PIPELINE_VARIABLES(variables);
+	PipelineStack stack;
+	initStack(&stack);
+	for(ValueType x = -STACK_INPUT_LIMIT; x <= STACK_INPUT_LIMIT; x++){
+		for(ValueType y = -STACK_INPUT_LIMIT; y <= STACK_INPUT_LIMIT; y++){
+			variables[0].value = x;
+			variables[1].value = y;
+			ValueType result = executePipeline(pipeline, &stack, slice);
+			ValueType expected = executeReference(pipeline, slice);
+			if(result != expected || stack.index != NONE_INDEX){
+				printf("%s at x=%d y=%d: %d with stack index %u, reference %d\n", text, x, y, result, stack.index, expected);
+				failures++;
+				return;
+			}
+		}
+	}
+}
+
+int main(int argc, char** argv){
+	uint32_t expressionCount = argc > 1 ? (uint32_t)atoi(argv[1]) : 5000;
+	randomState = argc > 2 ? (uint32_t)atoi(argv[2]) : 0x1234567;
+
+	PipelineVariable variables[] = {{'x', 0}, {'y', 0}};
+	PipelineVariablesSlice slice = MAKE_SLICE_FROM_CONST_PIPELINE_VARIABLES(variables);
+	for(uint32_t expressionIdx = 0; expressionIdx < expressionCount && failures == 0; expressionIdx++){
+		ExpressionText expression = {.length = 0};
+		generateExpression(&expression, &shape, (uint8_t)(nextRandom() % 5) + 1);
+		PipelineVariant storage[NONE_INDEX];
+		Pipeline pipeline = CREATE_PIPELINE_FROM_CONST_STORAGE(storage);
+		if(!compileText(&pipeline, expression.text, slice)){
+			continue;
+		}
+		checkCached(expression.text, &pipeline);
+		strengthReducePipeline(&pipeline);
+		checkCached(expression.text, &pipeline);
+	}
+
+	printf("teststack: %s\n", failures == 0 ? "match" : "MISMATCH");
+	return failures != 0;
+}
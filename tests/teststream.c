@@ -0,0 +1,123 @@
+#include "../include/pipelinestream.h"
+
+#include <stdio.h>
+
+// Checks the history functions of stream expressions against a full history kept by the test,
+// including the zero filled start, and the HISTORY_FULL error when the storage runs out.
+//   teststream
+
+#define STREAM_SAMPLES 64
+
+typedef ValueType (*StreamReference)(const ValueType xs[], const ValueType ys[], const ValueType outs[], int step);
+
+static uint32_t randomState = 0x9E3779B9;
+static int failures;
+
+static uint32_t nextRandom(void){
+	randomState ^= randomState << 13;
+	randomState ^= randomState >> 17;
+	randomState ^= randomState << 5;
+	return randomState;
+}
+
+// value step - samplesAgo of a history, zero before the first sample
+static ValueType ago(const ValueType history[], int step, int samplesAgo){
+	return step - samplesAgo < 0 ? 0 : history[step - samplesAgo];
+}
+
+static ValueType windowSum(const ValueType history[], int step, int length){
+	ValueType sum = 0;
+	for(int samplesAgo = 0; samplesAgo < length; samplesAgo++){
+		sum += ago(history, step, samplesAgo);
+	}
+	return sum;
+}
+
+static ValueType previous(const ValueType xs[], const ValueType ys[], const ValueType outs[], int step){
+	(void)outs;
+	return ago(xs, step, 1) + ago(ys, step, 3);
+}
+
+static ValueType change(const ValueType xs[], const ValueType ys[], const ValueType outs[], int step){
+	(void)ys;
+	(void)outs;
+	return xs[step] - ago(xs, step, 1);
+}
+
+static ValueType windows(const ValueType xs[], const ValueType ys[], const ValueType outs[], int step){
+	(void)outs;
+	return windowSum(xs, step, 4) - windowSum(ys, step, 3) / 3;
+}
+
+static ValueType running(const ValueType xs[], const ValueType ys[], const ValueType outs[], int step){
+	(void)ys;
+	return ago(outs, step, 1) + xs[step];
+}
+
+static ValueType mixed(const ValueType xs[], const ValueType ys[], const ValueType outs[], int step){
+	return (ago(outs, step, 2) > 100 ? 0 : ago(outs, step, 2) * 2) - ago(xs, step, 2) + ys[step] - ago(ys, step, 1);
+}
+
+static void checkStream(const char* text, StreamReference reference){
+	PipelineVariable sampleVariables[] = {{'x', 0}, {'y', 0}};
+	ValueType historyStorage[32];
+	PipelineStream stream;
+	initPipelineStream(&stream, historyStorage, ARRAY_CONST_SIZE(historyStorage));
+	PipelineVariant storage[64];
+	Pipeline pipeline = CREATE_PIPELINE_FROM_CONST_STORAGE(storage);
+	PeekableStringSlice input = {.slice = makeSliceFromString(text), .cursor = 0, .context = NULL};
+	if(compileStreamExpression(&stream, &pipeline, &input, MAKE_SLICE_FROM_CONST_PIPELINE_VARIABLES(sampleVariables)).type != NOERROR){
+		printf("%s: does not compile\n", text);
+		failures++;
+		return;
+	}
+
+	PipelineStack stack;
+	initStack(&stack);
+	ValueType xs[STREAM_SAMPLES];
+	ValueType ys[STREAM_SAMPLES];
+	ValueType outs[STREAM_SAMPLES];
+	for(uint8_t pass = 0; pass < 2; pass++){
+		for(int step = 0; step < STREAM_SAMPLES; step++){
+			xs[step] = (ValueType)(nextRandom() % 41) - 20;
+			ys[step] = (ValueType)(nextRandom() % 41) - 20;
+			ValueType sample[] = {xs[step], ys[step]};
+			outs[step] = stepPipelineStream(&stream, &stack, sample);
+			ValueType expected = reference(xs, ys, outs, step);
+			if(outs[step] != expected){
+				printf("%s at sample %d of pass %u: %d, expected %d\n", text, step, pass, outs[step], expected);
+				failures++;
+				return;
+			}
+		}
+		// the second pass starts from zero filled history again
+		resetPipelineStream(&stream);
+	}
+}
+
+static void checkHistoryFull(const char* text){
+	PipelineVariable sampleVariables[] = {{'x', 0}};
+	ValueType historyStorage[4];
+	PipelineStream stream;
+	initPipelineStream(&stream, historyStorage, ARRAY_CONST_SIZE(historyStorage));
+	PipelineVariant storage[32];
+	Pipeline pipeline = CREATE_PIPELINE_FROM_CONST_STORAGE(storage);
+	PeekableStringSlice input = {.slice = makeSliceFromString(text), .cursor = 0, .context = NULL};
+	if(compileStreamExpression(&stream, &pipeline, &input, MAKE_SLICE_FROM_CONST_PIPELINE_VARIABLES(sampleVariables)).type != HISTORY_FULL){
+		printf("%s: no HISTORY_FULL with 4 samples of history\n", text);
+		failures++;
+	}
+}
+
+int main(void){
+	checkStream("prev(x) + prev(y, 3)", previous);
+	checkStream("delta(x)", change);
+	checkStream("sum(x, 4) - avg(y, 3)", windows);
+	checkStream("out(1) + x", running);
+	checkStream("(out(2) > 100 ? 0 : out(2) * 2) - prev(x, 2) + delta(y)", mixed);
+	checkHistoryFull("prev(x, 5)");
+	checkHistoryFull("avg(x, 3) + out(2)");
+
+	printf("teststream: %s\n", failures == 0 ? "match" : "MISMATCH");
+	return failures != 0;
+}
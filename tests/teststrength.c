@@ -0,0 +1,108 @@
+#include "../include/pipelineoptimizer.h"
+
+#include <stdio.h>
+
+// Checks the strength reduced forms of x * c, x / c and x % c against C arithmetic for every divisor
+// in a small range and at the edges, over dense, edge and random dividends.
+//   teststrength
+
+#define STRENGTH_DENSE_LIMIT 2000
+#define STRENGTH_RANDOM_DIVIDENDS 2000
+
+static uint32_t randomState = 0x2545F491;
+static int failures;
+
+static uint32_t nextRandom(void){
+	randomState ^= randomState << 13;
+	randomState ^= randomState >> 17;
+	randomState ^= randomState << 5;
+	return randomState;
+}
+
+static ValueType expectedResult(PipelineVariantType type, ValueType left, ValueType right){
+	switch (type)
+	{
+		case OPERATION_NATIVE_MUL:
+			return (ValueType)((uint32_t)left * (uint32_t)right);
+		case OPERATION_NATIVE_DIV:
+			return left / right;
+		default:
+			return left % right;
+	}
+}
+
+static void checkStrength(PipelineVariantType type, ValueType constant, const ValueType dividends[], size_t dividendCount){
+	PipelineVariable variables[] = {{'x', 0}};
+	PipelineVariablesSlice slice = MAKE_SLICE_FROM_CONST_PIPELINE_VARIABLES(variables);
+	PipelineVariant storage[4];
+	Pipeline pipeline = CREATE_PIPELINE_FROM_CONST_STORAGE(storage);
+	pushPipeline(&pipeline, makeStepAsVariableIndex(0));
+	pushPipeline(&pipeline, makeStepAsConstant(constant));
+	pushPipeline(&pipeline, (PipelineVariant){.type = type});
+	strengthReducePipeline(&pipeline);
+
+	// the reduction must have happened where reduceStepByConstant offers one
+	PipelineVariant reduced[2];
+	uint8_t reducedCount = reduceStepByConstant(type, constant, reduced);
+	PipelineVariantType reducedType = reducedCount == 0 ? type : reduced[reducedCount - 1].type;
+	if(pipeline.entries[pipeline.index].type != reducedType){
+		printf("x %d with op %u: reduced to op %u, expected %u\n", constant, type, pipeline.entries[pipeline.index].type, reducedType);
+		failures++;
+		return;
+	}
+
+	PipelineStack stack;
+	initStack(&stack);
+	for(size_t idx = 0; idx < dividendCount; idx++){
+		variables[0].value = dividends[idx];
+		ValueType result = executePipeline(&pipeline, &stack, slice);
+		ValueType expected = expectedResult(type, dividends[idx], constant);
+		if(result != expected){
+			printf("%d op %u %d: reduced %d, expected %d\n", dividends[idx], type, constant, result, expected);
+			failures++;
+			return;
+		}
+	}
+}
+
+static void checkConstant(ValueType constant, const ValueType dividends[], size_t dividendCount){
+	checkStrength(OPERATION_NATIVE_MUL, constant, dividends, dividendCount);
+	// 0 and -1 are never reduced and trap natively
+	if(constant == 0 || constant == -1){
+		return;
+	}
+	checkStrength(OPERATION_NATIVE_DIV, constant, dividends, dividendCount);
+	checkStrength(OPERATION_NATIVE_MOD, constant, dividends, dividendCount);
+}
+
+int main(void){
+	static ValueType dividends[2 * STRENGTH_DENSE_LIMIT + 1 + 12 + STRENGTH_RANDOM_DIVIDENDS];
+	size_t dividendCount = 0;
+	for(ValueType value = -STRENGTH_DENSE_LIMIT; value <= STRENGTH_DENSE_LIMIT; value++){
+		dividends[dividendCount++] = value;
+	}
+	static const ValueType edgeValues[] = {
+		INT32_MIN, INT32_MIN + 1, INT32_MAX, INT32_MAX - 1, INT16_MIN, INT16_MAX, INT16_MAX + 1,
+		1 << 30, -(1 << 30), (1 << 30) - 1, 65535, -65536
+	};
+	for(size_t idx = 0; idx < ARRAY_CONST_SIZE(edgeValues); idx++){
+		dividends[dividendCount++] = edgeValues[idx];
+	}
+	for(size_t idx = 0; idx < STRENGTH_RANDOM_DIVIDENDS; idx++){
+		dividends[dividendCount++] = (ValueType)nextRandom();
+	}
+
+	for(ValueType constant = -1000; constant <= 1000; constant++){
+		checkConstant(constant, dividends, dividendCount);
+	}
+	static const ValueType edgeConstants[] = {
+		INT32_MIN, INT32_MIN + 1, INT32_MAX, INT16_MIN, INT16_MIN + 1, INT16_MAX, INT16_MAX + 1, -INT16_MAX - 2,
+		1 << 30, -(1 << 30), 65536, 40009, 641, 6700417, 1000003, -1000003
+	};
+	for(size_t idx = 0; idx < ARRAY_CONST_SIZE(edgeConstants); idx++){
+		checkConstant(edgeConstants[idx], dividends, dividendCount);
+	}
+
+	printf("teststrength: %s\n", failures == 0 ? "match" : "MISMATCH");
+	return failures != 0;
+}